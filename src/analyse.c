@@ -0,0 +1,345 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analyse.h"
+#include "epd.h"
+#include "eval.h"
+#include "search.h"
+#include "thread.h"
+#include "uci.h"
+#include "util.h"
+
+#define AnalyseDefaultDepth 8
+#define AnalyseThreadsMax 64
+
+typedef struct {
+	Depth depth;
+	Score score;
+	Bound bound;
+	Move pv[DepthMax];
+	unsigned int pvLength;
+} AnalyseResult;
+
+typedef struct AnalyseShared AnalyseShared;
+
+typedef struct {
+	AnalyseShared *shared;
+	Search *search; // Each worker searches with its own context.
+	Pos *pos;
+	char *line;
+	size_t lineSize;
+
+	Lock *written; // Posted when output has been written by another worker.
+	bool pending; // Output is waiting for earlier positions to be written first.
+	unsigned int pendingIndex;
+	char *output;
+	size_t outputSize;
+} AnalyseWork;
+
+struct AnalyseShared {
+	FILE *file;
+	TimeMs moveTime;
+	Depth depth;
+	unsigned long long int nodes;
+	bool json;
+
+	Lock *lock; // Protects the fields below, reading from file and writing to stdout.
+	bool finished;
+	unsigned int lineNumber;
+	unsigned int nextIndex, writeIndex; // Counts of positions handed out and written, so output is in input order.
+	AnalyseWork work[AnalyseThreadsMax];
+	unsigned int workCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+void analyseWorker(void *userData);
+bool analyseWorkerNext(AnalyseWork *work, unsigned int *lineNumber, unsigned int *index); // Reads next position to analyse into work->line.
+void analyseWorkerLine(AnalyseWork *work, FILE *out, unsigned int lineNumber);
+void analyseWorkerOutput(AnalyseWork *work, unsigned int index); // Returns only once the output has been written.
+
+void analyseDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time);
+
+void analyseWrite(FILE *out, Pos *pos, const Epd *epd, unsigned int lineNumber, const AnalyseResult *result, unsigned long long int nodes, TimeMs time, bool json);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void analyseArgs(unsigned int argc, char **argv) {
+	// Parse arguments.
+	const char *path=NULL;
+	TimeMs moveTime=TimeMsInvalid;
+	Depth depth=DepthInvalid;
+	unsigned long long int nodes=0;
+	unsigned int threads=1;
+	bool json=false;
+	for(unsigned int i=0;i<argc;++i) {
+		if (utilStrEqual(argv[i], "json"))
+			json=true;
+		else if (i+1<argc && utilStrEqual(argv[i], "file"))
+			path=argv[++i];
+		else if (i+1<argc && utilStrEqual(argv[i], "movetime"))
+			moveTime=atoll(argv[++i]);
+		else if (i+1<argc && utilStrEqual(argv[i], "depth"))
+			depth=utilMin(atoi(argv[++i]), DepthMax-1);
+		else if (i+1<argc && utilStrEqual(argv[i], "nodes"))
+			nodes=atoll(argv[++i]);
+		else if (i+1<argc && utilStrEqual(argv[i], "threads"))
+			threads=atoi(argv[++i]);
+	}
+	if (moveTime==TimeMsInvalid && depth==DepthInvalid && nodes==0)
+		depth=AnalyseDefaultDepth;
+
+	// Open input and analyse.
+	FILE *file=stdin;
+	if (path!=NULL && (file=fopen(path, "r"))==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", path);
+		return;
+	}
+	analyse(file, moveTime, depth, nodes, threads, json);
+	if (file!=stdin)
+		fclose(file);
+}
+
+void analyse(FILE *file, TimeMs moveTime, Depth depth, unsigned long long int nodes, unsigned int threads, bool json) {
+	threads=utilMax(1u, utilMin(threads, (unsigned int)AnalyseThreadsMax));
+
+	AnalyseShared *shared=malloc(sizeof(AnalyseShared));
+	if (shared==NULL) {
+		uciWrite("Error: Out of memory.\n");
+		return;
+	}
+	memset(shared, 0, sizeof(AnalyseShared));
+	shared->file=file;
+	shared->moveTime=moveTime;
+	shared->depth=depth;
+	shared->nodes=nodes;
+	shared->json=json;
+
+	// Create a search context and position for each worker.
+	if ((shared->lock=lockNew(1))==NULL) {
+		uciWrite("Error: Out of memory.\n");
+		free(shared);
+		return;
+	}
+	for(shared->workCount=0;shared->workCount<threads;++shared->workCount) {
+		AnalyseWork *work=&shared->work[shared->workCount];
+		work->shared=shared;
+		work->search=searchNew();
+		work->pos=posNew(NULL);
+		work->written=lockNew(0);
+		if (work->search==NULL || work->pos==NULL || work->written==NULL) {
+			searchFree(work->search);
+			if (work->pos!=NULL)
+				posFree(work->pos);
+			lockFree(work->written);
+			break;
+		}
+	}
+	if (shared->workCount==0)
+		uciWrite("Error: Could not allocate search.\n");
+	else if (shared->workCount<threads)
+		uciWrite("Error: Could only allocate %u of %u searches.\n", shared->workCount, threads);
+
+	// Analyse positions in parallel.
+	Thread *workers[AnalyseThreadsMax];
+	for(unsigned int i=0;i<shared->workCount;++i) {
+		workers[i]=threadNew();
+		if (workers[i]==NULL)
+			analyseWorker(&shared->work[i]);
+		else
+			threadRun(workers[i], &analyseWorker, &shared->work[i]);
+	}
+
+	// Wait and clean up.
+	for(unsigned int i=0;i<shared->workCount;++i) {
+		threadFree(workers[i]); // Waits for the thread to finish.
+		AnalyseWork *work=&shared->work[i];
+		free(work->line);
+		searchFree(work->search);
+		posFree(work->pos);
+		lockFree(work->written);
+	}
+	lockFree(shared->lock);
+	free(shared);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void analyseWorker(void *userData) {
+	AnalyseWork *work=(AnalyseWork *)userData;
+
+	unsigned int lineNumber, index;
+	while(analyseWorkerNext(work, &lineNumber, &index)) {
+		// Analyse into a buffer, then write it once all earlier positions have been written.
+		FILE *out=open_memstream(&work->output, &work->outputSize);
+		if (out==NULL) {
+			lockWait(work->shared->lock);
+			uciWrite("Error: Out of memory.\n");
+			lockPost(work->shared->lock);
+		} else {
+			analyseWorkerLine(work, out, lineNumber);
+			fclose(out);
+		}
+		analyseWorkerOutput(work, index);
+		free(work->output);
+		work->output=NULL;
+		work->outputSize=0;
+	}
+}
+
+bool analyseWorkerNext(AnalyseWork *work, unsigned int *lineNumber, unsigned int *index) {
+	AnalyseShared *shared=work->shared;
+	lockWait(shared->lock);
+
+	bool found=false;
+	while(!shared->finished) {
+		if (getline(&work->line, &work->lineSize, shared->file)<0) {
+			shared->finished=true;
+			break;
+		}
+		++shared->lineNumber;
+
+		// Blank line ends input (so a stream can be given via the UCI loop), comments are skipped.
+		const char *c=work->line+strspn(work->line, " \t\r\n");
+		if (*c=='\0') {
+			shared->finished=true;
+			break;
+		}
+		if (*c=='#')
+			continue;
+
+		*lineNumber=shared->lineNumber;
+		*index=shared->nextIndex++;
+		found=true;
+		break;
+	}
+
+	lockPost(shared->lock);
+	return found;
+}
+
+void analyseWorkerLine(AnalyseWork *work, FILE *out, unsigned int lineNumber) {
+	const AnalyseShared *shared=work->shared;
+	char *c=work->line+strspn(work->line, " \t\r\n");
+
+	Epd epd;
+	if (!epdParse(c, work->pos, &epd)) {
+		if (shared->json) {
+			fprintf(out, "{\"line\":%u,\"error\":", lineNumber);
+			c[strcspn(c, "\r\n")]='\0';
+			utilJsonString(out, c);
+			fprintf(out, "}\n");
+		} else
+			fprintf(out, "%u error bad fen '%.*s'\n", lineNumber, (int)strcspn(c, "\r\n"), c);
+		return;
+	}
+
+	// Search from a clean state, so that results do not depend on which worker analysed which positions.
+	AnalyseResult result={.depth=0, .pvLength=0};
+	searchClear(work->search);
+	SearchLimit limit;
+	searchLimitInit(&limit, timeGet());
+	if (shared->moveTime!=TimeMsInvalid)
+		searchLimitSetMoveTime(&limit, shared->moveTime);
+	if (shared->depth!=DepthInvalid)
+		searchLimitSetDepth(&limit, shared->depth);
+	if (shared->nodes>0)
+		searchLimitSetNodes(&limit, shared->nodes);
+	TimeMs time=timeGet();
+	searchRun(work->search, work->pos, &limit, &analyseDepthCallback, &result);
+	time=timeGet()-time;
+
+	analyseWrite(out, work->pos, &epd, lineNumber, &result, searchGetNodeCount(work->search), time, shared->json);
+}
+
+void analyseWorkerOutput(AnalyseWork *work, unsigned int index) {
+	AnalyseShared *shared=work->shared;
+	lockWait(shared->lock);
+
+	// Write any outputs which are now next in line (this one may allow those of other waiting workers to follow).
+	work->pending=true;
+	work->pendingIndex=index;
+	bool found;
+	do {
+		found=false;
+		for(unsigned int i=0;i<shared->workCount;++i) {
+			AnalyseWork *other=&shared->work[i];
+			if (!other->pending || other->pendingIndex!=shared->writeIndex)
+				continue;
+			if (other->output!=NULL)
+				fwrite(other->output, 1, other->outputSize, stdout);
+			other->pending=false;
+			++shared->writeIndex;
+			found=true;
+			if (other!=work)
+				lockPost(other->written);
+		}
+	} while(found);
+	bool wait=work->pending;
+
+	lockPost(shared->lock);
+
+	if (wait)
+		lockWait(work->written);
+}
+
+void analyseDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time) {
+	AnalyseResult *result=(AnalyseResult *)userData;
+	result->depth=depth;
+	result->score=score;
+	result->bound=bound;
+	memcpy(result->pv, pv, pvLength*sizeof(Move));
+	result->pvLength=pvLength;
+}
+
+void analyseWrite(FILE *out, Pos *pos, const Epd *epd, unsigned int lineNumber, const AnalyseResult *result, unsigned long long int nodes, TimeMs time, bool json) {
+	// No iteration completed (e.g. mate/stalemate, or tiny limit)?
+	if (result->pvLength==0) {
+		if (json)
+			fprintf(out, "{\"line\":%u,\"bestmove\":null,\"nodes\":%llu,\"time\":%llu}\n", lineNumber, nodes, time);
+		else
+			fprintf(out, "%u bestmove 0000 nodes %llu time %llu\n", lineNumber, nodes, time);
+		return;
+	}
+
+	// Header.
+	if (json) {
+		fprintf(out, "{\"line\":%u,", lineNumber);
+		if (epd->id[0]!='\0') {
+			fprintf(out, "\"id\":");
+			utilJsonString(out, epd->id);
+			fprintf(out, ",");
+		}
+		fprintf(out, "\"bestmove\":\"%s\",\"score\":\"%s\",\"depth\":%u,\"nodes\":%llu,\"time\":%llu,\"pv\":[",
+		        POSMOVETOSTR(pos, result->pv[0]), SCORETOSTR(result->score, result->bound), (unsigned int)result->depth, nodes, time);
+	} else {
+		fprintf(out, "%u", lineNumber);
+		if (epd->id[0]!='\0')
+			fprintf(out, " id %s", epd->id);
+		fprintf(out, " bestmove %s score %s depth %u nodes %llu time %llu pv", POSMOVETOSTR(pos, result->pv[0]), SCORETOSTR(result->score, result->bound),
+		        (unsigned int)result->depth, nodes, time);
+	}
+
+	// PV (making the moves so each can be converted to a string in its own position).
+	unsigned int ply;
+	for(ply=0;ply<result->pvLength;++ply) {
+		char str[8];
+		posMoveToStr(pos, result->pv[ply], str);
+		if (!posMakeMove(pos, result->pv[ply]))
+			break;
+		if (json)
+			fprintf(out, "%s\"%s\"", (ply>0 ? "," : ""), str);
+		else
+			fprintf(out, " %s", str);
+	}
+	for(;ply>0;--ply)
+		posUndoMove(pos);
+	fprintf(out, json ? "]}\n" : "\n");
+}
@@ -0,0 +1,17 @@
+#ifndef ANALYSE_H
+#define ANALYSE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "depth.h"
+#include "time.h"
+
+// Searches each FEN/EPD line read from file with the given limit (moveTime/depth/nodes of TimeMsInvalid/DepthInvalid/0 for
+// no limit) until end of file or a blank line, writing one result line per position (as JSON objects if json is set).
+// Positions are shared between the given number of threads, each with its own search context (using the UCI engine's
+// Hash size), while results are still written in input order.
+void analyseArgs(unsigned int argc, char **argv); // Parses '[file F] [movetime T|depth D|nodes N] [threads N] [json]' (reading stdin if no file, and defaulting to a fixed depth and one thread) then calls analyse().
+void analyse(FILE *file, TimeMs moveTime, Depth depth, unsigned long long int nodes, unsigned int threads, bool json);
+
+#endif
@@ -1,12 +1,67 @@
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
+#ifdef ATTACKSPEXT
+#ifndef __BMI2__
+#	error PEXT slider attacks need a BMI2 target (see ATTACKS in the Makefile)
+#endif
+#include <immintrin.h>
+#endif
 
 #include "attacks.h"
 #include "magicmoves.h"
+#include "tables.h"
 
+#ifdef TABLES
+extern const BB attacksArrayKnight[SqNB], attacksArrayKing[SqNB]; // See tables.c.
+#else
 BB attacksArrayKnight[SqNB], attacksArrayKing[SqNB];
+#endif
+
+#ifdef ATTACKSPEXT
+// Slider attacks indexed by PEXT of the occupancy (using the magic masks).
+// Each square has its own slice of the database, starting at the given offset.
+// If ATTACKSPEXT16 is defined entries are stored compressed: any attack set is
+// a subset of the attacks on an empty board (the 'line', at most 14 bits), so
+// PEXT by the line packs it into 16 bits and PDEP restores it. This cuts the
+// databases from 841kb to 210kb at the cost of one PDEP per lookup.
+#ifdef ATTACKSPEXT16
+typedef uint16_t AttacksPextEntry;
+#else
+typedef BB AttacksPextEntry;
+#endif
+
+#ifdef TABLES
+extern const AttacksPextEntry attacksPextBishopDB[5248], attacksPextRookDB[102400]; // See tables.c.
+extern const unsigned attacksPextBishopOffset[SqNB], attacksPextRookOffset[SqNB];
+extern const BB attacksPextBishopLine[SqNB], attacksPextRookLine[SqNB];
+#else
+AttacksPextEntry attacksPextBishopDB[5248], attacksPextRookDB[102400];
+unsigned attacksPextBishopOffset[SqNB], attacksPextRookOffset[SqNB];
+BB attacksPextBishopLine[SqNB], attacksPextRookLine[SqNB];
+#endif
+
+#ifdef ATTACKSPEXT16
+#	define attacksPextDecode(entry, line) _pdep_u64((entry), (line))
+#else
+#	define attacksPextDecode(entry, line) (entry)
+#endif
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(ATTACKSPEXT) && !defined(TABLES)
+void attacksInitPext(AttacksPextEntry *db, unsigned *offsets, BB *lines, const U64 *masks, bool rook); // Fills PEXT database from the magic one.
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
 
 void attacksInit(void) {
+#	ifndef TABLES
 	// Attack arrays for knight and king.
 	Sq from, to;
 	for(from=0;from<SqNB;++from) {
@@ -24,6 +79,13 @@ void attacksInit(void) {
 
 	// Magic move generation for sliders.
 	initmagicmoves();
+
+	// PEXT databases.
+#	ifdef ATTACKSPEXT
+	attacksInitPext(attacksPextBishopDB, attacksPextBishopOffset, attacksPextBishopLine, magicmoves_b_mask, false);
+	attacksInitPext(attacksPextRookDB, attacksPextRookOffset, attacksPextRookLine, magicmoves_r_mask, true);
+#	endif
+#	endif
 }
 
 BB attacksPawn(Sq sq, Colour colour) {
@@ -38,17 +100,25 @@ BB attacksKnight(Sq sq) {
 
 BB attacksBishop(Sq sq, BB occ) {
 	assert(sqIsValid(sq));
+#	ifdef ATTACKSPEXT
+	return attacksPextDecode(attacksPextBishopDB[attacksPextBishopOffset[sq]+_pext_u64(occ, magicmoves_b_mask[sq])], attacksPextBishopLine[sq]);
+#	else
 	return Bmagic(sq, occ);
+#	endif
 }
 
 BB attacksRook(Sq sq, BB occ) {
 	assert(sqIsValid(sq));
+#	ifdef ATTACKSPEXT
+	return attacksPextDecode(attacksPextRookDB[attacksPextRookOffset[sq]+_pext_u64(occ, magicmoves_r_mask[sq])], attacksPextRookLine[sq]);
+#	else
 	return Rmagic(sq, occ);
+#	endif
 }
 
 BB attacksQueen(Sq sq, BB occ) {
 	assert(sqIsValid(sq));
-	return (Bmagic(sq, occ)|Rmagic(sq, occ));
+	return (attacksBishop(sq, occ)|attacksRook(sq, occ));
 }
 
 BB attacksKing(Sq sq) {
@@ -86,3 +156,50 @@ BB attacksPieceType(PieceType type, Sq sq, BB occ) {
 		default: assert(false); return BBNone; break;
 	}
 }
+
+bool attacksHasPext(void) {
+#	ifdef ATTACKSPEXT
+	return true;
+#	else
+	return false;
+#	endif
+}
+
+size_t attacksSliderTableSize(void) {
+#	ifdef ATTACKSPEXT
+	return sizeof(attacksPextBishopDB)+sizeof(attacksPextRookDB);
+#	else
+	return (5248+102400)*sizeof(U64);
+#	endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(ATTACKSPEXT) && !defined(TABLES)
+void attacksInitPext(AttacksPextEntry *db, unsigned *offsets, BB *lines, const U64 *masks, bool rook) {
+	unsigned offset=0;
+	Sq sq;
+	for(sq=0;sq<SqNB;++sq) {
+		offsets[sq]=offset;
+		lines[sq]=(rook ? Rmagic(sq, BBNone) : Bmagic(sq, BBNone));
+
+		// Loop over all subsets of the mask (Carry-Rippler).
+		BB occ=BBNone;
+		do {
+			BB attacks=(rook ? Rmagic(sq, occ) : Bmagic(sq, occ));
+#			ifdef ATTACKSPEXT16
+			assert(bbPopCount(lines[sq])<=16);
+			db[offset+_pext_u64(occ, masks[sq])]=_pext_u64(attacks, lines[sq]);
+#			else
+			db[offset+_pext_u64(occ, masks[sq])]=attacks;
+#			endif
+			occ=((occ-masks[sq]) & masks[sq]);
+		} while(occ!=BBNone);
+
+		offset+=(1u<<bbPopCount(masks[sq]));
+	}
+	assert(offset==(rook ? 102400 : 5248));
+}
+#endif
@@ -1,6 +1,9 @@
 #ifndef ATTACKS_H
 #define ATTACKS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "bb.h"
 #include "colour.h"
 #include "piece.h"
@@ -18,4 +21,7 @@ BB attacksKing(Sq sq);
 BB attacksPiece(Piece piece, Sq sq, BB occ);
 BB attacksPieceType(PieceType type, Sq sq, BB occ); // As this is colour-agnostic pawns are not supported.
 
+bool attacksHasPext(void); // True if slider attacks use the PEXT (BMI2) tables rather than magic multiplication, selected by ATTACKS in the Makefile.
+size_t attacksSliderTableSize(void); // Size in bytes of the bishop and rook attack databases.
+
 #endif
@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include "bb.h"
+#include "tables.h"
 #include "uci.h"
 #include "util.h"
 
@@ -11,7 +12,11 @@ const BB BBLight=0x55AA55AA55AA55AAllu, BBDark=0xAA55AA55AA55AA55llu;
 
 const BB BBFileA=0x0101010101010101llu, BBRank1=0x00000000000000FFllu;
 
-BB BBPawnSq[64];
+#ifdef TABLES
+extern const BB BBPawnSq[SqNB]; // See tables.c.
+#else
+BB BBPawnSq[SqNB];
+#endif
 
 const unsigned int BBScanForwardTable[64]={
 	 0, 47,  1, 56, 48, 27,  2, 60,
@@ -24,9 +29,14 @@ const unsigned int BBScanForwardTable[64]={
 	13, 18,  8, 12,  7,  6,  5, 63
 };
 
+#ifdef TABLES
+extern const BB BBBetween[SqNB][SqNB], BBBeyond[SqNB][SqNB]; // See tables.c.
+#else
 BB BBBetween[SqNB][SqNB], BBBeyond[SqNB][SqNB];
+#endif
 
 void bbInit(void) {
+#	ifndef TABLES
 	// BBBetween and BBBeyond arrays.
 	// Note: The code below uses 0x88 coordinates.
 #	define TOSQ(s) (sqMake(((s)&0xF0)>>4 , ((s)&0x07)))
@@ -72,6 +82,7 @@ void bbInit(void) {
 				if (abs(f1-f2)<=7-r1 && r2>=r1)
 					BBPawnSq[sqA]|=bbSq(sqMake(f2,r2));
 		}
+#	endif
 }
 
 void bbDraw(BB bb) {
@@ -1,47 +1,356 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "benchmark.h"
 #include "depth.h"
 #include "eval.h"
 #include "search.h"
+#include "time.h"
+#include "thread.h"
+#include "tt.h"
+#include "util.h"
+
+typedef struct {
+	const char *fen;
+	Depth depth;
+} BenchmarkPosition;
+
+const BenchmarkPosition benchmarkPositions[]={
+	{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 9},
+	{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 8},
+	{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 11},
+	{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 9},
+	{"rnbqkb1r/pp1p1ppp/2p5/4P3/2B5/8/PPP1NnPP/RNBQK2R w KQkq - 0 6", 8},
+	{"r1bq1rk1/pppnnppp/4p3/3pP3/1b1P4/2NB3N/PPP2PPP/R1BQK2R w KQ - 3 7", 8},
+	{"rnb3nr/ppq2kpp/4pp2/1B1pP3/P5Q1/B1p2N2/2P2PPP/R4RK1 w - - 0 1", 7},
+	{"3B4/1r2p3/r2p1p2/bkp1P1p1/1p1P1PPp/p1P1K2P/PPB5/8 w - - 0 1", 10},
+};
+#define BenchmarkPositionsNB (sizeof(benchmarkPositions)/sizeof(benchmarkPositions[0]))
+
+#define BenchmarkFileDepth 8 // Default depth for positions read from a file.
+#define BenchmarkFenMax 128
+#define BenchmarkThreadsMax 64
+
+typedef struct {
+	Search *search; // Each worker searches with its own context.
+	const BenchmarkPosition *positions;
+	unsigned count, first, stride; // Searches positions first, first+stride, ... (so the same ones every run, keeping node counts deterministic).
+	Depth depth; // 0 uses each position's default depth.
+	unsigned long long int *nodes; // Node count for each position searched this run.
+	double *times; // Seconds taken for each position searched this run.
+} BenchmarkWork;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private prototypes.
 ////////////////////////////////////////////////////////////////////////////////
 
-unsigned long long int benchmarkFen(const char *fen, Depth depth);
+unsigned long long int benchmarkFen(Search *search, const char *fen, Depth depth);
+void benchmarkWorker(void *userData);
+
+BenchmarkPosition *benchmarkReadFile(const char *path, unsigned *count); // Returns NULL on failure, otherwise list should be freed by caller (along with each fen).
+double benchmarkMedian(double *values, unsigned count); // Reorders values.
+void benchmarkMeanStddev(const double *values, unsigned count, double *mean, double *stddev); // Sample standard deviation.
+uint64_t benchmarkSignature(uint64_t signature, unsigned long long int nodes);
 
 ////////////////////////////////////////////////////////////////////////////////
 // Public functions.
 ////////////////////////////////////////////////////////////////////////////////
 
 unsigned long long int benchmark(void) {
-	searchClear();
-	evalClear();
+	// The UCI engine's context is used, so make sure it is not still searching.
+	searchStopAndWait();
+	searchClear(searchGetMain());
 
 	unsigned long long int nodes=0;
-	nodes+=benchmarkFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 9);
-	nodes+=benchmarkFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 8);
-	nodes+=benchmarkFen("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 11);
-	nodes+=benchmarkFen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 9);
-	nodes+=benchmarkFen("rnbqkb1r/pp1p1ppp/2p5/4P3/2B5/8/PPP1NnPP/RNBQK2R w KQkq - 0 6", 8);
-	nodes+=benchmarkFen("r1bq1rk1/pppnnppp/4p3/3pP3/1b1P4/2NB3N/PPP2PPP/R1BQK2R w KQ - 3 7", 8);
-	nodes+=benchmarkFen("rnb3nr/ppq2kpp/4pp2/1B1pP3/P5Q1/B1p2N2/2P2PPP/R4RK1 w - - 0 1", 7);
-	nodes+=benchmarkFen("3B4/1r2p3/r2p1p2/bkp1P1p1/1p1P1PPp/p1P1K2P/PPB5/8 w - - 0 1", 10);
+	for(unsigned i=0; i<BenchmarkPositionsNB; ++i)
+		nodes+=benchmarkFen(searchGetMain(), benchmarkPositions[i].fen, benchmarkPositions[i].depth);
 
 	return nodes;
 }
 
+void benchmarkBench(Depth depth, unsigned int hashMb, const char *path, unsigned int repeat, unsigned int threads, bool json) {
+	if (repeat<1)
+		repeat=1;
+	threads=utilMax(1u, utilMin(threads, (unsigned int)BenchmarkThreadsMax));
+
+	// Find positions.
+	const BenchmarkPosition *positions=benchmarkPositions;
+	BenchmarkPosition *filePositions=NULL;
+	unsigned count=BenchmarkPositionsNB;
+	if (path!=NULL) {
+		if ((filePositions=benchmarkReadFile(path, &count))==NULL) {
+			printf("Error: Could not read positions from '%s'.\n", path);
+			return;
+		}
+		positions=filePositions;
+	}
+	threads=utilMin(threads, count);
+
+	// Set hash size (restored at the end).
+	searchStopAndWait();
+	TT *tt=searchGetTT(searchGetMain());
+	unsigned int oldHashMb=ttGetSizeMb(tt);
+	if (hashMb>0 && !ttResize(tt, hashMb)) {
+		printf("Error: Could not resize hash to %umb.\n", hashMb);
+		hashMb=0;
+	}
+
+	// The first worker uses the UCI engine's context, any others get their own (with the same hash size).
+	BenchmarkWork work[BenchmarkThreadsMax];
+	Thread *workers[BenchmarkThreadsMax];
+	unsigned workCount;
+	for(workCount=0; workCount<threads; ++workCount) {
+		Search *search=searchGetMain();
+		if (workCount>0) {
+			char hashStr[16];
+			sprintf(hashStr, "%u", ttGetSizeMb(tt));
+			if ((search=searchNew())==NULL || !searchSetOption(search, "Hash", hashStr)) {
+				searchFree(search);
+				printf("Error: Could only allocate %u of %u searches.\n", workCount, threads);
+				break;
+			}
+		}
+		work[workCount].search=search;
+		workers[workCount]=(workCount>0 ? threadNew() : NULL); // The first worker runs on this thread.
+	}
+	threads=workCount;
+
+	// Run each repeat from a clean state, so that node counts are deterministic.
+	unsigned long long int *nodes=malloc(count*sizeof(unsigned long long int));
+	unsigned long long int *posNodes=malloc(count*sizeof(unsigned long long int));
+	double *times=malloc(count*repeat*sizeof(double)); // Seconds, indexed [position*repeat+run].
+	double *posTimes=malloc(count*sizeof(double));
+	double *runNps=malloc(repeat*sizeof(double));
+	double *scratch=malloc(utilMax(count, repeat)*sizeof(double));
+	if (nodes==NULL || posNodes==NULL || times==NULL || posTimes==NULL || runNps==NULL || scratch==NULL) {
+		printf("Error: Out of memory.\n");
+		goto cleanup;
+	}
+	for(unsigned i=0; i<threads; ++i) {
+		work[i].positions=positions;
+		work[i].count=count;
+		work[i].first=i;
+		work[i].stride=threads;
+		work[i].depth=depth;
+		work[i].nodes=posNodes;
+		work[i].times=posTimes;
+	}
+	bool deterministic=true;
+	for(unsigned run=0; run<repeat; ++run) {
+		for(unsigned i=0; i<threads; ++i)
+			searchClear(work[i].search);
+
+		// Search positions in parallel (with a single thread the total time is simply the sum of the search times).
+		TimeUs runTime=timeGetUs();
+		for(unsigned i=1; i<threads; ++i) {
+			if (workers[i]==NULL)
+				benchmarkWorker(&work[i]);
+			else
+				threadRun(workers[i], &benchmarkWorker, &work[i]);
+		}
+		benchmarkWorker(&work[0]);
+		for(unsigned i=1; i<threads; ++i)
+			if (workers[i]!=NULL)
+				threadWaitReady(workers[i]);
+		runTime=timeGetUs()-runTime;
+
+		unsigned long long int runNodes=0;
+		for(unsigned i=0; i<count; ++i) {
+			if (run==0)
+				nodes[i]=posNodes[i];
+			else if (nodes[i]!=posNodes[i])
+				deterministic=false;
+			times[i*repeat+run]=posTimes[i];
+			runNodes+=posNodes[i];
+		}
+		runNps[run]=(runTime>0 ? runNodes/(runTime/1e6) : 0.0);
+	}
+
+	// Summary statistics.
+	unsigned long long int totalNodes=0;
+	uint64_t signature=0xCBF29CE484222325llu; // FNV-1a offset basis.
+	for(unsigned i=0; i<count; ++i) {
+		totalNodes+=nodes[i];
+		signature=benchmarkSignature(signature, nodes[i]);
+	}
+	double npsMean, npsStddev;
+	benchmarkMeanStddev(runNps, repeat, &npsMean, &npsStddev);
+	memcpy(scratch, runNps, repeat*sizeof(double));
+	double npsMedian=benchmarkMedian(scratch, repeat);
+	double npsMin=runNps[0], npsMax=runNps[0];
+	for(unsigned run=1; run<repeat; ++run) {
+		npsMin=utilMin(npsMin, runNps[run]);
+		npsMax=utilMax(npsMax, runNps[run]);
+	}
+
+	// Report (times are the median over repeats).
+	if (json) {
+		printf("{\"positions\":[");
+		for(unsigned i=0; i<count; ++i) {
+			memcpy(scratch, times+i*repeat, repeat*sizeof(double));
+			double time=benchmarkMedian(scratch, repeat);
+			printf("%s{\"fen\":", (i>0 ? "," : ""));
+			utilJsonString(stdout, positions[i].fen);
+			printf(",\"depth\":%u,\"nodes\":%llu,\"time\":%.6f,\"nps\":%.0f,\"times\":[", (unsigned)(depth>0 ? depth : positions[i].depth),
+			       nodes[i], time, (time>0.0 ? nodes[i]/time : 0.0));
+			for(unsigned run=0; run<repeat; ++run)
+				printf("%s%.6f", (run>0 ? "," : ""), times[i*repeat+run]);
+			printf("]}");
+		}
+		printf("],\"repeat\":%u,\"threads\":%u,\"hash\":%u,\"nodes\":%llu,\"signature\":\"%016llX\",\"deterministic\":%s,", repeat, threads, ttGetSizeMb(tt),
+		       totalNodes, (unsigned long long int)signature, (deterministic ? "true" : "false"));
+		printf("\"nps\":{\"mean\":%.0f,\"median\":%.0f,\"stddev\":%.0f,\"min\":%.0f,\"max\":%.0f,\"runs\":[", npsMean, npsMedian, npsStddev, npsMin, npsMax);
+		for(unsigned run=0; run<repeat; ++run)
+			printf("%s%.0f", (run>0 ? "," : ""), runNps[run]);
+		printf("]}}\n");
+	} else {
+		printf("%3s %5s %12s %10s %12s  %s\n", "#", "depth", "nodes", "time", "nps", "fen");
+		for(unsigned i=0; i<count; ++i) {
+			memcpy(scratch, times+i*repeat, repeat*sizeof(double));
+			double time=benchmarkMedian(scratch, repeat);
+			printf("%3u %5u %12llu %9.3fs %12.0f  %s\n", i+1, (unsigned)(depth>0 ? depth : positions[i].depth), nodes[i], time,
+			       (time>0.0 ? nodes[i]/time : 0.0), positions[i].fen);
+		}
+		printf("positions %u repeat %u threads %u hash %umb\n", count, repeat, threads, ttGetSizeMb(tt));
+		printf("nodes %llu signature %016llX%s\n", totalNodes, (unsigned long long int)signature, (deterministic ? "" : " (warning: node counts varied between repeats)"));
+		printf("nps mean %.0f median %.0f stddev %.0f (%.1f%%) min %.0f max %.0f\n", npsMean, npsMedian, npsStddev,
+		       (npsMean>0.0 ? (100.0*npsStddev)/npsMean : 0.0), npsMin, npsMax);
+	}
+
+	cleanup:
+	for(unsigned i=1; i<threads; ++i) {
+		if (workers[i]!=NULL)
+			threadFree(workers[i]);
+		searchFree(work[i].search);
+	}
+	free(nodes);
+	free(posNodes);
+	free(times);
+	free(posTimes);
+	free(runNps);
+	free(scratch);
+	if (filePositions!=NULL) {
+		for(unsigned i=0; i<count; ++i)
+			free((char *)filePositions[i].fen);
+		free(filePositions);
+	}
+	if (hashMb>0)
+		ttResize(tt, oldHashMb);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Private functions
 ////////////////////////////////////////////////////////////////////////////////
 
-unsigned long long int benchmarkFen(const char *fen, Depth depth) {
-	Pos *pos=posNew(fen);
-	if (pos==NULL)
+unsigned long long int benchmarkFen(Search *search, const char *fen, Depth depth) {
+	Pos pos;
+	if (!posInitInPlace(&pos, fen))
 		return 0;
 
-	unsigned long long int nodes=searchBenchmark(pos, depth);
+	return searchBenchmark(search, &pos, depth);
+}
 
-	posFree(pos);
+void benchmarkWorker(void *userData) {
+	BenchmarkWork *work=(BenchmarkWork *)userData;
+	for(unsigned i=work->first; i<work->count; i+=work->stride) {
+		TimeUs t=timeGetUs();
+		work->nodes[i]=benchmarkFen(work->search, work->positions[i].fen, (work->depth>0 ? work->depth : work->positions[i].depth));
+		work->times[i]=(timeGetUs()-t)/1e6;
+	}
+}
 
-	return nodes;
+BenchmarkPosition *benchmarkReadFile(const char *path, unsigned *count) {
+	FILE *file=fopen(path, "r");
+	if (file==NULL)
+		return NULL;
+
+	// One FEN per line, anything after a ';' (e.g. EPD opcodes) is ignored.
+	BenchmarkPosition *positions=NULL;
+	*count=0;
+	char *line=NULL;
+	size_t lineSize=0;
+	while(getline(&line, &lineSize, file)>=0) {
+		// Skip blank lines and comments.
+		char *fen=line+strspn(line, " \t\r\n");
+		if (*fen=='\0' || *fen=='#')
+			continue;
+		fen[strcspn(fen, ";\r\n")]='\0';
+
+		// Check FEN is valid.
+		Pos pos;
+		if (strlen(fen)>=BenchmarkFenMax || !posInitInPlace(&pos, fen)) {
+			printf("Warning: Skipping invalid FEN '%s'.\n", fen);
+			continue;
+		}
+
+		// Add to list.
+		BenchmarkPosition *newPositions=realloc(positions, (*count+1)*sizeof(BenchmarkPosition));
+		char *fenCopy=malloc(strlen(fen)+1);
+		if (newPositions!=NULL)
+			positions=newPositions;
+		if (newPositions==NULL || fenCopy==NULL) {
+			// Out of memory - fail rather than silently benchmarking a partial list.
+			printf("Error: Out of memory.\n");
+			free(fenCopy);
+			for(unsigned i=0; i<*count; ++i)
+				free((char *)positions[i].fen);
+			*count=0;
+			break;
+		}
+		strcpy(fenCopy, fen);
+		positions[*count].fen=fenCopy;
+		positions[*count].depth=BenchmarkFileDepth;
+		++*count;
+	}
+	free(line);
+	fclose(file);
+
+	// No positions?
+	if (*count==0) {
+		free(positions);
+		return NULL;
+	}
+
+	return positions;
+}
+
+double benchmarkMedian(double *values, unsigned count) {
+	assert(count>0);
+
+	// Insertion sort (lists are short).
+	for(unsigned i=1; i<count; ++i) {
+		double temp=values[i];
+		unsigned j;
+		for(j=i; j>0 && values[j-1]>temp; --j)
+			values[j]=values[j-1];
+		values[j]=temp;
+	}
+
+	return (count%2 ? values[count/2] : (values[count/2-1]+values[count/2])/2);
+}
+
+void benchmarkMeanStddev(const double *values, unsigned count, double *mean, double *stddev) {
+	assert(count>0);
+
+	double sum=0.0;
+	for(unsigned i=0; i<count; ++i)
+		sum+=values[i];
+	*mean=sum/count;
+
+	double sumSq=0.0;
+	for(unsigned i=0; i<count; ++i)
+		sumSq+=(values[i]-*mean)*(values[i]-*mean);
+	*stddev=(count>1 ? sqrt(sumSq/(count-1)) : 0.0);
+}
+
+uint64_t benchmarkSignature(uint64_t signature, unsigned long long int nodes) {
+	// FNV-1a over the bytes of each node count, so that search changes which only move nodes between positions still change the signature.
+	for(unsigned i=0; i<8; ++i) {
+		signature^=((nodes>>(8*i)) & 0xFF);
+		signature*=0x100000001B3llu;
+	}
+	return signature;
 }
@@ -1,6 +1,16 @@
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
+#include <stdbool.h>
+
+#include "depth.h"
+
 unsigned long long int benchmark(void);
 
+// Searches each position in turn (built-in set, or one FEN per line of the file at path if not NULL) repeat times,
+// reporting per position and total speed statistics. depth of 0 uses each position's default depth, hashMb of 0 keeps
+// the current transposition table size. With more than one thread the positions are shared between that many
+// searches running in parallel (each with its own hash table), and nps is the combined rate.
+void benchmarkBench(Depth depth, unsigned int hashMb, const char *path, unsigned int repeat, unsigned int threads, bool json);
+
 #endif
@@ -8,12 +8,18 @@
 #include "colour.h"
 #include "main.h"
 #include "square.h"
+#include "tables.h"
 #include "util.h"
 
 // Pack 64 results into single array entry (a mask of places where if the black
 // king stands the position is a win for white).
 STATICASSERT(BitBaseResultBit<=1);
+#define BitBaseSize ((FileNB/2)*RankNB*SqNB*ColourNB)
+#ifdef TABLES
+extern const uint64_t bitbase[BitBaseSize]; // See tables.c.
+#else
 uint64_t *bitbase=NULL;
+#endif
 
 typedef enum {
 	BitBaseResultFullInvalid,
@@ -26,7 +32,9 @@ typedef enum {
 // Private prototypes.
 ////////////////////////////////////////////////////////////////////////////////
 
+#ifndef TABLES
 void bitbaseGen(void);
+#endif
 
 BitBaseResultFull bitbaseComputeStaticResult(Sq pawnSq, Sq wKingSq, Colour stm, Sq bKingSq);
 BitBaseResultFull bitbaseComputeDynamicResult(const BitBaseResultFull *array, Sq pawnSq, Sq wKingSq, Colour stm, Sq bKingSq);
@@ -41,19 +49,23 @@ unsigned int bitbaseIndexFull(File pawnFile, Rank pawnRank, Sq wKingSq, Colour s
 ////////////////////////////////////////////////////////////////////////////////
 
 void bitbaseInit(void) {
-	// Allocate memory.
-	bitbase=malloc((FileNB/2)*RankNB*SqNB*ColourNB*sizeof(uint64_t));
+#	ifndef TABLES
+	// Allocate memory (zeroed so that unused entries are deterministic).
+	bitbase=calloc(BitBaseSize, sizeof(uint64_t));
 	if (bitbase==NULL)
 		mainFatalError("Error: Could not allocate memory for KPvK bitbase.\n");
 
 	// Generate bitbase.
 	bitbaseGen();
+#	endif
 }
 
 void bitbaseQuit(void) {
+#	ifndef TABLES
 	// Free memory.
 	free(bitbase);
 	bitbase=NULL;
+#	endif
 }
 
 BitBaseResult bitbaseProbe(const Pos *pos) {
@@ -86,6 +98,7 @@ BitBaseResult bitbaseProbe(const Pos *pos) {
 // Private functions.
 ////////////////////////////////////////////////////////////////////////////////
 
+#ifndef TABLES
 void bitbaseGen(void) {
 	// Allocate array to use while generating bitbase.
 	BitBaseResultFull *array=malloc((FileNB/2)*RankNB*SqNB*ColourNB*SqNB*sizeof(BitBaseResultFull));
@@ -184,6 +197,7 @@ void bitbaseGen(void) {
 	// Free working array.
 	free(array);
 }
+#endif
 
 BitBaseResultFull bitbaseComputeStaticResult(Sq pawnSq, Sq wKingSq, Colour stm, Sq bKingSq) {
 	// Sanity checks.
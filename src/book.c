@@ -0,0 +1,493 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "attacks.h"
+#include "book.h"
+#include "moves.h"
+#include "uci.h"
+#include "util.h"
+
+// Keys follow Polyglot's layout: one random number per piece kind (black pawn, white pawn, black knight, ..., white
+// king) and square, then the four castling rights (white short, white long, black short, black long), the file of a
+// capturable en-passent pawn, and finally white to move.
+#define BookRandomPiece 0
+#define BookRandomCastle 768
+#define BookRandomEP 772
+#define BookRandomTurn 780
+#define BookRandomNB 781
+
+#define BookPathMax 1024
+
+const Key bookRandom[BookRandomNB]={ // Polyglot's Random64 table.
+	0x9D39247E33776D41llu, 0x2AF7398005AAA5C7llu, 0x44DB015024623547llu, 0x9C15F73E62A76AE2llu,
+	0x75834465489C0C89llu, 0x3290AC3A203001BFllu, 0x0FBBAD1F61042279llu, 0xE83A908FF2FB60CAllu,
+	0x0D7E765D58755C10llu, 0x1A083822CEAFE02Dllu, 0x9605D5F0E25EC3B0llu, 0xD021FF5CD13A2ED5llu,
+	0x40BDF15D4A672E32llu, 0x011355146FD56395llu, 0x5DB4832046F3D9E5llu, 0x239F8B2D7FF719CCllu,
+	0x05D1A1AE85B49AA1llu, 0x679F848F6E8FC971llu, 0x7449BBFF801FED0Bllu, 0x7D11CDB1C3B7ADF0llu,
+	0x82C7709E781EB7CCllu, 0xF3218F1C9510786Cllu, 0x331478F3AF51BBE6llu, 0x4BB38DE5E7219443llu,
+	0xAA649C6EBCFD50FCllu, 0x8DBD98A352AFD40Bllu, 0x87D2074B81D79217llu, 0x19F3C751D3E92AE1llu,
+	0xB4AB30F062B19ABFllu, 0x7B0500AC42047AC4llu, 0xC9452CA81A09D85Dllu, 0x24AA6C514DA27500llu,
+	0x4C9F34427501B447llu, 0x14A68FD73C910841llu, 0xA71B9B83461CBD93llu, 0x03488B95B0F1850Fllu,
+	0x637B2B34FF93C040llu, 0x09D1BC9A3DD90A94llu, 0x3575668334A1DD3Bllu, 0x735E2B97A4C45A23llu,
+	0x18727070F1BD400Bllu, 0x1FCBACD259BF02E7llu, 0xD310A7C2CE9B6555llu, 0xBF983FE0FE5D8244llu,
+	0x9F74D14F7454A824llu, 0x51EBDC4AB9BA3035llu, 0x5C82C505DB9AB0FAllu, 0xFCF7FE8A3430B241llu,
+	0x3253A729B9BA3DDEllu, 0x8C74C368081B3075llu, 0xB9BC6C87167C33E7llu, 0x7EF48F2B83024E20llu,
+	0x11D505D4C351BD7Fllu, 0x6568FCA92C76A243llu, 0x4DE0B0F40F32A7B8llu, 0x96D693460CC37E5Dllu,
+	0x42E240CB63689F2Fllu, 0x6D2BDCDAE2919661llu, 0x42880B0236E4D951llu, 0x5F0F4A5898171BB6llu,
+	0x39F890F579F92F88llu, 0x93C5B5F47356388Bllu, 0x63DC359D8D231B78llu, 0xEC16CA8AEA98AD76llu,
+	0x5355F900C2A82DC7llu, 0x07FB9F855A997142llu, 0x5093417AA8A7ED5Ellu, 0x7BCBC38DA25A7F3Cllu,
+	0x19FC8A768CF4B6D4llu, 0x637A7780DECFC0D9llu, 0x8249A47AEE0E41F7llu, 0x79AD695501E7D1E8llu,
+	0x14ACBAF4777D5776llu, 0xF145B6BECCDEA195llu, 0xDABF2AC8201752FCllu, 0x24C3C94DF9C8D3F6llu,
+	0xBB6E2924F03912EAllu, 0x0CE26C0B95C980D9llu, 0xA49CD132BFBF7CC4llu, 0xE99D662AF4243939llu,
+	0x27E6AD7891165C3Fllu, 0x8535F040B9744FF1llu, 0x54B3F4FA5F40D873llu, 0x72B12C32127FED2Bllu,
+	0xEE954D3C7B411F47llu, 0x9A85AC909A24EAA1llu, 0x70AC4CD9F04F21F5llu, 0xF9B89D3E99A075C2llu,
+	0x87B3E2B2B5C907B1llu, 0xA366E5B8C54F48B8llu, 0xAE4A9346CC3F7CF2llu, 0x1920C04D47267BBDllu,
+	0x87BF02C6B49E2AE9llu, 0x092237AC237F3859llu, 0xFF07F64EF8ED14D0llu, 0x8DE8DCA9F03CC54Ellu,
+	0x9C1633264DB49C89llu, 0xB3F22C3D0B0B38EDllu, 0x390E5FB44D01144Bllu, 0x5BFEA5B4712768E9llu,
+	0x1E1032911FA78984llu, 0x9A74ACB964E78CB3llu, 0x4F80F7A035DAFB04llu, 0x6304D09A0B3738C4llu,
+	0x2171E64683023A08llu, 0x5B9B63EB9CEFF80Cllu, 0x506AACF489889342llu, 0x1881AFC9A3A701D6llu,
+	0x6503080440750644llu, 0xDFD395339CDBF4A7llu, 0xEF927DBCF00C20F2llu, 0x7B32F7D1E03680ECllu,
+	0xB9FD7620E7316243llu, 0x05A7E8A57DB91B77llu, 0xB5889C6E15630A75llu, 0x4A750A09CE9573F7llu,
+	0xCF464CEC899A2F8Allu, 0xF538639CE705B824llu, 0x3C79A0FF5580EF7Fllu, 0xEDE6C87F8477609Dllu,
+	0x799E81F05BC93F31llu, 0x86536B8CF3428A8Cllu, 0x97D7374C60087B73llu, 0xA246637CFF328532llu,
+	0x043FCAE60CC0EBA0llu, 0x920E449535DD359Ellu, 0x70EB093B15B290CCllu, 0x73A1921916591CBDllu,
+	0x56436C9FE1A1AA8Dllu, 0xEFAC4B70633B8F81llu, 0xBB215798D45DF7AFllu, 0x45F20042F24F1768llu,
+	0x930F80F4E8EB7462llu, 0xFF6712FFCFD75EA1llu, 0xAE623FD67468AA70llu, 0xDD2C5BC84BC8D8FCllu,
+	0x7EED120D54CF2DD9llu, 0x22FE545401165F1Cllu, 0xC91800E98FB99929llu, 0x808BD68E6AC10365llu,
+	0xDEC468145B7605F6llu, 0x1BEDE3A3AEF53302llu, 0x43539603D6C55602llu, 0xAA969B5C691CCB7Allu,
+	0xA87832D392EFEE56llu, 0x65942C7B3C7E11AEllu, 0xDED2D633CAD004F6llu, 0x21F08570F420E565llu,
+	0xB415938D7DA94E3Cllu, 0x91B859E59ECB6350llu, 0x10CFF333E0ED804Allu, 0x28AED140BE0BB7DDllu,
+	0xC5CC1D89724FA456llu, 0x5648F680F11A2741llu, 0x2D255069F0B7DAB3llu, 0x9BC5A38EF729ABD4llu,
+	0xEF2F054308F6A2BCllu, 0xAF2042F5CC5C2858llu, 0x480412BAB7F5BE2Allu, 0xAEF3AF4A563DFE43llu,
+	0x19AFE59AE451497Fllu, 0x52593803DFF1E840llu, 0xF4F076E65F2CE6F0llu, 0x11379625747D5AF3llu,
+	0xBCE5D2248682C115llu, 0x9DA4243DE836994Fllu, 0x066F70B33FE09017llu, 0x4DC4DE189B671A1Cllu,
+	0x51039AB7712457C3llu, 0xC07A3F80C31FB4B4llu, 0xB46EE9C5E64A6E7Cllu, 0xB3819A42ABE61C87llu,
+	0x21A007933A522A20llu, 0x2DF16F761598AA4Fllu, 0x763C4A1371B368FDllu, 0xF793C46702E086A0llu,
+	0xD7288E012AEB8D31llu, 0xDE336A2A4BC1C44Bllu, 0x0BF692B38D079F23llu, 0x2C604A7A177326B3llu,
+	0x4850E73E03EB6064llu, 0xCFC447F1E53C8E1Bllu, 0xB05CA3F564268D99llu, 0x9AE182C8BC9474E8llu,
+	0xA4FC4BD4FC5558CAllu, 0xE755178D58FC4E76llu, 0x69B97DB1A4C03DFEllu, 0xF9B5B7C4ACC67C96llu,
+	0xFC6A82D64B8655FBllu, 0x9C684CB6C4D24417llu, 0x8EC97D2917456ED0llu, 0x6703DF9D2924E97Ellu,
+	0xC547F57E42A7444Ellu, 0x78E37644E7CAD29Ellu, 0xFE9A44E9362F05FAllu, 0x08BD35CC38336615llu,
+	0x9315E5EB3A129ACEllu, 0x94061B871E04DF75llu, 0xDF1D9F9D784BA010llu, 0x3BBA57B68871B59Dllu,
+	0xD2B7ADEEDED1F73Fllu, 0xF7A255D83BC373F8llu, 0xD7F4F2448C0CEB81llu, 0xD95BE88CD210FFA7llu,
+	0x336F52F8FF4728E7llu, 0xA74049DAC312AC71llu, 0xA2F61BB6E437FDB5llu, 0x4F2A5CB07F6A35B3llu,
+	0x87D380BDA5BF7859llu, 0x16B9F7E06C453A21llu, 0x7BA2484C8A0FD54Ellu, 0xF3A678CAD9A2E38Cllu,
+	0x39B0BF7DDE437BA2llu, 0xFCAF55C1BF8A4424llu, 0x18FCF680573FA594llu, 0x4C0563B89F495AC3llu,
+	0x40E087931A00930Dllu, 0x8CFFA9412EB642C1llu, 0x68CA39053261169Fllu, 0x7A1EE967D27579E2llu,
+	0x9D1D60E5076F5B6Fllu, 0x3810E399B6F65BA2llu, 0x32095B6D4AB5F9B1llu, 0x35CAB62109DD038Allu,
+	0xA90B24499FCFAFB1llu, 0x77A225A07CC2C6BDllu, 0x513E5E634C70E331llu, 0x4361C0CA3F692F12llu,
+	0xD941ACA44B20A45Bllu, 0x528F7C8602C5807Bllu, 0x52AB92BEB9613989llu, 0x9D1DFA2EFC557F73llu,
+	0x722FF175F572C348llu, 0x1D1260A51107FE97llu, 0x7A249A57EC0C9BA2llu, 0x04208FE9E8F7F2D6llu,
+	0x5A110C6058B920A0llu, 0x0CD9A497658A5698llu, 0x56FD23C8F9715A4Cllu, 0x284C847B9D887AAEllu,
+	0x04FEABFBBDB619CBllu, 0x742E1E651C60BA83llu, 0x9A9632E65904AD3Cllu, 0x881B82A13B51B9E2llu,
+	0x506E6744CD974924llu, 0xB0183DB56FFC6A79llu, 0x0ED9B915C66ED37Ellu, 0x5E11E86D5873D484llu,
+	0xF678647E3519AC6Ellu, 0x1B85D488D0F20CC5llu, 0xDAB9FE6525D89021llu, 0x0D151D86ADB73615llu,
+	0xA865A54EDCC0F019llu, 0x93C42566AEF98FFBllu, 0x99E7AFEABE000731llu, 0x48CBFF086DDF285Allu,
+	0x7F9B6AF1EBF78BAFllu, 0x58627E1A149BBA21llu, 0x2CD16E2ABD791E33llu, 0xD363EFF5F0977996llu,
+	0x0CE2A38C344A6EEDllu, 0x1A804AADB9CFA741llu, 0x907F30421D78C5DEllu, 0x501F65EDB3034D07llu,
+	0x37624AE5A48FA6E9llu, 0x957BAF61700CFF4Ellu, 0x3A6C27934E31188Allu, 0xD49503536ABCA345llu,
+	0x088E049589C432E0llu, 0xF943AEE7FEBF21B8llu, 0x6C3B8E3E336139D3llu, 0x364F6FFA464EE52Ellu,
+	0xD60F6DCEDC314222llu, 0x56963B0DCA418FC0llu, 0x16F50EDF91E513AFllu, 0xEF1955914B609F93llu,
+	0x565601C0364E3228llu, 0xECB53939887E8175llu, 0xBAC7A9A18531294Bllu, 0xB344C470397BBA52llu,
+	0x65D34954DAF3CEBDllu, 0xB4B81B3FA97511E2llu, 0xB422061193D6F6A7llu, 0x071582401C38434Dllu,
+	0x7A13F18BBEDC4FF5llu, 0xBC4097B116C524D2llu, 0x59B97885E2F2EA28llu, 0x99170A5DC3115544llu,
+	0x6F423357E7C6A9F9llu, 0x325928EE6E6F8794llu, 0xD0E4366228B03343llu, 0x565C31F7DE89EA27llu,
+	0x30F5611484119414llu, 0xD873DB391292ED4Fllu, 0x7BD94E1D8E17DEBCllu, 0xC7D9F16864A76E94llu,
+	0x947AE053EE56E63Cllu, 0xC8C93882F9475F5Fllu, 0x3A9BF55BA91F81CAllu, 0xD9A11FBB3D9808E4llu,
+	0x0FD22063EDC29FCAllu, 0xB3F256D8ACA0B0B9llu, 0xB03031A8B4516E84llu, 0x35DD37D5871448AFllu,
+	0xE9F6082B05542E4Ellu, 0xEBFAFA33D7254B59llu, 0x9255ABB50D532280llu, 0xB9AB4CE57F2D34F3llu,
+	0x693501D628297551llu, 0xC62C58F97DD949BFllu, 0xCD454F8F19C5126Allu, 0xBBE83F4ECC2BDECBllu,
+	0xDC842B7E2819E230llu, 0xBA89142E007503B8llu, 0xA3BC941D0A5061CBllu, 0xE9F6760E32CD8021llu,
+	0x09C7E552BC76492Fllu, 0x852F54934DA55CC9llu, 0x8107FCCF064FCF56llu, 0x098954D51FFF6580llu,
+	0x23B70EDB1955C4BFllu, 0xC330DE426430F69Dllu, 0x4715ED43E8A45C0Allu, 0xA8D7E4DAB780A08Dllu,
+	0x0572B974F03CE0BBllu, 0xB57D2E985E1419C7llu, 0xE8D9ECBE2CF3D73Fllu, 0x2FE4B17170E59750llu,
+	0x11317BA87905E790llu, 0x7FBF21EC8A1F45ECllu, 0x1725CABFCB045B00llu, 0x964E915CD5E2B207llu,
+	0x3E2B8BCBF016D66Dllu, 0xBE7444E39328A0ACllu, 0xF85B2B4FBCDE44B7llu, 0x49353FEA39BA63B1llu,
+	0x1DD01AAFCD53486Allu, 0x1FCA8A92FD719F85llu, 0xFC7C95D827357AFAllu, 0x18A6A990C8B35EBDllu,
+	0xCCCB7005C6B9C28Dllu, 0x3BDBB92C43B17F26llu, 0xAA70B5B4F89695A2llu, 0xE94C39A54A98307Fllu,
+	0xB7A0B174CFF6F36Ellu, 0xD4DBA84729AF48ADllu, 0x2E18BC1AD9704A68llu, 0x2DE0966DAF2F8B1Cllu,
+	0xB9C11D5B1E43A07Ellu, 0x64972D68DEE33360llu, 0x94628D38D0C20584llu, 0xDBC0D2B6AB90A559llu,
+	0xD2733C4335C6A72Fllu, 0x7E75D99D94A70F4Dllu, 0x6CED1983376FA72Bllu, 0x97FCAACBF030BC24llu,
+	0x7B77497B32503B12llu, 0x8547EDDFB81CCB94llu, 0x79999CDFF70902CBllu, 0xCFFE1939438E9B24llu,
+	0x829626E3892D95D7llu, 0x92FAE24291F2B3F1llu, 0x63E22C147B9C3403llu, 0xC678B6D860284A1Cllu,
+	0x5873888850659AE7llu, 0x0981DCD296A8736Dllu, 0x9F65789A6509A440llu, 0x9FF38FED72E9052Fllu,
+	0xE479EE5B9930578Cllu, 0xE7F28ECD2D49EECDllu, 0x56C074A581EA17FEllu, 0x5544F7D774B14AEFllu,
+	0x7B3F0195FC6F290Fllu, 0x12153635B2C0CF57llu, 0x7F5126DBBA5E0CA7llu, 0x7A76956C3EAFB413llu,
+	0x3D5774A11D31AB39llu, 0x8A1B083821F40CB4llu, 0x7B4A38E32537DF62llu, 0x950113646D1D6E03llu,
+	0x4DA8979A0041E8A9llu, 0x3BC36E078F7515D7llu, 0x5D0A12F27AD310D1llu, 0x7F9D1A2E1EBE1327llu,
+	0xDA3A361B1C5157B1llu, 0xDCDD7D20903D0C25llu, 0x36833336D068F707llu, 0xCE68341F79893389llu,
+	0xAB9090168DD05F34llu, 0x43954B3252DC25E5llu, 0xB438C2B67F98E5E9llu, 0x10DCD78E3851A492llu,
+	0xDBC27AB5447822BFllu, 0x9B3CDB65F82CA382llu, 0xB67B7896167B4C84llu, 0xBFCED1B0048EAC50llu,
+	0xA9119B60369FFEBDllu, 0x1FFF7AC80904BF45llu, 0xAC12FB171817EEE7llu, 0xAF08DA9177DDA93Dllu,
+	0x1B0CAB936E65C744llu, 0xB559EB1D04E5E932llu, 0xC37B45B3F8D6F2BAllu, 0xC3A9DC228CAAC9E9llu,
+	0xF3B8B6675A6507FFllu, 0x9FC477DE4ED681DAllu, 0x67378D8ECCEF96CBllu, 0x6DD856D94D259236llu,
+	0xA319CE15B0B4DB31llu, 0x073973751F12DD5Ellu, 0x8A8E849EB32781A5llu, 0xE1925C71285279F5llu,
+	0x74C04BF1790C0EFEllu, 0x4DDA48153C94938Allu, 0x9D266D6A1CC0542Cllu, 0x7440FB816508C4FEllu,
+	0x13328503DF48229Fllu, 0xD6BF7BAEE43CAC40llu, 0x4838D65F6EF6748Fllu, 0x1E152328F3318DEAllu,
+	0x8F8419A348F296BFllu, 0x72C8834A5957B511llu, 0xD7A023A73260B45Cllu, 0x94EBC8ABCFB56DAEllu,
+	0x9FC10D0F989993E0llu, 0xDE68A2355B93CAE6llu, 0xA44CFE79AE538BBEllu, 0x9D1D84FCCE371425llu,
+	0x51D2B1AB2DDFB636llu, 0x2FD7E4B9E72CD38Cllu, 0x65CA5B96B7552210llu, 0xDD69A0D8AB3B546Dllu,
+	0x604D51B25FBF70E2llu, 0x73AA8A564FB7AC9Ellu, 0x1A8C1E992B941148llu, 0xAAC40A2703D9BEA0llu,
+	0x764DBEAE7FA4F3A6llu, 0x1E99B96E70A9BE8Bllu, 0x2C5E9DEB57EF4743llu, 0x3A938FEE32D29981llu,
+	0x26E6DB8FFDF5ADFEllu, 0x469356C504EC9F9Dllu, 0xC8763C5B08D1908Cllu, 0x3F6C6AF859D80055llu,
+	0x7F7CC39420A3A545llu, 0x9BFB227EBDF4C5CEllu, 0x89039D79D6FC5C5Cllu, 0x8FE88B57305E2AB6llu,
+	0xA09E8C8C35AB96DEllu, 0xFA7E393983325753llu, 0xD6B6D0ECC617C699llu, 0xDFEA21EA9E7557E3llu,
+	0xB67C1FA481680AF8llu, 0xCA1E3785A9E724E5llu, 0x1CFC8BED0D681639llu, 0xD18D8549D140CAEAllu,
+	0x4ED0FE7E9DC91335llu, 0xE4DBF0634473F5D2llu, 0x1761F93A44D5AEFEllu, 0x53898E4C3910DA55llu,
+	0x734DE8181F6EC39Allu, 0x2680B122BAA28D97llu, 0x298AF231C85BAFABllu, 0x7983EED3740847D5llu,
+	0x66C1A2A1A60CD889llu, 0x9E17E49642A3E4C1llu, 0xEDB454E7BADC0805llu, 0x50B704CAB602C329llu,
+	0x4CC317FB9CDDD023llu, 0x66B4835D9EAFEA22llu, 0x219B97E26FFC81BDllu, 0x261E4E4C0A333A9Dllu,
+	0x1FE2CCA76517DB90llu, 0xD7504DFA8816EDBBllu, 0xB9571FA04DC089C8llu, 0x1DDC0325259B27DEllu,
+	0xCF3F4688801EB9AAllu, 0xF4F5D05C10CAB243llu, 0x38B6525C21A42B0Ellu, 0x36F60E2BA4FA6800llu,
+	0xEB3593803173E0CEllu, 0x9C4CD6257C5A3603llu, 0xAF0C317D32ADAA8Allu, 0x258E5A80C7204C4Bllu,
+	0x8B889D624D44885Dllu, 0xF4D14597E660F855llu, 0xD4347F66EC8941C3llu, 0xE699ED85B0DFB40Dllu,
+	0x2472F6207C2D0484llu, 0xC2A1E7B5B459AEB5llu, 0xAB4F6451CC1D45ECllu, 0x63767572AE3D6174llu,
+	0xA59E0BD101731A28llu, 0x116D0016CB948F09llu, 0x2CF9C8CA052F6E9Fllu, 0x0B090A7560A968E3llu,
+	0xABEEDDB2DDE06FF1llu, 0x58EFC10B06A2068Dllu, 0xC6E57A78FBD986E0llu, 0x2EAB8CA63CE802D7llu,
+	0x14A195640116F336llu, 0x7C0828DD624EC390llu, 0xD74BBE77E6116AC7llu, 0x804456AF10F5FB53llu,
+	0xEBE9EA2ADF4321C7llu, 0x03219A39EE587A30llu, 0x49787FEF17AF9924llu, 0xA1E9300CD8520548llu,
+	0x5B45E522E4B1B4EFllu, 0xB49C3B3995091A36llu, 0xD4490AD526F14431llu, 0x12A8F216AF9418C2llu,
+	0x001F837CC7350524llu, 0x1877B51E57A764D5llu, 0xA2853B80F17F58EEllu, 0x993E1DE72D36D310llu,
+	0xB3598080CE64A656llu, 0x252F59CF0D9F04BBllu, 0xD23C8E176D113600llu, 0x1BDA0492E7E4586Ellu,
+	0x21E0BD5026C619BFllu, 0x3B097ADAF088F94Ellu, 0x8D14DEDB30BE846Ellu, 0xF95CFFA23AF5F6F4llu,
+	0x3871700761B3F743llu, 0xCA672B91E9E4FA16llu, 0x64C8E531BFF53B55llu, 0x241260ED4AD1E87Dllu,
+	0x106C09B972D2E822llu, 0x7FBA195410E5CA30llu, 0x7884D9BC6CB569D8llu, 0x0647DFEDCD894A29llu,
+	0x63573FF03E224774llu, 0x4FC8E9560F91B123llu, 0x1DB956E450275779llu, 0xB8D91274B9E9D4FBllu,
+	0xA2EBEE47E2FBFCE1llu, 0xD9F1F30CCD97FB09llu, 0xEFED53D75FD64E6Bllu, 0x2E6D02C36017F67Fllu,
+	0xA9AA4D20DB084E9Bllu, 0xB64BE8D8B25396C1llu, 0x70CB6AF7C2D5BCF0llu, 0x98F076A4F7A2322Ellu,
+	0xBF84470805E69B5Fllu, 0x94C3251F06F90CF3llu, 0x3E003E616A6591E9llu, 0xB925A6CD0421AFF3llu,
+	0x61BDD1307C66E300llu, 0xBF8D5108E27E0D48llu, 0x240AB57A8B888B20llu, 0xFC87614BAF287E07llu,
+	0xEF02CDD06FFDB432llu, 0xA1082C0466DF6C0Allu, 0x8215E577001332C8llu, 0xD39BB9C3A48DB6CFllu,
+	0x2738259634305C14llu, 0x61CF4F94C97DF93Dllu, 0x1B6BACA2AE4E125Bllu, 0x758F450C88572E0Bllu,
+	0x959F587D507A8359llu, 0xB063E962E045F54Dllu, 0x60E8ED72C0DFF5D1llu, 0x7B64978555326F9Fllu,
+	0xFD080D236DA814BAllu, 0x8C90FD9B083F4558llu, 0x106F72FE81E2C590llu, 0x7976033A39F7D952llu,
+	0xA4EC0132764CA04Bllu, 0x733EA705FAE4FA77llu, 0xB4D8F77BC3E56167llu, 0x9E21F4F903B33FD9llu,
+	0x9D765E419FB69F6Dllu, 0xD30C088BA61EA5EFllu, 0x5D94337FBFAF7F5Bllu, 0x1A4E4822EB4D7A59llu,
+	0x6FFE73E81B637FB3llu, 0xDDF957BC36D8B9CAllu, 0x64D0E29EEA8838B3llu, 0x08DD9BDFD96B9F63llu,
+	0x087E79E5A57D1D13llu, 0xE328E230E3E2B3FBllu, 0x1C2559E30F0946BEllu, 0x720BF5F26F4D2EAAllu,
+	0xB0774D261CC609DBllu, 0x443F64EC5A371195llu, 0x4112CF68649A260Ellu, 0xD813F2FAB7F5C5CAllu,
+	0x660D3257380841EEllu, 0x59AC2C7873F910A3llu, 0xE846963877671A17llu, 0x93B633ABFA3469F8llu,
+	0xC0C0F5A60EF4CDCFllu, 0xCAF21ECD4377B28Cllu, 0x57277707199B8175llu, 0x506C11B9D90E8B1Dllu,
+	0xD83CC2687A19255Fllu, 0x4A29C6465A314CD1llu, 0xED2DF21216235097llu, 0xB5635C95FF7296E2llu,
+	0x22AF003AB672E811llu, 0x52E762596BF68235llu, 0x9AEBA33AC6ECC6B0llu, 0x944F6DE09134DFB6llu,
+	0x6C47BEC883A7DE39llu, 0x6AD047C430A12104llu, 0xA5B1CFDBA0AB4067llu, 0x7C45D833AFF07862llu,
+	0x5092EF950A16DA0Bllu, 0x9338E69C052B8E7Bllu, 0x455A4B4CFE30E3F5llu, 0x6B02E63195AD0CF8llu,
+	0x6B17B224BAD6BF27llu, 0xD1E0CCD25BB9C169llu, 0xDE0C89A556B9AE70llu, 0x50065E535A213CF6llu,
+	0x9C1169FA2777B874llu, 0x78EDEFD694AF1EEDllu, 0x6DC93D9526A50E68llu, 0xEE97F453F06791EDllu,
+	0x32AB0EDB696703D3llu, 0x3A6853C7E70757A7llu, 0x31865CED6120F37Dllu, 0x67FEF95D92607890llu,
+	0x1F2B1D1F15F6DC9Cllu, 0xB69E38A8965C6B65llu, 0xAA9119FF184CCCF4llu, 0xF43C732873F24C13llu,
+	0xFB4A3D794A9A80D2llu, 0x3550C2321FD6109Cllu, 0x371F77E76BB8417Ellu, 0x6BFA9AAE5EC05779llu,
+	0xCD04F3FF001A4778llu, 0xE3273522064480CAllu, 0x9F91508BFFCFC14Allu, 0x049A7F41061A9E60llu,
+	0xFCB6BE43A9F2FE9Bllu, 0x08DE8A1C7797DA9Bllu, 0x8F9887E6078735A1llu, 0xB5B4071DBFC73A66llu,
+	0x230E343DFBA08D33llu, 0x43ED7F5A0FAE657Dllu, 0x3A88A0FBBCB05C63llu, 0x21874B8B4D2DBC4Fllu,
+	0x1BDEA12E35F6A8C9llu, 0x53C065C6C8E63528llu, 0xE34A1D250E7A8D6Bllu, 0xD6B04D3B7651DD7Ellu,
+	0x5E90277E7CB39E2Dllu, 0x2C046F22062DC67Dllu, 0xB10BB459132D0A26llu, 0x3FA9DDFB67E2F199llu,
+	0x0E09B88E1914F7AFllu, 0x10E8B35AF3EEAB37llu, 0x9EEDECA8E272B933llu, 0xD4C718BC4AE8AE5Fllu,
+	0x81536D601170FC20llu, 0x91B534F885818A06llu, 0xEC8177F83F900978llu, 0x190E714FADA5156Ellu,
+	0xB592BF39B0364963llu, 0x89C350C893AE7DC1llu, 0xAC042E70F8B383F2llu, 0xB49B52E587A1EE60llu,
+	0xFB152FE3FF26DA89llu, 0x3E666E6F69AE2C15llu, 0x3B544EBE544C19F9llu, 0xE805A1E290CF2456llu,
+	0x24B33C9D7ED25117llu, 0xE74733427B72F0C1llu, 0x0A804D18B7097475llu, 0x57E3306D881EDB4Fllu,
+	0x4AE7D6A36EB5DBCBllu, 0x2D8D5432157064C8llu, 0xD1E649DE1E7F268Bllu, 0x8A328A1CEDFE552Cllu,
+	0x07A3AEC79624C7DAllu, 0x84547DDC3E203C94llu, 0x990A98FD5071D263llu, 0x1A4FF12616EEFC89llu,
+	0xF6F7FD1431714200llu, 0x30C05B1BA332F41Cllu, 0x8D2636B81555A786llu, 0x46C9FEB55D120902llu,
+	0xCCEC0A73B49C9921llu, 0x4E9D2827355FC492llu, 0x19EBB029435DCB0Fllu, 0x4659D2B743848A2Cllu,
+	0x963EF2C96B33BE31llu, 0x74F85198B05A2E7Dllu, 0x5A0F544DD2B1FB18llu, 0x03727073C2E134B1llu,
+	0xC7F6AA2DE59AEA61llu, 0x352787BAA0D7C22Fllu, 0x9853EAB63B5E0B35llu, 0xABBDCDD7ED5C0860llu,
+	0xCF05DAF5AC8D77B0llu, 0x49CAD48CEBF4A71Ellu, 0x7A4C10EC2158C4A6llu, 0xD9E92AA246BF719Ellu,
+	0x13AE978D09FE5550llu, 0x730499AF921549FFllu, 0x4E4B705B92903BA4llu, 0xFF577222C14F0A3Allu,
+	0x55B6344CF97AAFAEllu, 0xB862225B055B6960llu, 0xCAC09AFBDDD2CDB4llu, 0xDAF8E9829FE96B5Fllu,
+	0xB5FDFC5D3132C498llu, 0x310CB380DB6F7503llu, 0xE87FBB46217A360Ellu, 0x2102AE466EBB1148llu,
+	0xF8549E1A3AA5E00Dllu, 0x07A69AFDCC42261Allu, 0xC4C118BFE78FEAAEllu, 0xF9F4892ED96BD438llu,
+	0x1AF3DBE25D8F45DAllu, 0xF5B4B0B0D2DEEEB4llu, 0x962ACEEFA82E1C84llu, 0x046E3ECAAF453CE9llu,
+	0xF05D129681949A4Cllu, 0x964781CE734B3C84llu, 0x9C2ED44081CE5FBDllu, 0x522E23F3925E319Ellu,
+	0x177E00F9FC32F791llu, 0x2BC60A63A6F3B3F2llu, 0x222BBFAE61725606llu, 0x486289DDCC3D6780llu,
+	0x7DC7785B8EFDFC80llu, 0x8AF38731C02BA980llu, 0x1FAB64EA29A2DDF7llu, 0xE4D9429322CD065Allu,
+	0x9DA058C67844F20Cllu, 0x24C0E332B70019B0llu, 0x233003B5A6CFE6ADllu, 0xD586BD01C5C217F6llu,
+	0x5E5637885F29BC2Bllu, 0x7EBA726D8C94094Bllu, 0x0A56A5F0BFE39272llu, 0xD79476A84EE20D06llu,
+	0x9E4C1269BAA4BF37llu, 0x17EFEE45B0DEE640llu, 0x1D95B0A5FCF90BC6llu, 0x93CBE0B699C2585Dllu,
+	0x65FA4F227A2B6D79llu, 0xD5F9E858292504D5llu, 0xC2B5A03F71471A6Fllu, 0x59300222B4561E00llu,
+	0xCE2F8642CA0712DCllu, 0x7CA9723FBB2E8988llu, 0x2785338347F2BA08llu, 0xC61BB3A141E50E8Cllu,
+	0x150F361DAB9DEC26llu, 0x9F6A419D382595F4llu, 0x64A53DC924FE7AC9llu, 0x142DE49FFF7A7C3Dllu,
+	0x0C335248857FA9E7llu, 0x0A9C32D5EAE45305llu, 0xE6C42178C4BBB92Ellu, 0x71F1CE2490D20B07llu,
+	0xF1BCC3D275AFE51Allu, 0xE728E8C83C334074llu, 0x96FBF83A12884624llu, 0x81A1549FD6573DA5llu,
+	0x5FA7867CAF35E149llu, 0x56986E2EF3ED091Bllu, 0x917F1DD5F8886C61llu, 0xD20D8C88C8FFE65Fllu,
+	0x31D71DCE64B2C310llu, 0xF165B587DF898190llu, 0xA57E6339DD2CF3A7llu, 0x1EF6E6DBB1961EC9llu,
+	0x70CC73D90BC26E24llu, 0xE21A6B35DF0C3AD7llu, 0x003A93D8B2806962llu, 0x1C99DED33CB890A1llu,
+	0xCF3145DE0ADD4289llu, 0xD0E4427A5514FB72llu, 0x77C621CC9FB3A483llu, 0x67A34DAC4356550Bllu,
+	0xF8D626AAAF278509llu
+};
+
+const unsigned int bookPieceTypeIndex[PieceTypeNB]={
+	[PieceTypePawn]=0, [PieceTypeKnight]=1, [PieceTypeBishopL]=2, [PieceTypeBishopD]=2, [PieceTypeRook]=3, [PieceTypeQueen]=4, [PieceTypeKing]=5
+}; // Also the promotion codes used in book moves.
+
+bool bookOwnBook=false;
+char bookPath[BookPathMax]="book.bin";
+
+const uint8_t *bookMap=NULL;
+size_t bookMapSize=0, bookEntryCount=0;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+void bookOpen(void); // (Re)maps bookPath if bookOwnBook is set.
+void bookClose(void);
+
+size_t bookFind(Key key); // Returns index of the first entry with the given key (or bookEntryCount if none).
+void bookGetEntry(size_t index, BookEntry *entry);
+
+void bookVerify(void);
+
+void bookInterfaceOwnBook(void *dummy, bool value);
+void bookInterfaceFile(void *dummy, const char *value);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void bookInit(void) {
+	// Check keys against Polyglot's published examples.
+	bookVerify();
+
+	// Setup callbacks for options.
+	uciOptionNewCheck("OwnBook", &bookInterfaceOwnBook, NULL, bookOwnBook);
+	uciOptionNewString("BookFile", &bookInterfaceFile, NULL, bookPath);
+}
+
+void bookQuit(void) {
+	bookClose();
+}
+
+Move bookGetMove(const Pos *pos) {
+	if (bookMap==NULL)
+		return MoveInvalid;
+
+	// Sum weights of entries for this position.
+	Key key=bookKey(pos);
+	size_t first=bookFind(key);
+	unsigned long long int total=0;
+	BookEntry entry;
+	for(size_t i=first;i<bookEntryCount;++i) {
+		bookGetEntry(i, &entry);
+		if (entry.key!=key)
+			break;
+		total+=entry.weight;
+	}
+	if (total==0)
+		return MoveInvalid;
+
+	// Pick one at random in proportion to its weight.
+	unsigned long long int choice=utilRand64()%total;
+	for(size_t i=first;;++i) {
+		bookGetEntry(i, &entry);
+		assert(entry.key==key);
+		if (choice<entry.weight)
+			return bookMoveFromPolyglot(pos, entry.move);
+		choice-=entry.weight;
+	}
+}
+
+void bookPrint(const Pos *pos) {
+	if (bookMap==NULL) {
+		uciWrite("Error: No book open (see OwnBook and BookFile options).\n");
+		return;
+	}
+
+	Key key=bookKey(pos);
+	size_t first=bookFind(key);
+	unsigned long long int total=0;
+	BookEntry entry;
+	size_t i;
+	for(i=first;i<bookEntryCount;++i) {
+		bookGetEntry(i, &entry);
+		if (entry.key!=key)
+			break;
+		total+=entry.weight;
+	}
+
+	uciWrite("key %016"PRIxKey" entries %zu\n", key, i-first);
+	for(i=first;i<bookEntryCount;++i) {
+		bookGetEntry(i, &entry);
+		if (entry.key!=key)
+			break;
+		Move move=bookMoveFromPolyglot(pos, entry.move);
+		uciWrite("  %-5s weight %5u (%5.1f%%)%s\n", POSMOVETOSTR(pos, move), entry.weight, (total>0 ? (entry.weight*100.0)/total : 0.0),
+		         (moveIsValid(move) ? "" : " illegal"));
+	}
+}
+
+Key bookKey(const Pos *pos) {
+	Key key=0;
+
+	// Pieces.
+	BB occ=posGetBBAll(pos);
+	while(occ) {
+		Sq sq=bbScanReset(&occ);
+		Piece piece=posGetPieceOnSq(pos, sq);
+		unsigned int kind=2*bookPieceTypeIndex[pieceGetType(piece)]+(pieceGetColour(piece)==ColourWhite);
+		key^=bookRandom[BookRandomPiece+64*kind+8*sqRank(sq)+sqFile(sq)];
+	}
+
+	// Castling rights.
+	CastRights castRights=posGetCastRights(pos);
+	if (castRights.rookSq[ColourWhite][CastSideH]!=SqInvalid)
+		key^=bookRandom[BookRandomCastle+0];
+	if (castRights.rookSq[ColourWhite][CastSideA]!=SqInvalid)
+		key^=bookRandom[BookRandomCastle+1];
+	if (castRights.rookSq[ColourBlack][CastSideH]!=SqInvalid)
+		key^=bookRandom[BookRandomCastle+2];
+	if (castRights.rookSq[ColourBlack][CastSideA]!=SqInvalid)
+		key^=bookRandom[BookRandomCastle+3];
+
+	// En-passent. Polyglot includes this whenever a pawn of the side to move is beside the pawn which has just double
+	// pushed, even if capturing it is illegal, so this cannot use our ep square (only set if a legal capture exists).
+	Sq pushSq=posGetDoublePushSq(pos);
+	if (pushSq!=SqInvalid && (attacksPawn(pushSq, colourSwap(posGetSTM(pos))) & posGetBBPiece(pos, pieceMake(PieceTypePawn, posGetSTM(pos))))!=BBNone)
+		key^=bookRandom[BookRandomEP+sqFile(pushSq)];
+
+	// Side to move.
+	if (posGetSTM(pos)==ColourWhite)
+		key^=bookRandom[BookRandomTurn];
+
+	return key;
+}
+
+uint16_t bookMoveToPolyglot(const Pos *pos, Move move) {
+	// Castling is encoded as the king capturing its own rook, which is exactly our 'raw' to square.
+	Sq fromSq=moveGetFromSq(move), toSq=moveGetToSqRaw(move);
+	PieceType toType=moveGetToPieceType(move);
+	unsigned int promo=(pieceGetType(posGetPieceOnSq(pos, fromSq))!=toType ? bookPieceTypeIndex[toType] : 0);
+	return sqFile(toSq)|(sqRank(toSq)<<3)|(sqFile(fromSq)<<6)|(sqRank(fromSq)<<9)|(promo<<12);
+}
+
+Move bookMoveFromPolyglot(const Pos *pos, uint16_t bookMove) {
+	Moves moves;
+	movesInitBulk(&moves, pos);
+	Move move;
+	while((move=movesNext(&moves))!=MoveInvalid)
+		if (bookMoveToPolyglot(pos, move)==bookMove)
+			return move;
+	return MoveInvalid;
+}
+
+void bookEntryRead(const uint8_t bytes[static BookEntrySize], BookEntry *entry) {
+	entry->key=0;
+	for(unsigned int i=0;i<8;++i)
+		entry->key=(entry->key<<8)|bytes[i];
+	entry->move=(bytes[8]<<8)|bytes[9];
+	entry->weight=(bytes[10]<<8)|bytes[11];
+	entry->learn=(((uint32_t)bytes[12])<<24)|(bytes[13]<<16)|(bytes[14]<<8)|bytes[15];
+}
+
+void bookEntryWrite(uint8_t bytes[static BookEntrySize], const BookEntry *entry) {
+	for(unsigned int i=0;i<8;++i)
+		bytes[i]=(entry->key>>(56-8*i))&0xFF;
+	bytes[8]=entry->move>>8;
+	bytes[9]=entry->move&0xFF;
+	bytes[10]=entry->weight>>8;
+	bytes[11]=entry->weight&0xFF;
+	for(unsigned int i=0;i<4;++i)
+		bytes[12+i]=(entry->learn>>(24-8*i))&0xFF;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void bookOpen(void) {
+	bookClose();
+	if (!bookOwnBook)
+		return;
+
+	int fd=open(bookPath, O_RDONLY);
+	if (fd<0) {
+		uciWrite("info string Could not open book '%s'.\n", bookPath);
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st)!=0 || st.st_size<BookEntrySize) {
+		uciWrite("info string Could not open book '%s'.\n", bookPath);
+		close(fd);
+		return;
+	}
+	void *map=mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map==MAP_FAILED) {
+		uciWrite("info string Could not map book '%s'.\n", bookPath);
+		return;
+	}
+	madvise(map, st.st_size, MADV_RANDOM); // Probes only touch a handful of pages.
+	bookMap=map;
+	bookMapSize=st.st_size;
+	bookEntryCount=st.st_size/BookEntrySize;
+}
+
+void bookClose(void) {
+	if (bookMap!=NULL)
+		munmap((void *)bookMap, bookMapSize);
+	bookMap=NULL;
+	bookMapSize=bookEntryCount=0;
+}
+
+size_t bookFind(Key key) {
+	// Binary search for the lower bound.
+	size_t low=0, high=bookEntryCount;
+	BookEntry entry;
+	while(low<high) {
+		size_t mid=low+(high-low)/2;
+		bookGetEntry(mid, &entry);
+		if (entry.key<key)
+			low=mid+1;
+		else
+			high=mid;
+	}
+	return low;
+}
+
+void bookGetEntry(size_t index, BookEntry *entry) {
+	assert(index<bookEntryCount);
+	bookEntryRead(bookMap+index*BookEntrySize, entry);
+}
+
+void bookVerify(void) {
+#	ifndef NDEBUG
+	const struct { const char *fen; Key key; } tests[]={
+		{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463B96181691FC9Cllu},
+		{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823C9B50FD114196llu},
+		{"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756B94461C50FB0llu},
+		{"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662FAFB965DB29D4llu},
+		{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22A48B5A8E47FF78llu},
+		{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652A607CA3F242C1llu},
+		{"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00FDD303C946BDD9llu},
+		{"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3C8123EA7B067637llu},
+		{"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5C3F9B829B279560llu},
+	};
+	for(unsigned int i=0;i<sizeof(tests)/sizeof(tests[0]);++i) {
+		Pos *pos=posNew(tests[i].fen);
+		assert(pos!=NULL);
+		assert(bookKey(pos)==tests[i].key);
+		posFree(pos);
+	}
+#	endif
+}
+
+void bookInterfaceOwnBook(void *dummy, bool value) {
+	bookOwnBook=value;
+	bookOpen();
+}
+
+void bookInterfaceFile(void *dummy, const char *value) {
+	if (strlen(value)>=BookPathMax) {
+		uciWrite("info string Book path too long.\n");
+		return;
+	}
+	strcpy(bookPath, value);
+	bookOpen();
+}
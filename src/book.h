@@ -0,0 +1,38 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "move.h"
+#include "pos.h"
+
+// Opening books in Polyglot's .bin format: 16 byte big-endian entries (key, move, weight, learn) sorted by key.
+// Books are memory mapped and binary searched, so are never read into memory as a whole.
+
+#define BookEntrySize 16
+
+typedef struct {
+	Key key;
+	uint16_t move, weight;
+	uint32_t learn;
+} BookEntry;
+
+void bookInit(void);
+void bookQuit(void);
+
+// Returns MoveInvalid unless the OwnBook option is enabled and the position is in the book, otherwise picks one of the
+// book moves at random in proportion to their weights.
+Move bookGetMove(const Pos *pos);
+
+void bookPrint(const Pos *pos); // Lists the book entries for the given position.
+
+Key bookKey(const Pos *pos); // Polyglot style key (see book.c).
+uint16_t bookMoveToPolyglot(const Pos *pos, Move move);
+Move bookMoveFromPolyglot(const Pos *pos, uint16_t move); // Returns MoveInvalid if no legal move matches.
+
+void bookEntryRead(const uint8_t bytes[static BookEntrySize], BookEntry *entry);
+void bookEntryWrite(uint8_t bytes[static BookEntrySize], const BookEntry *entry);
+
+#endif
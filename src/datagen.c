@@ -0,0 +1,279 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "datagen.h"
+#include "eval.h"
+#include "moves.h"
+#include "packed.h"
+#include "search.h"
+#include "thread.h"
+#include "uci.h"
+#include "util.h"
+
+#define DatagenMaxPlies 400 // Games reaching this are adjudicated as draws.
+#define DatagenAdjudicateScore 1500 // Games are adjudicated as wins once the search score exceeds this...
+#define DatagenAdjudicatePlies 8 // ...for this many consecutive plies (from both sides' point of view).
+#define DatagenFlushGames 16 // Output is flushed after this many games per thread, and progress reported after this many in total.
+#define DatagenThreadsMax 64
+
+typedef struct {
+	Score score;
+	Move bestMove;
+} DatagenSearch;
+
+typedef struct {
+	unsigned int games, randomPlies;
+	unsigned long long int nodes;
+	TimeMs startTime;
+
+	Lock *lock; // Protects the fields below.
+	unsigned int nextGame, gamesDone;
+	unsigned long long int positionCount;
+	unsigned int results[3];
+	bool error; // Stops all workers.
+} DatagenShared;
+
+typedef struct {
+	DatagenShared *shared;
+	Search *search; // Each worker searches with its own context...
+	uint64_t randState; // ...and chooses openings from its own sequence...
+	char *path; // ...and writes to its own file.
+	PackedWriter *writer;
+	Pos *pos;
+	PosPacked *records;
+} DatagenWork;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+void datagenWorker(void *userData);
+
+bool datagenOpening(Pos *pos, unsigned int randomPlies, uint64_t *randState); // Returns false if the game ended during the random moves.
+Move datagenRandomMove(const Pos *pos, uint64_t *randState); // Returns MoveInvalid if no legal moves.
+unsigned int datagenGame(Search *search, Pos *pos, unsigned long long int nodes, PosPacked *records, unsigned int *result); // Returns number of records (with result set), result as for PosPacked.
+void datagenSearch(Search *search, const Pos *pos, unsigned long long int nodes, DatagenSearch *result);
+void datagenSearchDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void datagen(unsigned int games, unsigned long long int nodes, const char *path, unsigned int randomPlies, uint64_t seed, unsigned int threads) {
+	threads=utilMax(1u, utilMin(threads, (unsigned int)DatagenThreadsMax));
+
+	DatagenShared shared;
+	memset(&shared, 0, sizeof(shared));
+	shared.games=games;
+	shared.nodes=nodes;
+	shared.randomPlies=randomPlies;
+	if ((shared.lock=lockNew(1))==NULL) {
+		uciWrite("Error: Out of memory.\n");
+		return;
+	}
+
+	// Set up each worker with its own search context, random number sequence and output file (path itself if only one).
+	DatagenWork work[DatagenThreadsMax];
+	unsigned int workCount;
+	for(workCount=0;workCount<threads;++workCount) {
+		DatagenWork *w=&work[workCount];
+		memset(w, 0, sizeof(DatagenWork));
+		w->shared=&shared;
+		w->randState=seed+workCount*0x9E3779B97F4A7C15llu;
+		w->path=malloc(strlen(path)+16);
+		if (w->path!=NULL) {
+			if (threads>1)
+				sprintf(w->path, "%s.%u", path, workCount);
+			else
+				strcpy(w->path, path);
+			w->writer=packedWriterNew(w->path, true);
+		}
+		w->search=searchNew();
+		w->pos=posNew(NULL);
+		w->records=malloc(DatagenMaxPlies*sizeof(PosPacked));
+		if (w->path==NULL || w->writer==NULL || w->search==NULL || w->pos==NULL || w->records==NULL) {
+			if (w->path!=NULL && w->writer==NULL)
+				uciWrite("Error: Could not open '%s'.\n", w->path);
+			else
+				uciWrite("Error: Could not allocate memory.\n");
+			++workCount; // So this worker is also cleaned up below.
+			shared.error=true;
+			break;
+		}
+	}
+
+	// Play games in parallel.
+	if (!shared.error) {
+		shared.startTime=timeGet();
+		Thread *workers[DatagenThreadsMax];
+		for(unsigned int i=0;i<workCount;++i) {
+			workers[i]=threadNew();
+			if (workers[i]==NULL)
+				datagenWorker(&work[i]);
+			else
+				threadRun(workers[i], &datagenWorker, &work[i]);
+		}
+		for(unsigned int i=0;i<workCount;++i)
+			threadFree(workers[i]); // Waits for the thread to finish.
+	}
+
+	// Clean up.
+	for(unsigned int i=0;i<workCount;++i) {
+		DatagenWork *w=&work[i];
+		if (w->writer!=NULL && !packedWriterFree(w->writer))
+			uciWrite("Error: Could not write to '%s'.\n", w->path);
+		searchFree(w->search);
+		if (w->pos!=NULL)
+			posFree(w->pos);
+		free(w->records);
+		free(w->path);
+	}
+	lockFree(shared.lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void datagenWorker(void *userData) {
+	DatagenWork *work=(DatagenWork *)userData;
+	DatagenShared *shared=work->shared;
+
+	unsigned int ownGames=0;
+	while(1) {
+		// Claim next game (unless finished or another worker failed).
+		lockWait(shared->lock);
+		bool finished=(shared->error || (shared->games>0 && shared->nextGame>=shared->games));
+		if (!finished)
+			++shared->nextGame;
+		lockPost(shared->lock);
+		if (finished)
+			break;
+
+		// Randomised opening (retrying if the game ends within it).
+		do {
+			posSetToFEN(work->pos, NULL);
+		} while(!datagenOpening(work->pos, shared->randomPlies, &work->randState));
+
+		// Play out game and store positions.
+		searchClear(work->search);
+		unsigned int result;
+		unsigned int count=datagenGame(work->search, work->pos, shared->nodes, work->records, &result);
+		bool error=false;
+		for(unsigned int i=0;i<count && !error;++i)
+			error=!packedWriterWrite(work->writer, &work->records[i]);
+		++ownGames;
+		if (!error && (ownGames%DatagenFlushGames==0))
+			error=!packedWriterFlush(work->writer);
+
+		// Update totals and report progress every so often.
+		lockWait(shared->lock);
+		if (error) {
+			uciWrite("Error: Could not write to '%s'.\n", work->path);
+			shared->error=true;
+		} else {
+			shared->positionCount+=count;
+			++shared->results[result];
+			++shared->gamesDone;
+			if (shared->gamesDone%DatagenFlushGames==0 || shared->gamesDone==shared->games) {
+				TimeMs time=timeGet()-shared->startTime;
+				uciWrite("games %u (+%u =%u -%u) positions %llu time %llus positions/hour %llu\n", shared->gamesDone, shared->results[2], shared->results[1],
+				         shared->results[0], shared->positionCount, time/1000, (time>0 ? (shared->positionCount*3600000llu)/time : 0));
+			}
+		}
+		lockPost(shared->lock);
+		if (error)
+			break;
+	}
+}
+
+bool datagenOpening(Pos *pos, unsigned int randomPlies, uint64_t *randState) {
+	for(unsigned int ply=0;ply<randomPlies;++ply) {
+		Move move=datagenRandomMove(pos, randState);
+		if (move==MoveInvalid)
+			return false;
+		posMakeMove(pos, move);
+	}
+	return (posLegalMoveExists(pos, MoveTypeAny) && !posIsDraw(pos));
+}
+
+Move datagenRandomMove(const Pos *pos, uint64_t *randState) {
+	Moves moves;
+	movesInitBulk(&moves, pos);
+	unsigned int count=movesGetCount(&moves);
+	if (count==0)
+		return MoveInvalid;
+
+	unsigned int choice=utilRand64R(randState)%count;
+	Move move;
+	while((move=movesNext(&moves))!=MoveInvalid && choice>0)
+		--choice;
+	return move;
+}
+
+unsigned int datagenGame(Search *search, Pos *pos, unsigned long long int nodes, PosPacked *records, unsigned int *result) {
+	unsigned int count=0, winPlies=0, lossPlies=0;
+	*result=1;
+	for(unsigned int ply=0;;++ply) {
+		// Game over?
+		if (!posLegalMoveExists(pos, MoveTypeAny)) {
+			if (posIsSTMInCheck(pos))
+				*result=(posGetSTM(pos)==ColourWhite ? 0 : 2);
+			break;
+		}
+		if (posIsDraw(pos) || ply>=DatagenMaxPlies)
+			break;
+
+		// Search.
+		DatagenSearch searchResult;
+		datagenSearch(search, pos, nodes, &searchResult);
+
+		// Adjudicate long-lasting large scores as wins (counting consecutive plies from white's point of view).
+		Score whiteScore=(posGetSTM(pos)==ColourWhite ? searchResult.score : -searchResult.score);
+		winPlies=(whiteScore>=DatagenAdjudicateScore ? winPlies+1 : 0);
+		lossPlies=(whiteScore<=-DatagenAdjudicateScore ? lossPlies+1 : 0);
+		if (winPlies>=DatagenAdjudicatePlies || lossPlies>=DatagenAdjudicatePlies) {
+			*result=(winPlies>=DatagenAdjudicatePlies ? 2 : 0);
+			break;
+		}
+
+		// Record quiet positions.
+		if (!posIsSTMInCheck(pos) && posMoveGetType(pos, searchResult.bestMove)==MoveTypeQuiet && !scoreIsMate(searchResult.score) && count<DatagenMaxPlies) {
+			posToPacked(pos, &records[count]);
+			records[count].score=searchResult.score;
+			++count;
+		}
+
+		posMakeMove(pos, searchResult.bestMove);
+	}
+
+	for(unsigned int i=0;i<count;++i)
+		records[i].result=*result;
+	return count;
+}
+
+void datagenSearch(Search *search, const Pos *pos, unsigned long long int nodes, DatagenSearch *result) {
+	result->score=0;
+	result->bestMove=MoveInvalid;
+
+	SearchLimit limit;
+	searchLimitInit(&limit, timeGet());
+	searchLimitSetNodes(&limit, nodes);
+	searchRun(search, pos, &limit, &datagenSearchDepthCallback, result);
+
+	// Node limit too small to complete an iteration?
+	if (!moveIsValid(result->bestMove) || !posCanMakeMove(pos, result->bestMove)) {
+		result->score=evaluate(searchGetEval(search), pos);
+		result->bestMove=posGenLegalMove(pos, MoveTypeAny);
+	}
+}
+
+void datagenSearchDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time) {
+	DatagenSearch *result=(DatagenSearch *)userData;
+	if (pvLength==0)
+		return;
+	result->score=score;
+	result->bestMove=pv[0];
+}
@@ -0,0 +1,17 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <stdint.h>
+
+#include "pos.h"
+
+// Self-play training data generation. Each game starts from the initial position with randomPlies random legal moves,
+// then each side searches a fixed number of nodes per move. Quiet positions (side to move not in check, best move neither
+// a capture nor a promotion, non-mate score) are appended to the file at path as PosPacked records once the game result
+// is known, with score set to the search score (side to move's point of view) and result to the game result for white
+// (0 loss, 1 draw, 2 win). games of 0 plays until interrupted.
+// Games are shared between the given number of threads, each with its own search context, random openings (derived
+// from seed) and output file (path with '.N' appended for thread N, unless only one).
+void datagen(unsigned int games, unsigned long long int nodes, const char *path, unsigned int randomPlies, uint64_t seed, unsigned int threads);
+
+#endif
@@ -0,0 +1,401 @@
+#include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "epd.h"
+#include "search.h"
+#include "thread.h"
+#include "uci.h"
+#include "util.h"
+
+typedef struct {
+	const Epd *epd;
+	Depth depth, solvedDepth; // solvedDepth is DepthInvalid unless all iterations since it have returned a solution.
+	Move bestMove;
+	TimeMs solvedTime;
+	unsigned long long int solvedNodes;
+} EpdProgress;
+
+#define EpdSuiteThreadsMax 64
+
+typedef struct {
+	char *line;
+	unsigned int lineNumber;
+	char *output; // Report, written (in input order) once done.
+	size_t outputSize;
+	bool done;
+} EpdSuiteLine;
+
+typedef struct {
+	TimeMs moveTime;
+	Depth depth;
+	unsigned long long int nodes;
+	EpdSuiteLine *lines;
+	unsigned int lineCount;
+
+	Lock *lock; // Protects the fields below, and the done flag and output of each line.
+	unsigned int nextLine, writeLine;
+	unsigned int solvedCount, failCount;
+	TimeMs totalTime, solvedTime;
+	unsigned long long int totalNodes, solvedNodes;
+} EpdSuiteShared;
+
+typedef struct {
+	EpdSuiteShared *shared;
+	Search *search; // Each worker searches with its own context.
+	Pos *pos;
+} EpdSuiteWork;
+
+typedef struct {
+	bool counted, solved; // Skipped lines are not counted.
+	TimeMs time, solvedTime;
+	unsigned long long int nodes, solvedNodes;
+} EpdSuiteResult;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+bool epdParseMoves(char *operands, const Pos *pos, Move *moves, unsigned int *count);
+bool epdMoveInList(Move move, const Move *moves, unsigned int count);
+
+bool epdSuiteLoad(const char *path, EpdSuiteShared *shared); // Returns false on failure (after reporting it).
+void epdSuiteWorker(void *userData);
+void epdSuiteLine(EpdSuiteWork *work, const EpdSuiteLine *entry, FILE *out, EpdSuiteResult *result);
+void epdSuiteDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+bool epdParse(const char *line, Pos *pos, Epd *epd) {
+	// Copy line so we can modify it.
+	char buffer[1024];
+	if (strlen(line)>=sizeof(buffer))
+		return false;
+	strcpy(buffer, line);
+	buffer[strcspn(buffer, "\r\n")]='\0';
+
+	// Format is: board stm castling ep [halfmove fullmove] opcode operands; opcode operands; ...
+	// So find the end of the FEN fields (counters are only taken if numeric).
+	char *end=buffer;
+	for(unsigned int i=0;i<6;++i) {
+		char *field=end+strspn(end, " \t");
+		if (*field=='\0' || (i>=4 && !isdigit(*field)))
+			break;
+		end=field+strcspn(field, " \t");
+	}
+	char *ops=(*end!='\0' ? end+1 : end);
+	*end='\0';
+	if (!posSetToFEN(pos, buffer))
+		return false;
+
+	// Parse opcodes we care about.
+	epd->bestMoveCount=epd->avoidMoveCount=0;
+	epd->id[0]='\0';
+	char *opSavePtr, *op;
+	for(op=strtok_r(ops, ";", &opSavePtr);op!=NULL;op=strtok_r(NULL, ";", &opSavePtr)) {
+		op+=strspn(op, " \t");
+		char *operands=op+strcspn(op, " \t");
+		if (*operands!='\0')
+			*operands++='\0';
+		operands+=strspn(operands, " \t");
+
+		if (utilStrEqual(op, "bm")) {
+			if (!epdParseMoves(operands, pos, epd->bestMoves, &epd->bestMoveCount))
+				return false;
+		} else if (utilStrEqual(op, "am")) {
+			if (!epdParseMoves(operands, pos, epd->avoidMoves, &epd->avoidMoveCount))
+				return false;
+		} else if (utilStrEqual(op, "id")) {
+			// Strip quotes and trailing space.
+			if (*operands=='"')
+				++operands;
+			size_t len=strcspn(operands, "\"");
+			while(len>0 && isspace(operands[len-1]))
+				--len;
+			len=utilMin(len, (size_t)EpdIdMax-1);
+			memcpy(epd->id, operands, len);
+			epd->id[len]='\0';
+		}
+	}
+
+	return true;
+}
+
+bool epdMoveIsSolution(const Epd *epd, Move move) {
+	if (!moveIsValid(move))
+		return false;
+	if (epd->bestMoveCount>0 && !epdMoveInList(move, epd->bestMoves, epd->bestMoveCount))
+		return false;
+	return !epdMoveInList(move, epd->avoidMoves, epd->avoidMoveCount);
+}
+
+void epdSuite(const char *path, TimeMs moveTime, Depth depth, unsigned long long int nodes, unsigned int threads) {
+	threads=utilMax(1u, utilMin(threads, (unsigned int)EpdSuiteThreadsMax));
+
+	EpdSuiteShared shared;
+	memset(&shared, 0, sizeof(shared));
+	shared.moveTime=moveTime;
+	shared.depth=depth;
+	shared.nodes=nodes;
+
+	// Read lines (skipping blank lines and comments).
+	if (!epdSuiteLoad(path, &shared))
+		return;
+
+	// Create a search context and position for each worker.
+	EpdSuiteWork work[EpdSuiteThreadsMax];
+	unsigned int workCount=0;
+	if ((shared.lock=lockNew(1))==NULL)
+		uciWrite("Error: Out of memory.\n");
+	while(shared.lock!=NULL && workCount<threads) {
+		EpdSuiteWork *w=&work[workCount];
+		w->shared=&shared;
+		w->search=searchNew();
+		w->pos=posNew(NULL);
+		if (w->search==NULL || w->pos==NULL) {
+			searchFree(w->search);
+			if (w->pos!=NULL)
+				posFree(w->pos);
+			if (workCount==0)
+				uciWrite("Error: Could not allocate search.\n");
+			else
+				uciWrite("Error: Could only allocate %u of %u searches.\n", workCount, threads);
+			break;
+		}
+		++workCount;
+	}
+
+	// Run lines in parallel.
+	Thread *workers[EpdSuiteThreadsMax];
+	for(unsigned int i=0;i<workCount;++i) {
+		workers[i]=threadNew();
+		if (workers[i]==NULL)
+			epdSuiteWorker(&work[i]);
+		else
+			threadRun(workers[i], &epdSuiteWorker, &work[i]);
+	}
+	for(unsigned int i=0;i<workCount;++i) {
+		threadFree(workers[i]); // Waits for the thread to finish.
+		searchFree(work[i].search);
+		posFree(work[i].pos);
+	}
+
+	// Summary.
+	if (workCount>0) {
+		unsigned int count=shared.solvedCount+shared.failCount;
+		uciWrite("Suite: %u/%u solved", shared.solvedCount, count);
+		if (shared.solvedCount>0)
+			uciWrite(", to solution: average time %llums, average nodes %llu", shared.solvedTime/shared.solvedCount, shared.solvedNodes/shared.solvedCount);
+		uciWrite(", total time %llu.%03llus, total nodes %llu\n", shared.totalTime/1000, shared.totalTime%1000, shared.totalNodes);
+	}
+
+	for(unsigned int i=0;i<shared.lineCount;++i) {
+		free(shared.lines[i].line);
+		free(shared.lines[i].output);
+	}
+	free(shared.lines);
+	lockFree(shared.lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+bool epdParseMoves(char *operands, const Pos *pos, Move *moves, unsigned int *count) {
+	char *savePtr, *part;
+	for(part=strtok_r(operands, " \t", &savePtr);part!=NULL;part=strtok_r(NULL, " \t", &savePtr)) {
+		if (*count>=EpdMovesMax)
+			return false;
+
+		// Accept SAN and, as a fallback, coordinate notation.
+		Move move=posMoveFromSan(pos, part);
+		if (move==MoveInvalid && strlen(part)<6) {
+			char str[6];
+			strcpy(str, part);
+			move=posMoveFromStr(pos, str);
+		}
+		if (move==MoveInvalid)
+			return false;
+		moves[(*count)++]=move;
+	}
+	return true;
+}
+
+bool epdMoveInList(Move move, const Move *moves, unsigned int count) {
+	for(unsigned int i=0;i<count;++i)
+		if (moves[i]==move)
+			return true;
+	return false;
+}
+
+bool epdSuiteLoad(const char *path, EpdSuiteShared *shared) {
+	FILE *file=fopen(path, "r");
+	if (file==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", path);
+		return false;
+	}
+
+	char *line=NULL;
+	size_t lineSize=0;
+	unsigned int lineNumber=0;
+	bool success=true;
+	while(getline(&line, &lineSize, file)>=0) {
+		++lineNumber;
+
+		// Skip blank lines and comments.
+		char *c=line+strspn(line, " \t\r\n");
+		if (*c=='\0' || *c=='#')
+			continue;
+
+		EpdSuiteLine *newLines=realloc(shared->lines, (shared->lineCount+1)*sizeof(EpdSuiteLine));
+		char *copy=malloc(strlen(c)+1);
+		if (newLines!=NULL)
+			shared->lines=newLines;
+		if (newLines==NULL || copy==NULL) {
+			free(copy);
+			success=false;
+			break;
+		}
+		strcpy(copy, c);
+		EpdSuiteLine *entry=&shared->lines[shared->lineCount++];
+		entry->line=copy;
+		entry->lineNumber=lineNumber;
+		entry->output=NULL;
+		entry->outputSize=0;
+		entry->done=false;
+	}
+	free(line);
+	fclose(file);
+
+	if (!success) {
+		uciWrite("Error: Could not allocate memory.\n");
+		for(unsigned int i=0;i<shared->lineCount;++i)
+			free(shared->lines[i].line);
+		free(shared->lines);
+		shared->lines=NULL;
+		shared->lineCount=0;
+	}
+	return success;
+}
+
+void epdSuiteWorker(void *userData) {
+	EpdSuiteWork *work=(EpdSuiteWork *)userData;
+	EpdSuiteShared *shared=work->shared;
+
+	while(1) {
+		// Claim next line.
+		lockWait(shared->lock);
+		unsigned int index=shared->nextLine;
+		if (index<shared->lineCount)
+			++shared->nextLine;
+		lockPost(shared->lock);
+		if (index>=shared->lineCount)
+			break;
+
+		// Run it, writing the report to a buffer.
+		EpdSuiteLine *entry=&shared->lines[index];
+		EpdSuiteResult result={.counted=false, .solved=false};
+		FILE *out=open_memstream(&entry->output, &entry->outputSize);
+		if (out!=NULL) {
+			epdSuiteLine(work, entry, out, &result);
+			fclose(out);
+		}
+
+		// Update totals and write any reports which are now next in line.
+		lockWait(shared->lock);
+		if (out==NULL)
+			uciWrite("Error: Out of memory.\n");
+		if (result.counted) {
+			shared->totalTime+=result.time;
+			shared->totalNodes+=result.nodes;
+			if (result.solved) {
+				++shared->solvedCount;
+				shared->solvedTime+=result.solvedTime;
+				shared->solvedNodes+=result.solvedNodes;
+			} else
+				++shared->failCount;
+		}
+		entry->done=true;
+		for(;shared->writeLine<shared->lineCount && shared->lines[shared->writeLine].done;++shared->writeLine) {
+			EpdSuiteLine *next=&shared->lines[shared->writeLine];
+			if (next->output!=NULL)
+				uciWrite("%s", next->output);
+			free(next->output);
+			next->output=NULL;
+		}
+		lockPost(shared->lock);
+	}
+}
+
+void epdSuiteLine(EpdSuiteWork *work, const EpdSuiteLine *entry, FILE *out, EpdSuiteResult *result) {
+	const EpdSuiteShared *shared=work->shared;
+	Pos *pos=work->pos;
+
+	Epd epd;
+	if (!epdParse(entry->line, pos, &epd)) {
+		fprintf(out, "%4u FAIL bad epd '%.*s'\n", entry->lineNumber, (int)strcspn(entry->line, "\r\n"), entry->line);
+		result->counted=true;
+		return;
+	}
+	if (epd.bestMoveCount==0 && epd.avoidMoveCount==0) {
+		fprintf(out, "%4u skip no bm or am opcode\n", entry->lineNumber);
+		return;
+	}
+
+	// Search from a clean state, following the best move of each iteration.
+	EpdProgress progress={.epd=&epd, .depth=DepthInvalid, .solvedDepth=DepthInvalid, .bestMove=MoveInvalid};
+	searchClear(work->search);
+	SearchLimit limit;
+	searchLimitInit(&limit, timeGet());
+	if (shared->moveTime!=TimeMsInvalid)
+		searchLimitSetMoveTime(&limit, shared->moveTime);
+	if (shared->depth!=DepthInvalid)
+		searchLimitSetDepth(&limit, shared->depth);
+	if (shared->nodes>0)
+		searchLimitSetNodes(&limit, shared->nodes);
+	TimeMs time=timeGet();
+	searchRun(work->search, pos, &limit, &epdSuiteDepthCallback, &progress);
+	time=timeGet()-time;
+
+	// Report.
+	result->counted=true;
+	result->time=time;
+	result->nodes=searchGetNodeCount(work->search);
+	const char *id=(epd.id[0]!='\0' ? epd.id : "-");
+	char san[8];
+	posMoveToSan(pos, progress.bestMove, san);
+	if (progress.solvedDepth!=DepthInvalid) {
+		result->solved=true;
+		result->solvedTime=progress.solvedTime;
+		result->solvedNodes=progress.solvedNodes;
+		fprintf(out, "%4u solved %-16s %-7s depth %2u time %6llu nodes %10llu\n", entry->lineNumber, id, san, (unsigned int)progress.solvedDepth,
+		        progress.solvedTime, progress.solvedNodes);
+	} else {
+		fprintf(out, "%4u FAIL   %-16s %-7s", entry->lineNumber, id, san);
+		for(unsigned int i=0;i<epd.bestMoveCount;++i)
+			fprintf(out, " %s%s", (i==0 ? "bm " : ""), POSMOVETOSAN(pos, epd.bestMoves[i]));
+		for(unsigned int i=0;i<epd.avoidMoveCount;++i)
+			fprintf(out, " %s%s", (i==0 ? "am " : ""), POSMOVETOSAN(pos, epd.avoidMoves[i]));
+		fprintf(out, "\n");
+	}
+}
+
+void epdSuiteDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time) {
+	EpdProgress *progress=(EpdProgress *)userData;
+	Move bestMove=(pvLength>0 ? pv[0] : MoveInvalid);
+	progress->depth=depth;
+	progress->bestMove=bestMove;
+
+	// Solution found and held since then?
+	if (!epdMoveIsSolution(progress->epd, bestMove))
+		progress->solvedDepth=DepthInvalid;
+	else if (progress->solvedDepth==DepthInvalid) {
+		progress->solvedDepth=depth;
+		progress->solvedTime=time;
+		progress->solvedNodes=nodes;
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include <stdbool.h>
+
+#include "depth.h"
+#include "move.h"
+#include "pos.h"
+#include "time.h"
+
+#define EpdMovesMax 16
+#define EpdIdMax 64
+
+typedef struct {
+	Move bestMoves[EpdMovesMax], avoidMoves[EpdMovesMax]; // From 'bm' and 'am' opcodes.
+	unsigned int bestMoveCount, avoidMoveCount;
+	char id[EpdIdMax]; // From 'id' opcode, empty if none.
+} Epd;
+
+bool epdParse(const char *line, Pos *pos, Epd *epd); // Sets pos from the four FEN fields (plus optional move counters) and collects the opcodes we understand. On failure pos may still have been changed.
+bool epdMoveIsSolution(const Epd *epd, Move move); // In bm (if given) and not in am.
+
+// Searches each position of the EPD file at path with the given limit (moveTime/depth/nodes of TimeMsInvalid/DepthInvalid/0 for no limit),
+// reporting for each whether the final best move is a solution and from which iteration it was first found and held.
+// Positions are shared between the given number of threads, each with its own search context, with reports still
+// written in file order.
+void epdSuite(const char *path, TimeMs moveTime, Depth depth, unsigned long long int nodes, unsigned int threads);
+
+#endif
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <math.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,10 +20,13 @@ const VPair VPairZero={0,0};
 typedef struct EvalData EvalData;
 
 typedef struct {
-	BB pawns[ColourNB], passed[ColourNB], semiOpenFiles[ColourNB], openFiles;
-	VPair score;
+	BB pawns[ColourNB], passed[ColourNB];
+	VPacked score;
+	VPacked kingScore[ColourNB]; // King shelter and passer proximity terms for a king of the given colour on kingSq[colour].
+	uint8_t kingSq[ColourNB]; // SqInvalid if kingScore has not been computed.
+	uint8_t padding[6];
 } EvalPawnData;
-HTable *evalPawnTable=NULL;
+STATICASSERT(sizeof(EvalPawnData)==64); // Single cache line.
 const size_t evalPawnTableDefaultSizeMb=1;
 #define evalPawnTableMaxSizeMb ((HTableMaxEntryCount*sizeof(EvalPawnData))/(1024*1024)) // 256gb
 
@@ -30,7 +34,7 @@ STATICASSERT(ScoreBit<=16);
 STATICASSERT(EvalMatTypeBit<=8);
 typedef struct {
 	Key key;
-	VPair offset;
+	VPacked offset;
 	int16_t scoreOffset;
 	uint8_t weightMG, weightEG;
 	uint8_t type; // If this is EvalMatTypeInvalid implies all fields not yet computed. Otherwise mat must also be set.
@@ -38,12 +42,47 @@ typedef struct {
 	uint8_t padding[2];
 } EvalMatData;
 
-HTable *evalMatTable=NULL;
 const size_t evalMatTableDefaultSizeMb=1;
 #define evalMatTableMaxSizeMb ((HTableMaxEntryCount*sizeof(EvalMatData))/(1024*1024)) // 96gb
 
+typedef struct {
+	unsigned long long int pawnProbes, pawnHits;
+	unsigned long long int kingProbes, kingHits;
+} EvalStats;
+
+typedef struct {
+	VPair material[PieceTypeNB];
+	VPair pstParams[PieceTypeNB][3];
+	VPair pawnCentre, pawnOuterCentre;
+	VPair pawnDoubled, pawnIsolated, pawnBlocked;
+	VPair pawnPassedQuadA, pawnPassedQuadB, pawnPassedQuadC; // Coefficients used in quadratic formula for passed pawn score (with rank as the input).
+	VPair knightMob;
+	VPair knightPawnAffinity; // Bonus each knight receives for each friendly pawn on the board.
+	VPair bishopPair, bishopMob;
+	VPair oppositeBishopFactor; // /256.
+	VPair rookPawnAffinity; // Bonus each rook receives for each friendly pawn on the board.
+	VPair rookMobFile, rookMobRank;
+	VPair rookOpenFile, rookSemiOpenFile, rookOn7th, rookTrapped;
+	VPair kingShieldClose, kingShieldFar, kingNearPasserFactor, kingCastlingMobility;
+	VPair tempoDefault;
+	Value halfMoveFactor, weightFactor;
+} EvalParams;
+
+struct Eval {
+	HTable *pawnTable, *matTable;
+	EvalStats stats;
+#	ifdef TUNE
+	EvalParams *params; // Either &evalParams (shared with the UCI options) or owned by this context after evalSetOption().
+	EvalTables *tables; // Derived from params (so similarly either &evalTables or owned).
+	unsigned int generation; // Value of evalGeneration when the hash tables were last cleared.
+#	endif
+};
+
 struct EvalData {
 	const Pos *pos;
+	Eval *eval;
+	const EvalParams *params;
+	const EvalTables *tables;
 	EvalPawnData pawnData;
 	EvalMatData matData;
 };
@@ -52,58 +91,62 @@ struct EvalData {
 // Tunable values.
 ////////////////////////////////////////////////////////////////////////////////
 
-TUNECONST VPair evalMaterial[PieceTypeNB]={
-	[PieceTypeNone]={0,0},
-	[PieceTypePawn]={793,1124},
-	[PieceTypeKnight]={2956,2370},
-	[PieceTypeBishopL]={3241,3207},
-	[PieceTypeBishopD]={3241,3207},
-	[PieceTypeRook]={5072,4185},
-	[PieceTypeQueen]={8975,10143},
-	[PieceTypeKing]={600,-460} // these values exist soley to make PSTs look nicer (both sides always have exactly one king of course)
+TUNECONST EvalParams evalParams={
+	.material={
+		[PieceTypeNone]={0,0},
+		[PieceTypePawn]={793,1124},
+		[PieceTypeKnight]={2956,2370},
+		[PieceTypeBishopL]={3241,3207},
+		[PieceTypeBishopD]={3241,3207},
+		[PieceTypeRook]={5072,4185},
+		[PieceTypeQueen]={8975,10143},
+		[PieceTypeKing]={600,-460} // these values exist soley to make PSTs look nicer (both sides always have exactly one king of course)
+	},
+	.pstParams={
+		[PieceTypePawn]={{50,33}, {-23,-15}, {10,25}},
+		[PieceTypeKnight]={{37,16}, {39,27}, {36,0}},
+		[PieceTypeBishopL]={{14,9}, {14,9}, {0,0}},
+		[PieceTypeBishopD]={{14,9}, {14,9}, {0,0}},
+		[PieceTypeRook]={{26,0}, {0,0}, {0,16}},
+		[PieceTypeQueen]={{0,0}, {-14,0}, {14,0}},
+		[PieceTypeKing]={{-243,120}, {-250,120}, {-50,0}},
+	},
+	.pawnCentre={163,0},
+	.pawnOuterCentre={50,0},
+	.pawnDoubled={-74,-190},
+	.pawnIsolated={-270,-168},
+	.pawnBlocked={-22,-100},
+	.pawnPassedQuadA={56,46},
+	.pawnPassedQuadB={-125,-100},
+	.pawnPassedQuadC={90,150},
+	.knightMob={21,18},
+	.knightPawnAffinity={30,32},
+	.bishopPair={500,489},
+	.bishopMob={38,32},
+	.oppositeBishopFactor={256,192},
+	.rookPawnAffinity={-70,-70},
+	.rookMobFile={20,30},
+	.rookMobRank={10,20},
+	.rookOpenFile={100,50},
+	.rookSemiOpenFile={50,20},
+	.rookOn7th={50,100},
+	.rookTrapped={-400,0},
+	.kingShieldClose={150,0},
+	.kingShieldFar={50,0},
+	.kingNearPasserFactor={0,200},
+	.kingCastlingMobility={100,0},
+	.tempoDefault={35,0},
+	.halfMoveFactor=2048,
+	.weightFactor=151,
 };
-TUNECONST VPair evalPstParams[PieceTypeNB][3]={
-	[PieceTypePawn]={{50,33}, {-23,-15}, {10,25}},
-	[PieceTypeKnight]={{37,16}, {39,27}, {36,0}},
-	[PieceTypeBishopL]={{14,9}, {14,9}, {0,0}},
-	[PieceTypeBishopD]={{14,9}, {14,9}, {0,0}},
-	[PieceTypeRook]={{26,0}, {0,0}, {0,16}},
-	[PieceTypeQueen]={{0,0}, {-14,0}, {14,0}},
-	[PieceTypeKing]={{-243,120}, {-250,120}, {-50,0}},
-};
-TUNECONST VPair evalPawnCentre={163,0};
-TUNECONST VPair evalPawnOuterCentre={50,0};
-TUNECONST VPair evalPawnDoubled={-74,-190};
-TUNECONST VPair evalPawnIsolated={-270,-168};
-TUNECONST VPair evalPawnBlocked={-22,-100};
-TUNECONST VPair evalPawnPassedQuadA={56,46}; // Coefficients used in quadratic formula for passed pawn score (with rank as the input).
-TUNECONST VPair evalPawnPassedQuadB={-125,-100};
-TUNECONST VPair evalPawnPassedQuadC={90,150};
-TUNECONST VPair evalKnightMob={21,18};
-TUNECONST VPair evalKnightPawnAffinity={30,32}; // Bonus each knight receives for each friendly pawn on the board.
-TUNECONST VPair evalBishopPair={500,489};
-TUNECONST VPair evalBishopMob={38,32};
-TUNECONST VPair evalOppositeBishopFactor={256,192}; // /256.
-TUNECONST VPair evalRookPawnAffinity={-70,-70}; // Bonus each rook receives for each friendly pawn on the board.
-TUNECONST VPair evalRookMobFile={20,30};
-TUNECONST VPair evalRookMobRank={10,20};
-TUNECONST VPair evalRookOpenFile={100,50};
-TUNECONST VPair evalRookSemiOpenFile={50,20};
-TUNECONST VPair evalRookOn7th={50,100};
-TUNECONST VPair evalRookTrapped={-400,0};
-TUNECONST VPair evalKingShieldClose={150,0};
-TUNECONST VPair evalKingShieldFar={50,0};
-TUNECONST VPair evalKingNearPasserFactor={0,200};
-TUNECONST VPair evalKingCastlingMobility={100,0};
-TUNECONST VPair evalTempoDefault={35,0};
-TUNECONST Value evalHalfMoveFactor=2048;
-TUNECONST Value evalWeightFactor=151;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Derived values
 ////////////////////////////////////////////////////////////////////////////////
 
-VPair evalPST[PieceNB][SqNB];
+#ifndef TABLES
+EvalTables evalTables;
+#endif
 
 typedef enum {
 	PawnTypeStandard=0,
@@ -115,45 +158,62 @@ typedef enum {
 	PawnTypePassed=(1u<<PawnTypeShiftPassed),
 	PawnTypeNB=16,
 } PawnType;
-VPair evalPawnValue[ColourNB][PawnTypeNB][SqNB];
-int evalHalfMoveFactors[128];
-uint8_t evalWeightEGFactors[128];
+STATICASSERT(PawnTypeNB==16); // See EvalTables.
 
-VPair evalKingNearPasser[8];
+#ifdef TUNE
+typedef struct {
+	char name[64];
+	size_t offset; // Of the Value within EvalParams.
+	Value min, max;
+} EvalOption;
+#define EvalOptionsMax 128
+EvalOption evalOptions[EvalOptionsMax];
+unsigned int evalOptionCount=0;
+
+unsigned int evalGeneration=0; // Incremented whenever evalParams are changed via the UCI options, so that contexts using them know to clear their hash tables.
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private prototypes.
 ////////////////////////////////////////////////////////////////////////////////
 
-Score evaluateInternal(const Pos *pos);
+Score evaluateInternal(Eval *eval, const Pos *pos);
 
-VPair evaluateDefault(EvalData *data);
-VPair evaluateKPvK(EvalData *data);
+VPacked evaluateDefault(EvalData *data);
+VPacked evaluateKPvK(EvalData *data);
 
-void evalGetMatData(const Pos *pos, EvalMatData *matData);
-void evalComputeMatData(const Pos *pos, EvalMatData *matData);
+void evalGetMatData(EvalData *data);
+void evalComputeMatData(const EvalData *data, EvalMatData *matData);
 HTableKey evalGetMatDataHTableKeyFromPos(const Pos *pos);
 
-void evalGetPawnData(const Pos *pos, EvalPawnData *pawnData);
-void evalComputePawnData(const Pos *pos, EvalPawnData *pawnData);
+void evalGetPawnData(EvalData *data);
+void evalComputePawnData(const EvalData *data, EvalPawnData *pawnData);
 HTableKey evalGetPawnDataHTableKeyFromPos(const Pos *pos);
 
-VPair evaluateDefaultGlobal(EvalData *data);
-VPair evaluateDefaultKing(EvalData *data, Colour colour);
+VPacked evaluateDefaultGlobal(EvalData *data);
+VPacked evaluateDefaultKing(EvalData *data, Colour colour);
+VPacked evalComputeKingScore(const EvalData *data, const EvalPawnData *pawnData, Colour colour, Sq kingSq);
+
+Score evalInterpolate(const EvalData *data, VPacked score);
 
-Score evalInterpolate(const EvalData *data, const VPair *score);
+VPacked evalComputePstScoreTables(const EvalTables *tables, const Pos *pos);
+
+const EvalParams *evalGetParams(const Eval *eval);
+const EvalTables *evalGetTables(const Eval *eval);
 
 #ifdef TUNE
 void evalSetValue(void *varPtr, long long value);
+void evalParamsSet(EvalParams *params, size_t offset, Value value); // Also keeps light and dark bishop values equal.
+bool evalOptionNew(const char *name, Value *value, Value min, Value max);
 bool evalOptionNewVPair(const char *name, VPair *score, Value min, Value max);
 bool evalOptionNewVPairF(const char *nameFormat, VPair *score, Value min, Value max, ...);
 #endif
 
-void evalRecalc(void);
-
-void evalVerify(void);
+#ifndef TABLES
+void evalRecalc(const EvalParams *params, EvalTables *tables);
+#endif
 
-EvalMatType evalComputeMatType(const Pos *pos);
+void evalVerify(const EvalParams *params, const EvalTables *tables);
 
 void evalPstDraw(PieceType type);
 
@@ -162,105 +222,191 @@ void evalPstDraw(PieceType type);
 ////////////////////////////////////////////////////////////////////////////////
 
 void evalInit(void) {
-	// Setup pawn hash table.
-	evalPawnTable=htableNew(sizeof(EvalPawnData), evalPawnTableDefaultSizeMb);
-	if (evalPawnTable==NULL)
-		mainFatalError("Error: Could not allocate pawn hash table.\n");
-	uciOptionNewSpin("PawnHash", &htableResizeInterface, evalPawnTable, 1, evalPawnTableMaxSizeMb, evalPawnTableDefaultSizeMb);
-	uciOptionNewButton("ClearPawnHash", &htableClearInterface, evalPawnTable);
-
-	// Setup mat hash table.
-	evalMatTable=htableNew(sizeof(EvalMatData), evalMatTableDefaultSizeMb);
-	if (evalMatTable==NULL)
-		mainFatalError("Error: Could not allocate mat hash table.\n");
-	uciOptionNewSpin("MatHash", &htableResizeInterface, evalMatTable, 1, evalMatTableMaxSizeMb, evalMatTableDefaultSizeMb);
-	uciOptionNewButton("ClearMatHash", &htableClearInterface, evalMatTable);
-
-	// Calculate dervied values (such as passed pawn table).
-	evalRecalc();
+	// Calculate dervied values (such as passed pawn table), unless these were
+	// generated at build time.
+#	ifdef TABLES
+	evalVerify(&evalParams, &evalTables);
+#	else
+	evalRecalc(&evalParams, &evalTables);
+#	endif
 
 	// Setup callbacks for tuning values.
 # ifdef TUNE
-	evalOptionNewVPair("Pawn", &evalMaterial[PieceTypePawn], 0, 2000);
-	evalOptionNewVPair("Knight", &evalMaterial[PieceTypeKnight], 0, 6000);
-	evalOptionNewVPair("Bishop", &evalMaterial[PieceTypeBishopL], 0, 6000);
-	evalOptionNewVPair("Rook", &evalMaterial[PieceTypeRook], 0, 10000);
-	evalOptionNewVPair("Queen", &evalMaterial[PieceTypeQueen], 0, 18000);
-	evalOptionNewVPair("PawnCentre", &evalPawnCentre, 0, 1000);
-	evalOptionNewVPair("PawnOuterCentre", &evalPawnOuterCentre, 0, 500);
-	evalOptionNewVPair("PawnDoubled", &evalPawnDoubled, -1000, 0);
-	evalOptionNewVPair("PawnIsolated", &evalPawnIsolated, -1000, 0);
-	evalOptionNewVPair("PawnBlocked", &evalPawnBlocked, -1000, 0);
-	evalOptionNewVPair("PawnPassedQuadA", &evalPawnPassedQuadA, 0, 100);
-	evalOptionNewVPair("PawnPassedQuadB", &evalPawnPassedQuadB, -400, 400);
-	evalOptionNewVPair("PawnPassedQuadC", &evalPawnPassedQuadC, -1000, 1000);
-	evalOptionNewVPair("KnightMob", &evalKnightMob, 0, 100);
-	evalOptionNewVPair("KnightPawnAffinity", &evalKnightPawnAffinity, -100, 100);
-	evalOptionNewVPair("BishopPair", &evalBishopPair, 0, 1000);
-	evalOptionNewVPair("BishopMobility", &evalBishopMob, 0, 100);
-	uciOptionNewSpin("OppositeBishopFactorMG", &evalSetValue, &evalOppositeBishopFactor.mg, 0, 512, evalOppositeBishopFactor.mg);
-	uciOptionNewSpin("OppositeBishopFactorEG", &evalSetValue, &evalOppositeBishopFactor.eg, 0, 512, evalOppositeBishopFactor.eg);
-	evalOptionNewVPair("RookPawnAffinity", &evalRookPawnAffinity, -200, 200);
-	evalOptionNewVPair("RookMobilityFile", &evalRookMobFile, 0, 50);
-	evalOptionNewVPair("RookMobilityRank", &evalRookMobRank, 0, 50);
-	evalOptionNewVPair("RookOpenFile", &evalRookOpenFile, -200, 200);
-	evalOptionNewVPair("RookSemiOpenFile", &evalRookSemiOpenFile, 0, 150);
-	evalOptionNewVPair("RookOn7th", &evalRookOn7th, -200, 200);
-	evalOptionNewVPair("RookTrapped", &evalRookTrapped, -3000, 0);
-	evalOptionNewVPair("KingShieldClose", &evalKingShieldClose, 0, 500);
-	evalOptionNewVPair("KingShieldFar", &evalKingShieldFar, 0, 300);
-	evalOptionNewVPair("KingNearPasser", &evalKingNearPasserFactor, 0, 500);
-	evalOptionNewVPair("KingCastlingMobility", &evalKingCastlingMobility, 0, 200);
-	evalOptionNewVPair("Tempo", &evalTempoDefault, 0, 100);
-	uciOptionNewSpin("HalfMoveFactor", &evalSetValue, &evalHalfMoveFactor, 1, 4096, evalHalfMoveFactor);
-	uciOptionNewSpin("WeightFactor", &evalSetValue, &evalWeightFactor, 1, 512, evalWeightFactor);
+	evalOptionNewVPair("Pawn", &evalParams.material[PieceTypePawn], 0, 2000);
+	evalOptionNewVPair("Knight", &evalParams.material[PieceTypeKnight], 0, 6000);
+	evalOptionNewVPair("Bishop", &evalParams.material[PieceTypeBishopL], 0, 6000);
+	evalOptionNewVPair("Rook", &evalParams.material[PieceTypeRook], 0, 10000);
+	evalOptionNewVPair("Queen", &evalParams.material[PieceTypeQueen], 0, 18000);
+	evalOptionNewVPair("PawnCentre", &evalParams.pawnCentre, 0, 1000);
+	evalOptionNewVPair("PawnOuterCentre", &evalParams.pawnOuterCentre, 0, 500);
+	evalOptionNewVPair("PawnDoubled", &evalParams.pawnDoubled, -1000, 0);
+	evalOptionNewVPair("PawnIsolated", &evalParams.pawnIsolated, -1000, 0);
+	evalOptionNewVPair("PawnBlocked", &evalParams.pawnBlocked, -1000, 0);
+	evalOptionNewVPair("PawnPassedQuadA", &evalParams.pawnPassedQuadA, 0, 100);
+	evalOptionNewVPair("PawnPassedQuadB", &evalParams.pawnPassedQuadB, -400, 400);
+	evalOptionNewVPair("PawnPassedQuadC", &evalParams.pawnPassedQuadC, -1000, 1000);
+	evalOptionNewVPair("KnightMob", &evalParams.knightMob, 0, 100);
+	evalOptionNewVPair("KnightPawnAffinity", &evalParams.knightPawnAffinity, -100, 100);
+	evalOptionNewVPair("BishopPair", &evalParams.bishopPair, 0, 1000);
+	evalOptionNewVPair("BishopMobility", &evalParams.bishopMob, 0, 100);
+	evalOptionNew("OppositeBishopFactorMG", &evalParams.oppositeBishopFactor.mg, 0, 512);
+	evalOptionNew("OppositeBishopFactorEG", &evalParams.oppositeBishopFactor.eg, 0, 512);
+	evalOptionNewVPair("RookPawnAffinity", &evalParams.rookPawnAffinity, -200, 200);
+	evalOptionNewVPair("RookMobilityFile", &evalParams.rookMobFile, 0, 50);
+	evalOptionNewVPair("RookMobilityRank", &evalParams.rookMobRank, 0, 50);
+	evalOptionNewVPair("RookOpenFile", &evalParams.rookOpenFile, -200, 200);
+	evalOptionNewVPair("RookSemiOpenFile", &evalParams.rookSemiOpenFile, 0, 150);
+	evalOptionNewVPair("RookOn7th", &evalParams.rookOn7th, -200, 200);
+	evalOptionNewVPair("RookTrapped", &evalParams.rookTrapped, -3000, 0);
+	evalOptionNewVPair("KingShieldClose", &evalParams.kingShieldClose, 0, 500);
+	evalOptionNewVPair("KingShieldFar", &evalParams.kingShieldFar, 0, 300);
+	evalOptionNewVPair("KingNearPasser", &evalParams.kingNearPasserFactor, 0, 500);
+	evalOptionNewVPair("KingCastlingMobility", &evalParams.kingCastlingMobility, 0, 200);
+	evalOptionNewVPair("Tempo", &evalParams.tempoDefault, 0, 100);
+	evalOptionNew("HalfMoveFactor", &evalParams.halfMoveFactor, 1, 4096);
+	evalOptionNew("WeightFactor", &evalParams.weightFactor, 1, 512);
 	for(PieceType type=PieceTypePawn;type<=PieceTypeQueen;++type) {
 		if (type==PieceTypeBishopD)
 			continue;
 		const char *typeStr=pieceTypeToStr(type);
-		evalOptionNewVPairF("Pst%sH", &evalPstParams[type][0], -200, 200, typeStr);
-		evalOptionNewVPairF("Pst%sV", &evalPstParams[type][1], -200, 200, typeStr);
-		evalOptionNewVPairF("Pst%sA", &evalPstParams[type][2], -200, 200, typeStr);
+		evalOptionNewVPairF("Pst%sH", &evalParams.pstParams[type][0], -200, 200, typeStr);
+		evalOptionNewVPairF("Pst%sV", &evalParams.pstParams[type][1], -200, 200, typeStr);
+		evalOptionNewVPairF("Pst%sA", &evalParams.pstParams[type][2], -200, 200, typeStr);
 	}
-	evalOptionNewVPairF("PstKingH", &evalPstParams[PieceTypeKing][0], -500, 500);
-	evalOptionNewVPairF("PstKingV", &evalPstParams[PieceTypeKing][1], -500, 500);
-	evalOptionNewVPairF("PstKingA", &evalPstParams[PieceTypeKing][2], -500, 500);
+	evalOptionNewVPairF("PstKingH", &evalParams.pstParams[PieceTypeKing][0], -500, 500);
+	evalOptionNewVPairF("PstKingV", &evalParams.pstParams[PieceTypeKing][1], -500, 500);
+	evalOptionNewVPairF("PstKingA", &evalParams.pstParams[PieceTypeKing][2], -500, 500);
 # endif
 }
 
-void evalQuit(void) {
-	htableFree(evalPawnTable);
-	evalPawnTable=NULL;
-	htableFree(evalMatTable);
-	evalMatTable=NULL;
+Eval *evalNew(void) {
+	// Allocate context and hash tables.
+	Eval *eval=malloc(sizeof(Eval));
+	if (eval==NULL)
+		return NULL;
+	eval->pawnTable=htableNew(sizeof(EvalPawnData), evalPawnTableDefaultSizeMb);
+	eval->matTable=htableNew(sizeof(EvalMatData), evalMatTableDefaultSizeMb);
+	if (eval->pawnTable==NULL || eval->matTable==NULL) {
+		if (eval->pawnTable!=NULL)
+			htableFree(eval->pawnTable);
+		if (eval->matTable!=NULL)
+			htableFree(eval->matTable);
+		free(eval);
+		return NULL;
+	}
+
+	// Use the UCI option weights until told otherwise.
+#	ifdef TUNE
+	eval->params=&evalParams;
+	eval->tables=&evalTables;
+#	endif
+
+	evalClear(eval);
+
+	return eval;
 }
 
-Score evaluate(const Pos *pos) {
-	Score score=evaluateInternal(pos);
+void evalFree(Eval *eval) {
+	if (eval==NULL)
+		return;
+
+#	ifdef TUNE
+	if (eval->params!=&evalParams) {
+		free(eval->params);
+		free(eval->tables);
+	}
+#	endif
+
+	htableFree(eval->pawnTable);
+	htableFree(eval->matTable);
+	free(eval);
+}
+
+void evalOptionsNew(Eval *eval) {
+	uciOptionNewSpin("PawnHash", &htableResizeInterface, eval->pawnTable, 1, evalPawnTableMaxSizeMb, evalPawnTableDefaultSizeMb);
+	uciOptionNewButton("ClearPawnHash", &htableClearInterface, eval->pawnTable);
+	uciOptionNewSpin("MatHash", &htableResizeInterface, eval->matTable, 1, evalMatTableMaxSizeMb, evalMatTableDefaultSizeMb);
+	uciOptionNewButton("ClearMatHash", &htableClearInterface, eval->matTable);
+}
+
+bool evalSetOption(Eval *eval, const char *name, const char *value) {
+	// Hash table sizes.
+	if (utilStrEqual(name, "PawnHash"))
+		return htableResize(eval->pawnTable, utilMax(atoi(value), 1));
+	if (utilStrEqual(name, "MatHash"))
+		return htableResize(eval->matTable, utilMax(atoi(value), 1));
+
+	// Weights.
+#	ifdef TUNE
+	for(unsigned int i=0; i<evalOptionCount; ++i) {
+		const EvalOption *option=&evalOptions[i];
+		if (!utilStrEqual(name, option->name))
+			continue;
+
+		// Take a private copy of the weights (and derived tables) if still sharing the UCI option values.
+		if (eval->params==&evalParams) {
+			EvalParams *params=malloc(sizeof(EvalParams));
+			EvalTables *tables=malloc(sizeof(EvalTables));
+			if (params==NULL || tables==NULL) {
+				free(params);
+				free(tables);
+				return false;
+			}
+			*params=evalParams;
+			eval->params=params;
+			eval->tables=tables;
+		}
+
+		// Set value and recalculate derived tables (clearing now-invalid hash data).
+		evalParamsSet(eval->params, option->offset, utilMin(utilMax((Value)atoll(value), option->min), option->max));
+		evalRecalc(eval->params, eval->tables);
+		evalClear(eval);
+
+		return true;
+	}
+#	endif
+
+	return false;
+}
+
+Score evaluate(Eval *eval, const Pos *pos) {
+	// Clear hash tables if the weights have changed since they were filled.
+#	ifdef TUNE
+	if (eval->params==&evalParams && eval->generation!=evalGeneration)
+		evalClear(eval);
+#	endif
+
+	Score score=evaluateInternal(eval, pos);
 #	ifndef NDEBUG
-	Pos *scratchPos=posNewFromPos(pos);
-	posMirror(scratchPos);
-	Score scoreM=evaluateInternal(scratchPos);
-	posFlip(scratchPos);
-	Score scoreFM=evaluateInternal(scratchPos);
-	posMirror(scratchPos);
-	Score scoreF=evaluateInternal(scratchPos);
-	posFree(scratchPos);
+	Pos scratchPos;
+	posCopy(&scratchPos, pos);
+	posMirror(&scratchPos);
+	Score scoreM=evaluateInternal(eval, &scratchPos);
+	posFlip(&scratchPos);
+	Score scoreFM=evaluateInternal(eval, &scratchPos);
+	posMirror(&scratchPos);
+	Score scoreF=evaluateInternal(eval, &scratchPos);
 	assert(scoreM==score && scoreFM==score && scoreF==score);
 #	endif
 	return score;
 }
 
-void evalClear(void) {
+void evalClear(Eval *eval) {
 	// Clear hash tables.
-	htableClear(evalPawnTable);
-	htableClear(evalMatTable);
+	htableClear(eval->pawnTable);
+	htableClear(eval->matTable);
+#	ifdef TUNE
+	eval->generation=evalGeneration;
+#	endif
+
+	// Reset statistics.
+	memset(&eval->stats, 0, sizeof(eval->stats));
 }
 
-EvalMatType evalGetMatType(const Pos *pos) {
+EvalMatType evalGetMatType(Eval *eval, const Pos *pos) {
 	// Grab hash entry for this position key
 	HTableKey hTableKey=evalGetMatDataHTableKeyFromPos(pos);
-	EvalMatData *entry=htableGrab(evalMatTable, hTableKey);
+	EvalMatData *entry=htableGrab(eval->matTable, hTableKey);
 
 	// If not a match clear entry
 	Key key=posGetMatKey(pos);
@@ -278,35 +424,27 @@ EvalMatType evalGetMatType(const Pos *pos) {
 	EvalMatType type=entry->type;
 
 	// We are finished with Entry, release lock
-	htableRelease(evalMatTable, hTableKey);
+	htableRelease(eval->matTable, hTableKey);
 
 	return type;
 }
 
+void evalStatsWrite(const Eval *eval) {
+	const EvalStats *stats=&eval->stats;
+	uciWrite("Pawn hash: %llu probes, %llu hits (%.1f%%)\n", stats->pawnProbes, stats->pawnHits,
+	         (stats->pawnProbes>0 ? (100.0*stats->pawnHits)/stats->pawnProbes : 0.0));
+	uciWrite("King terms: %llu probes, %llu hits (%.1f%%)\n", stats->kingProbes, stats->kingHits,
+	         (stats->kingProbes>0 ? (100.0*stats->kingHits)/stats->kingProbes : 0.0));
+}
+
 const char *evalMatTypeStrs[EvalMatTypeNB]={[EvalMatTypeInvalid]="invalid", [EvalMatTypeOther]="other ", [EvalMatTypeDraw]="draw", [EvalMatTypeKNNvK]="KNNvK", [EvalMatTypeKPvK]="KPvK", [EvalMatTypeKBPvK]="KBPvK"};
 const char *evalMatTypeToStr(EvalMatType matType) {
 	assert(matType<EvalMatTypeNB);
 	return evalMatTypeStrs[matType];
 }
 
-VPair evalComputePstScore(const Pos *pos) {
-	VPair score=VPairZero;
-
-	Colour colour;
-	for(colour=0; colour<ColourNB; ++colour) {
-		// Pawns are not included
-		PieceType type;
-		for(type=PieceTypeKnight;type<=PieceTypeKing;++type) {
-			Piece piece=pieceMake(type, colour);
-			BB pieceSet=posGetBBPiece(pos, piece);
-			while(pieceSet) {
-				Sq sq=bbScanReset(&pieceSet);
-				evalVPairAddTo(&score, &evalPST[piece][sq]);
-			}
-		}
-	}
-
-	return score;
+VPacked evalComputePstScore(const Pos *pos) {
+	return evalComputePstScoreTables(&evalTables, pos);
 }
 
 void evalVPairAddTo(VPair *a, const VPair *b) {
@@ -361,12 +499,14 @@ VPair evalVPairNegation(const VPair *a) {
 // Private functions
 ////////////////////////////////////////////////////////////////////////////////
 
-Score evaluateInternal(const Pos *pos) {
+Score evaluateInternal(Eval *eval, const Pos *pos) {
 	// Init data struct.
-	EvalData data={.pos=pos};
+	EvalData data={.pos=pos, .eval=eval, .params=evalGetParams(eval), .tables=evalGetTables(eval)};
+	const EvalParams *params=data.params;
+	const EvalTables *tables=data.tables;
 
 	// Evaluation function depends on material combination.
-	evalGetMatData(pos, &data.matData);
+	evalGetMatData(&data);
 
 	// Extra info
 #ifdef EVALINFO
@@ -374,7 +514,7 @@ Score evaluateInternal(const Pos *pos) {
 #endif
 
 	// Evaluate.
-	VPair score;
+	VPacked score;
 	switch(data.matData.type) {
 		case EvalMatTypeKPvK:
 			score=evaluateKPvK(&data);
@@ -386,30 +526,30 @@ Score evaluateInternal(const Pos *pos) {
 
 	// Extra info
 #ifdef EVALINFO
-	printf("    default eval (%i,%i)\n", score.mg, score.eg);
+	printf("    default eval (%i,%i)\n", evalVPackedMg(score), evalVPackedEg(score));
 #endif
 
 	// Material combination offset.
-	evalVPairAddTo(&score, &data.matData.offset);
+	score+=data.matData.offset;
 
 	// Extra info
 #ifdef EVALINFO
-	printf("    mat combo offset (%i,%i)\n", data.matData.offset.mg, data.matData.offset.eg);
+	printf("    mat combo offset (%i,%i)\n", evalVPackedMg(data.matData.offset), evalVPackedEg(data.matData.offset));
 #endif
 
 	// Tempo bonus.
 	if (posGetSTM(pos)==ColourWhite)
-		evalVPairAddTo(&score, &evalTempoDefault);
+		score+=evalVPairPack(&params->tempoDefault);
 	else
-		evalVPairSubFrom(&score, &evalTempoDefault);
+		score-=evalVPairPack(&params->tempoDefault);
 
 	// Extra info
 #ifdef EVALINFO
-	printf("    post adding tempo bonus (%i,%i) (bonus is (%i,%i))\n", score.mg, score.eg, evalTempoDefault.mg, evalTempoDefault.eg);
+	printf("    post adding tempo bonus (%i,%i) (bonus is (%i,%i))\n", evalVPackedMg(score), evalVPackedEg(score), params->tempoDefault.mg, params->tempoDefault.eg);
 #endif
 
 	// Interpolate score based on phase of the game and special material combination considerations.
-	Score scalarScore=evalInterpolate(&data, &score);
+	Score scalarScore=evalInterpolate(&data, score);
 
 	// Extra info
 #ifdef EVALINFO
@@ -427,7 +567,7 @@ Score evaluateInternal(const Pos *pos) {
 	// Drag score towards 0 as we approach 50-move rule
 	unsigned int halfMoves=posGetHalfMoveNumber(data.pos);
 	assert(halfMoves<128);
-	scalarScore=(((int)scalarScore)*evalHalfMoveFactors[halfMoves])/256;
+	scalarScore=(((int)scalarScore)*tables->halfMoveFactors[halfMoves])/256;
 
 	// Extra info
 #ifdef EVALINFO
@@ -446,12 +586,13 @@ Score evaluateInternal(const Pos *pos) {
 	return scalarScore;
 }
 
-VPair evaluateDefault(EvalData *data) {
+VPacked evaluateDefault(EvalData *data) {
 	// Init
 #ifdef EVALINFO
-	VPair tempScore;
+	VPacked tempScore;
 #endif
 	const Pos *pos=data->pos;
+	const EvalParams *params=data->params;
 
 	BB pieceSet;
 
@@ -465,11 +606,11 @@ VPair evaluateDefault(EvalData *data) {
 	mobilityAllowed[ColourBlack]=~(bp | posGetBBPiece(pos, PieceBKing) | wpAttacks);
 
 	// 'Global' calculations (includes pawns)
-	VPair score=evaluateDefaultGlobal(data);
+	VPacked score=evaluateDefaultGlobal(data);
 
 	// Extra info
 #ifdef EVALINFO
-	printf("        default global score (%i,%i)\n", score.mg, score.eg);
+	printf("        default global score (%i,%i)\n", evalVPackedMg(score), evalVPackedEg(score));
 	tempScore=score;
 #endif
 
@@ -478,18 +619,18 @@ VPair evaluateDefault(EvalData *data) {
 	while(pieceSet) {
 		Sq sq=bbScanReset(&pieceSet);
 		BB attacks=attacksKnight(sq);
-		evalVPairAddMulTo(&score, &evalKnightMob, bbPopCount(attacks & mobilityAllowed[ColourWhite]));
+		score+=evalVPairPack(&params->knightMob)*bbPopCount(attacks & mobilityAllowed[ColourWhite]);
 	}
 	pieceSet=posGetBBPiece(pos, PieceBKnight);
 	while(pieceSet) {
 		Sq sq=bbScanReset(&pieceSet);
 		BB attacks=attacksKnight(sq);
-		evalVPairSubMulFrom(&score, &evalKnightMob, bbPopCount(attacks & mobilityAllowed[ColourBlack]));
+		score-=evalVPairPack(&params->knightMob)*bbPopCount(attacks & mobilityAllowed[ColourBlack]);
 	}
 
 	// Extra info
 #ifdef EVALINFO
-	printf("        knight mobility (%i,%i)\n", score.mg-tempScore.mg, score.eg-tempScore.eg);
+	printf("        knight mobility (%i,%i)\n", evalVPackedMg(score-tempScore), evalVPackedEg(score-tempScore));
 	tempScore=score;
 #endif
 
@@ -502,18 +643,18 @@ VPair evaluateDefault(EvalData *data) {
 	while(pieceSet) {
 		Sq sq=bbScanReset(&pieceSet);
 		BB attacks=attacksBishop(sq, bishopMobOcc[ColourWhite]);
-		evalVPairAddMulTo(&score, &evalBishopMob, bbPopCount(attacks & mobilityAllowed[ColourWhite]));
+		score+=evalVPairPack(&params->bishopMob)*bbPopCount(attacks & mobilityAllowed[ColourWhite]);
 	}
 	pieceSet=(posGetBBPiece(pos, PieceBBishopL)|posGetBBPiece(pos, PieceBBishopD));
 	while(pieceSet) {
 		Sq sq=bbScanReset(&pieceSet);
 		BB attacks=attacksBishop(sq, bishopMobOcc[ColourBlack]);
-		evalVPairSubMulFrom(&score, &evalBishopMob, bbPopCount(attacks & mobilityAllowed[ColourBlack]));
+		score-=evalVPairPack(&params->bishopMob)*bbPopCount(attacks & mobilityAllowed[ColourBlack]);
 	}
 
 	// Extra info
 #ifdef EVALINFO
-	printf("        bishop mobility (%i,%i)\n", score.mg-tempScore.mg, score.eg-tempScore.eg);
+	printf("        bishop mobility (%i,%i)\n", evalVPackedMg(score-tempScore), evalVPackedEg(score-tempScore));
 	tempScore=score;
 #endif
 
@@ -526,47 +667,47 @@ VPair evaluateDefault(EvalData *data) {
 	while(pieceSet) {
 		Sq sq=bbScanReset(&pieceSet);
 		BB attacks=attacksRook(sq, rookMobOcc[ColourWhite]);
-		evalVPairAddMulTo(&score, &evalRookMobFile, bbPopCount(attacks & mobilityAllowed[ColourWhite] & bbFile(sqFile(sq))));
-		evalVPairAddMulTo(&score, &evalRookMobRank, bbPopCount(attacks & mobilityAllowed[ColourWhite] & bbRank(sqRank(sq))));
+		score+=evalVPairPack(&params->rookMobFile)*bbPopCount(attacks & mobilityAllowed[ColourWhite] & bbFile(sqFile(sq)));
+		score+=evalVPairPack(&params->rookMobRank)*bbPopCount(attacks & mobilityAllowed[ColourWhite] & bbRank(sqRank(sq)));
 	}
 	pieceSet=posGetBBPiece(pos, PieceBRook);
 	while(pieceSet) {
 		Sq sq=bbScanReset(&pieceSet);
 		BB attacks=attacksRook(sq, rookMobOcc[ColourBlack]);
-		evalVPairSubMulFrom(&score, &evalRookMobFile, bbPopCount(attacks & mobilityAllowed[ColourBlack] & bbFile(sqFile(sq))));
-		evalVPairSubMulFrom(&score, &evalRookMobRank, bbPopCount(attacks & mobilityAllowed[ColourBlack] & bbRank(sqRank(sq))));
+		score-=evalVPairPack(&params->rookMobFile)*bbPopCount(attacks & mobilityAllowed[ColourBlack] & bbFile(sqFile(sq)));
+		score-=evalVPairPack(&params->rookMobRank)*bbPopCount(attacks & mobilityAllowed[ColourBlack] & bbRank(sqRank(sq)));
 	}
 
 	// Extra info
 #ifdef EVALINFO
-	printf("        rook mobility (%i,%i)\n", score.mg-tempScore.mg, score.eg-tempScore.eg);
+	printf("        rook mobility (%i,%i)\n", evalVPackedMg(score-tempScore), evalVPackedEg(score-tempScore));
 	tempScore=score;
 #endif
 
 	// Kings
-	VPair kingScoreWhite=evaluateDefaultKing(data, ColourWhite);
-	evalVPairAddTo(&score, &kingScoreWhite);
+	VPacked kingScoreWhite=evaluateDefaultKing(data, ColourWhite);
+	score+=kingScoreWhite;
 
-	VPair kingScoreBlack=evaluateDefaultKing(data, ColourBlack);
-	evalVPairSubFrom(&score, &kingScoreBlack);
+	VPacked kingScoreBlack=evaluateDefaultKing(data, ColourBlack);
+	score-=kingScoreBlack;
 
 	// Extra info
 #ifdef EVALINFO
-	printf("        king scores: white (%i,%i), black (%i,%i)\n", kingScoreWhite.mg, kingScoreWhite.eg, kingScoreBlack.mg, kingScoreBlack.eg);
+	printf("        king scores: white (%i,%i), black (%i,%i)\n", evalVPackedMg(kingScoreWhite), evalVPackedEg(kingScoreWhite), evalVPackedMg(kingScoreBlack), evalVPackedEg(kingScoreBlack));
 	tempScore=score;
 #endif
 
 	return score;
 }
 
-VPair evaluateKPvK(EvalData *data) {
+VPacked evaluateKPvK(EvalData *data) {
 	// Use tablebase to find exact result.
 	BitBaseResult result=bitbaseProbe(data->pos);
 	switch(result) {
 		case BitBaseResultDraw:
-			data->matData.offset=VPairZero;
+			data->matData.offset=VPackedZero;
 			data->matData.scoreOffset=0;
-			return VPairZero;
+			return VPackedZero;
 		break;
 		case BitBaseResultWin: {
 			const Value bonus=1000; // makes displayed score more sensible
@@ -577,13 +718,15 @@ VPair evaluateKPvK(EvalData *data) {
 	}
 
 	assert(false);
-	return VPairZero;
+	return VPackedZero;
 }
 
-void evalGetMatData(const Pos *pos, EvalMatData *matData) {
+void evalGetMatData(EvalData *data) {
+	const Pos *pos=data->pos;
+
 	// Grab hash entry for this position key.
 	HTableKey hTableKey=evalGetMatDataHTableKeyFromPos(pos);
-	EvalMatData *entry=htableGrab(evalMatTable, hTableKey);
+	EvalMatData *entry=htableGrab(data->eval->matTable, hTableKey);
 
 	// If not a match clear entry
 	Key key=posGetMatKey(pos);
@@ -599,21 +742,25 @@ void evalGetMatData(const Pos *pos, EvalMatData *matData) {
 
 	// If no data already, compute.
 	if (!entry->computed)
-		evalComputeMatData(pos, entry);
+		evalComputeMatData(data, entry);
 
 	// Copy data to return it.
-	*matData=*entry;
+	data->matData=*entry;
 
 	// We are finished with entry, release lock.
-	htableRelease(evalMatTable, hTableKey);
+	htableRelease(data->eval->matTable, hTableKey);
 }
 
-void evalComputeMatData(const Pos *pos, EvalMatData *matData) {
+void evalComputeMatData(const EvalData *data, EvalMatData *matData) {
+	const Pos *pos=data->pos;
+	const EvalParams *params=data->params;
+	const EvalTables *tables=data->tables;
+
 	// Init data.
 	assert(matData->key==posGetMatKey(pos));
 	assert(matData->type!=EvalMatTypeInvalid);
 	matData->computed=true;
-	matData->offset=VPairZero;
+	matData->offset=VPackedZero;
 	matData->scoreOffset=0;
 
 	// Find weights for middlegame and endgame.
@@ -643,7 +790,7 @@ void evalComputeMatData(const Pos *pos, EvalMatData *matData) {
 	unsigned bXKingsCount=bbPopCount(posGetBBColour(pos, ColourBlack))-1;
 	unsigned totalXKingsCount=bbPopCount(posGetBBAll(pos))-2;
 
-	matData->weightEG=evalWeightEGFactors[pieceWeight];
+	matData->weightEG=tables->weightEGFactors[pieceWeight];
 	matData->weightMG=256-matData->weightEG;
 
 	// Specific material combinations.
@@ -829,25 +976,25 @@ void evalComputeMatData(const Pos *pos, EvalMatData *matData) {
 	// Opposite coloured bishop endgames are drawish.
 	if ((wBishopLCount>0 && wBishopDCount==0 && bBishopDCount>0 && bBishopLCount==0) ||
 	    (wBishopDCount>0 && wBishopLCount==0 && bBishopLCount>0 && bBishopDCount==0)) {
-		matData->weightMG=(matData->weightMG*evalOppositeBishopFactor.mg)/256;
-		matData->weightEG=(matData->weightEG*evalOppositeBishopFactor.eg)/256;
+		matData->weightMG=(matData->weightMG*params->oppositeBishopFactor.mg)/256;
+		matData->weightEG=(matData->weightEG*params->oppositeBishopFactor.eg)/256;
 	}
 
 	// Knight pawn affinity.
 	int knightAffW=wKnightCount*wPawnCount;
 	int knightAffB=bKnightCount*bPawnCount;
-	evalVPairAddMulTo(&matData->offset, &evalKnightPawnAffinity, knightAffW-knightAffB);
+	matData->offset+=evalVPairPack(&params->knightPawnAffinity)*(knightAffW-knightAffB);
 
 	// Rook pawn affinity.
 	int rookAffW=wRookCount*wPawnCount;
 	int rookAffB=bRookCount*bPawnCount;
-	evalVPairAddMulTo(&matData->offset, &evalRookPawnAffinity, rookAffW-rookAffB);
+	matData->offset+=evalVPairPack(&params->rookPawnAffinity)*(rookAffW-rookAffB);
 
 	// Bishop pair bonus
 	if (wBishopLCount>0 && wBishopDCount>0)
-		evalVPairAddTo(&matData->offset, &evalBishopPair);
+		matData->offset+=evalVPairPack(&params->bishopPair);
 	if (bBishopLCount>0 && bBishopDCount>0)
-		evalVPairSubFrom(&matData->offset, &evalBishopPair);
+		matData->offset-=evalVPairPack(&params->bishopPair);
 }
 
 HTableKey evalGetMatDataHTableKeyFromPos(const Pos *pos) {
@@ -857,36 +1004,59 @@ HTableKey evalGetMatDataHTableKeyFromPos(const Pos *pos) {
 	return posGetMatKey(pos)&0xFFFFFFFFu; // Use lower 32 bits
 }
 
-void evalGetPawnData(const Pos *pos, EvalPawnData *pawnData) {
+void evalGetPawnData(EvalData *data) {
+	const Pos *pos=data->pos;
+	EvalPawnData *pawnData=&data->pawnData;
+	EvalStats *stats=&data->eval->stats;
+
 	// Grab hash entry for this position key.
 	HTableKey hTableKey=evalGetPawnDataHTableKeyFromPos(pos);
-	EvalPawnData *entry=htableGrab(evalPawnTable, hTableKey);
+	EvalPawnData *entry=htableGrab(data->eval->pawnTable, hTableKey);
 
 	// If not a match recompute data.
+	++stats->pawnProbes;
 	if (entry->pawns[ColourWhite]!=posGetBBPiece(pos, PieceWPawn) ||
 	    entry->pawns[ColourBlack]!=posGetBBPiece(pos, PieceBPawn))
-		evalComputePawnData(pos, entry);
+		evalComputePawnData(data, entry);
+	else
+		++stats->pawnHits;
+
+	// King terms only depend on pawns and the king's square, so are cached in the same entry.
+	for(Colour colour=ColourWhite; colour<=ColourBlack; ++colour) {
+		Sq kingSq=posGetKingSq(pos, colour);
+		++stats->kingProbes;
+		if (entry->kingSq[colour]==kingSq)
+			++stats->kingHits;
+		else {
+			entry->kingScore[colour]=evalComputeKingScore(data, entry, colour, kingSq);
+			entry->kingSq[colour]=kingSq;
+		}
+	}
 
 	// Copy data to return it.
 	*pawnData=*entry;
 
 	// We are finished with Entry, release lock.
-	htableRelease(evalPawnTable, hTableKey);
+	htableRelease(data->eval->pawnTable, hTableKey);
 
 	// Compute terms which depend on other (non-pawn) aspects of the position, hence cannot be hashed.
 	BB occ=posGetBBAll(pos);
 	BB blocked[ColourNB];
 	blocked[ColourWhite]=(pawnData->pawns[ColourWhite] & bbSouthOne(occ));
 	blocked[ColourBlack]=(pawnData->pawns[ColourBlack] & bbNorthOne(occ));
-	evalVPairAddMulTo(&pawnData->score, &evalPawnBlocked, ((int)bbPopCount(blocked[ColourWhite]))-((int)bbPopCount(blocked[ColourBlack])));
+	pawnData->score+=evalVPairPack(&data->params->pawnBlocked)*(((int)bbPopCount(blocked[ColourWhite]))-((int)bbPopCount(blocked[ColourBlack])));
 }
 
-void evalComputePawnData(const Pos *pos, EvalPawnData *pawnData) {
+void evalComputePawnData(const EvalData *data, EvalPawnData *pawnData) {
+	const Pos *pos=data->pos;
+	const EvalTables *tables=data->tables;
+
 	// Init.
-	pawnData->score=VPairZero;
+	pawnData->score=VPackedZero;
+	pawnData->kingSq[ColourWhite]=pawnData->kingSq[ColourBlack]=SqInvalid;
 	BB pawns[ColourNB], frontSpan[ColourNB], rearSpan[ColourNB], attacks[ColourNB];
 	BB attacksFill[ColourNB], doubled[ColourNB], isolated[ColourNB];
-	BB influence[ColourNB], fill[ColourNB];
+	BB influence[ColourNB];
 	pawns[ColourWhite]=pawnData->pawns[ColourWhite]=posGetBBPiece(pos, PieceWPawn);
 	pawns[ColourBlack]=pawnData->pawns[ColourBlack]=posGetBBPiece(pos, PieceBPawn);
 	frontSpan[ColourWhite]=bbNorthOne(bbNorthFill(pawns[ColourWhite])); // All squares infront of pawns of given colour.
@@ -905,11 +1075,6 @@ void evalComputePawnData(const Pos *pos, EvalPawnData *pawnData) {
 	influence[ColourBlack]=(frontSpan[ColourBlack] | bbWingify(frontSpan[ColourBlack]));
 	pawnData->passed[ColourWhite]=(pawns[ColourWhite] & ~(doubled[ColourWhite] | influence[ColourBlack]));
 	pawnData->passed[ColourBlack]=(pawns[ColourBlack] & ~(doubled[ColourBlack] | influence[ColourWhite]));
-	fill[ColourWhite]=bbFileFill(pawns[ColourWhite]);
-	fill[ColourBlack]=bbFileFill(pawns[ColourBlack]);
-	pawnData->semiOpenFiles[ColourWhite]=(fill[ColourBlack] & ~fill[ColourWhite]);
-	pawnData->semiOpenFiles[ColourBlack]=(fill[ColourWhite] & ~fill[ColourBlack]);
-	pawnData->openFiles=~(fill[ColourWhite] | fill[ColourBlack]);
 
 	// Loop over each pawn.
 #ifdef EVALINFO
@@ -926,11 +1091,11 @@ void evalComputePawnData(const Pos *pos, EvalPawnData *pawnData) {
 			               (((isolated[colour]>>sq)&1)<<PawnTypeShiftIsolated) |
 			               (((pawnData->passed[colour]>>sq)&1)<<PawnTypeShiftPassed));
 			assert(type>=0 && type<PawnTypeNB);
-			evalVPairAddTo(&pawnData->score, &evalPawnValue[colour][type][sq]);
+			pawnData->score+=tables->pawnValue[colour][type][sq];
 #ifdef EVALINFO
 			printf("                %c%c %u%u%u (%i,%i)\n", fileToChar(sqFile(sq)), rankToChar(sqRank(sq)),
 			       (((doubled[colour]>>sq)&1)!=0), (((isolated[colour]>>sq)&1)!=0), (((pawnData->passed[colour]>>sq)&1)!=0),
-			       evalPawnValue[colour][type][sq].mg, evalPawnValue[colour][type][sq].eg);
+			       evalVPackedMg(tables->pawnValue[colour][type][sq]), evalVPackedEg(tables->pawnValue[colour][type][sq]));
 #endif
 		}
 	}
@@ -943,180 +1108,256 @@ HTableKey evalGetPawnDataHTableKeyFromPos(const Pos *pos) {
 	return posGetPawnKey(pos)&0xFFFFFFFFu;
 }
 
-VPair evaluateDefaultGlobal(EvalData *data) {
+VPacked evaluateDefaultGlobal(EvalData *data) {
 	assert(data!=NULL);
 
 #ifdef EVALINFO
-	VPair tempScore=VPairZero;
+	VPacked tempScore=VPackedZero;
 #endif
 	const Pos *pos=data->pos;
 
-	// Start with incrementally updated PST score.
-	VPair score=posGetPstScore(pos);
+	const EvalParams *params=data->params;
+
+	// Start with incrementally updated PST score (in tuning builds this may have
+	// been computed using different weights, so instead compute from scratch).
+#	ifdef TUNE
+	VPacked score=evalComputePstScoreTables(data->tables, pos);
+#	else
+	VPacked score=posGetPstScore(pos);
+#	endif
 
 	// Extra info
 #ifdef EVALINFO
-	printf("            pst scores: (%i,%i)\n", score.mg-tempScore.mg, score.eg-tempScore.eg);
+	printf("            pst scores: (%i,%i)\n", evalVPackedMg(score-tempScore), evalVPackedEg(score-tempScore));
 	tempScore=score;
 #endif
 
 	// Pawns
-	evalGetPawnData(pos, &data->pawnData);
-	evalVPairAddTo(&score, &data->pawnData.score);
+	evalGetPawnData(data);
+	score+=data->pawnData.score;
 
 	// Extra info
 #ifdef EVALINFO
-	printf("            pawns scores: (%i,%i)\n", score.mg-tempScore.mg, score.eg-tempScore.eg);
+	printf("            pawns scores: (%i,%i)\n", evalVPackedMg(score-tempScore), evalVPackedEg(score-tempScore));
 	tempScore=score;
 #endif
 
-	// Rook stuff
-	for(Colour colour=ColourWhite; colour<=ColourBlack; ++colour,evalVPairNegate(&score)) {
+	// Rook stuff (open files are cheap to compute so are not stored in the pawn hash).
+	BB fill[ColourNB], semiOpenFiles[ColourNB], openFiles;
+	fill[ColourWhite]=bbFileFill(data->pawnData.pawns[ColourWhite]);
+	fill[ColourBlack]=bbFileFill(data->pawnData.pawns[ColourBlack]);
+	semiOpenFiles[ColourWhite]=(fill[ColourBlack] & ~fill[ColourWhite]);
+	semiOpenFiles[ColourBlack]=(fill[ColourWhite] & ~fill[ColourBlack]);
+	openFiles=~(fill[ColourWhite] | fill[ColourBlack]);
+	for(Colour colour=ColourWhite; colour<=ColourBlack; ++colour,score=-score) {
 		BB rooks=posGetBBPiece(pos, pieceMake(PieceTypeRook, colour));
 		if (rooks==BBNone)
 			continue;
 
 		// Rooks on open and semi-open files.
-		evalVPairAddMulTo(&score, &evalRookOpenFile, bbPopCount(rooks & data->pawnData.openFiles));
-		evalVPairAddMulTo(&score, &evalRookSemiOpenFile, bbPopCount(rooks & data->pawnData.semiOpenFiles[colour]));
+		score+=evalVPairPack(&params->rookOpenFile)*bbPopCount(rooks & openFiles);
+		score+=evalVPairPack(&params->rookSemiOpenFile)*bbPopCount(rooks & semiOpenFiles[colour]);
 
 		// Any rooks on 7th rank?
 		BB rank7=bbRank(colour==ColourWhite ? Rank7 : Rank2);
 		BB oppPawns=posGetBBPiece(pos, pieceMake(PieceTypePawn, colourSwap(colour)));
 		if ((oppPawns & rank7) || sqRank(sqNormalise(posGetKingSq(pos, colourSwap(colour)), colour))==Rank8)
-			evalVPairAddMulTo(&score, &evalRookOn7th, bbPopCount(rooks & rank7));
+			score+=evalVPairPack(&params->rookOn7th)*bbPopCount(rooks & rank7);
 
 		// Any rooks trapped on edge of back rank by own king?
 		BB kingBB=posGetBBPiece(pos, pieceMake(PieceTypeKing, colour));
 		if (colour==ColourWhite) {
 			if (((rooks & (bbSq(SqG1) | bbSq(SqH1))) && (kingBB & (bbSq(SqF1) | bbSq(SqG1)))) ||
 			    ((rooks & (bbSq(SqA1) | bbSq(SqB1))) && (kingBB & (bbSq(SqB1) | bbSq(SqC1)))))
-				evalVPairAddTo(&score, &evalRookTrapped);
+				score+=evalVPairPack(&params->rookTrapped);
 		} else {
 			if (((rooks & (bbSq(SqG8) | bbSq(SqH8))) && (kingBB & (bbSq(SqF8) | bbSq(SqG8)))) ||
 			    ((rooks & (bbSq(SqA8) | bbSq(SqB8))) && (kingBB & (bbSq(SqB8) | bbSq(SqC8)))))
-				evalVPairAddTo(&score, &evalRookTrapped);
+				score+=evalVPairPack(&params->rookTrapped);
 		}
 	}
 
 	// Extra info
 #ifdef EVALINFO
-	printf("            rook stuff: (%i,%i)\n", score.mg-tempScore.mg, score.eg-tempScore.eg);
+	printf("            rook stuff: (%i,%i)\n", evalVPackedMg(score-tempScore), evalVPackedEg(score-tempScore));
 	tempScore=score;
 #endif
 
 	// King castling 'mobility'.
 	CastRights castRights=posGetCastRights(pos);
 	if (castRights.rookSq[ColourWhite][CastSideA]!=SqInvalid)
-		evalVPairAddTo(&score, &evalKingCastlingMobility);
+		score+=evalVPairPack(&params->kingCastlingMobility);
 	if (castRights.rookSq[ColourWhite][CastSideH]!=SqInvalid)
-		evalVPairAddTo(&score, &evalKingCastlingMobility);
+		score+=evalVPairPack(&params->kingCastlingMobility);
 	if (castRights.rookSq[ColourBlack][CastSideA]!=SqInvalid)
-		evalVPairSubFrom(&score, &evalKingCastlingMobility);
+		score-=evalVPairPack(&params->kingCastlingMobility);
 	if (castRights.rookSq[ColourBlack][CastSideH]!=SqInvalid)
-		evalVPairSubFrom(&score, &evalKingCastlingMobility);
+		score-=evalVPairPack(&params->kingCastlingMobility);
 
 	// Extra info
 #ifdef EVALINFO
-	printf("            king castling mobility: (%i,%i)\n", score.mg-tempScore.mg, score.eg-tempScore.eg);
+	printf("            king castling mobility: (%i,%i)\n", evalVPackedMg(score-tempScore), evalVPackedEg(score-tempScore));
 	tempScore=score;
 #endif
 
 	return score;
 }
 
-VPair evaluateDefaultKing(EvalData *data, Colour colour) {
+VPacked evaluateDefaultKing(EvalData *data, Colour colour) {
 	assert(data!=NULL);
+	assert(data->pawnData.kingSq[colour]==posGetKingSq(data->pos, colour));
+
+	// Computed by evalGetPawnData() (or found in the pawn hash).
+	return data->pawnData.kingScore[colour];
+}
+
+VPacked evalComputeKingScore(const EvalData *data, const EvalPawnData *pawnData, Colour colour, Sq kingSq) {
+	assert(pawnData!=NULL);
+	assert(sqIsValid(kingSq));
+
+	const EvalParams *params=data->params;
+	const EvalTables *tables=data->tables;
 
-	Sq kingSq=posGetKingSq(data->pos, colour);
 	BB kingBB=bbSq(kingSq);
 
-	VPair score=VPairZero;
+	VPacked score=VPackedZero;
 
 	// Pawn shield.
-	BB pawns=posGetBBPiece(data->pos, pieceMake(PieceTypePawn, colour));
+	BB pawns=pawnData->pawns[colour];
 	BB kingSpan=bbForwardOne((bbWestOne(kingBB) | kingBB | bbEastOne(kingBB)), colour);
 
 	BB shieldClose=(pawns & kingSpan);
-	evalVPairAddMulTo(&score, &evalKingShieldClose, bbPopCount(shieldClose));
+	score+=evalVPairPack(&params->kingShieldClose)*bbPopCount(shieldClose);
 
 	BB shieldFar=(pawns & bbForwardOne(kingSpan, colour));
-	evalVPairAddMulTo(&score, &evalKingShieldFar, bbPopCount(shieldFar));
+	score+=evalVPairPack(&params->kingShieldFar)*bbPopCount(shieldFar);
 
 	// Distance to enemy passed pawns
-	BB oppPassers=data->pawnData.passed[colourSwap(colour)];
+	BB oppPassers=pawnData->passed[colourSwap(colour)];
 	while(oppPassers) {
 		Sq passerSq=bbScanReset(&oppPassers);
 		unsigned distance=sqDist(kingSq, passerSq);
 		assert(distance>=1 && distance<=7);
-		evalVPairAdd(&score, &evalKingNearPasser[distance]);
+		(void)(score+tables->kingNearPasser[distance]);
 	}
 
 	return score;
 }
 
-Score evalInterpolate(const EvalData *data, const VPair *score) {
+Score evalInterpolate(const EvalData *data, VPacked score) {
 	// Interpolate and also scale to centi-pawns
-	return ((data->matData.weightMG*score->mg+data->matData.weightEG*score->eg)*100)/(evalMaterial[PieceTypePawn].mg*256);
+	return ((data->matData.weightMG*evalVPackedMg(score)+data->matData.weightEG*evalVPackedEg(score))*100)/(data->params->material[PieceTypePawn].mg*256);
+}
+
+VPacked evalComputePstScoreTables(const EvalTables *tables, const Pos *pos) {
+	VPacked score=VPackedZero;
+
+	Colour colour;
+	for(colour=0; colour<ColourNB; ++colour) {
+		// Pawns are not included
+		PieceType type;
+		for(type=PieceTypeKnight;type<=PieceTypeKing;++type) {
+			Piece piece=pieceMake(type, colour);
+			BB pieceSet=posGetBBPiece(pos, piece);
+			while(pieceSet) {
+				Sq sq=bbScanReset(&pieceSet);
+				score+=tables->pst[piece][sq];
+			}
+		}
+	}
+
+	return score;
 }
 
+const EvalParams *evalGetParams(const Eval *eval) {
+#	ifdef TUNE
+	return eval->params;
+#	else
+	return &evalParams;
+#	endif
+}
+
+const EvalTables *evalGetTables(const Eval *eval) {
+#	ifdef TUNE
+	return eval->tables;
+#	else
+	return &evalTables;
+#	endif
+}
+
+
 #ifdef TUNE
 void evalSetValue(void *varPtr, long long value) {
 	// Set value.
-	Value *var=(Value *)varPtr;
-	*var=value;
+	evalParamsSet(&evalParams, ((const char *)varPtr)-((const char *)&evalParams), value);
+
+	// Recalculate dervied values (such as passed pawn table), and have contexts
+	// using these clear their now-invalid material and pawn tables etc.
+	evalRecalc(&evalParams, &evalTables);
+	++evalGeneration;
+}
+
+void evalParamsSet(EvalParams *params, size_t offset, Value value) {
+	// Set value.
+	assert(offset+sizeof(Value)<=sizeof(EvalParams));
+	*(Value *)(((char *)params)+offset)=value;
 
 	// Hack for bishops.
-	if (var==&evalMaterial[PieceTypeBishopL].mg)
-		evalMaterial[PieceTypeBishopD].mg=value;
-	else if (var==&evalMaterial[PieceTypeBishopL].eg)
-		evalMaterial[PieceTypeBishopD].eg=value;
-	else if (var==&evalPstParams[PieceTypeBishopD][0].mg)
-		evalPstParams[PieceTypeBishopD][0].mg=value;
-	else if (var==&evalPstParams[PieceTypeBishopD][0].eg)
-		evalPstParams[PieceTypeBishopD][0].eg=value;
-	else if (var==&evalPstParams[PieceTypeBishopD][1].mg)
-		evalPstParams[PieceTypeBishopD][1].mg=value;
-	else if (var==&evalPstParams[PieceTypeBishopD][1].eg)
-		evalPstParams[PieceTypeBishopD][1].eg=value;
-	else if (var==&evalPstParams[PieceTypeBishopD][2].mg)
-		evalPstParams[PieceTypeBishopD][2].mg=value;
-	else if (var==&evalPstParams[PieceTypeBishopD][2].eg)
-		evalPstParams[PieceTypeBishopD][2].eg=value;
-
-	// Recalculate dervied values (such as passed pawn table).
-	evalRecalc();
+	if (offset==offsetof(EvalParams, material[PieceTypeBishopL].mg))
+		params->material[PieceTypeBishopD].mg=value;
+	else if (offset==offsetof(EvalParams, material[PieceTypeBishopL].eg))
+		params->material[PieceTypeBishopD].eg=value;
+	else if (offset==offsetof(EvalParams, pstParams[PieceTypeBishopL][0].mg))
+		params->pstParams[PieceTypeBishopD][0].mg=value;
+	else if (offset==offsetof(EvalParams, pstParams[PieceTypeBishopL][0].eg))
+		params->pstParams[PieceTypeBishopD][0].eg=value;
+	else if (offset==offsetof(EvalParams, pstParams[PieceTypeBishopL][1].mg))
+		params->pstParams[PieceTypeBishopD][1].mg=value;
+	else if (offset==offsetof(EvalParams, pstParams[PieceTypeBishopL][1].eg))
+		params->pstParams[PieceTypeBishopD][1].eg=value;
+	else if (offset==offsetof(EvalParams, pstParams[PieceTypeBishopL][2].mg))
+		params->pstParams[PieceTypeBishopD][2].mg=value;
+	else if (offset==offsetof(EvalParams, pstParams[PieceTypeBishopL][2].eg))
+		params->pstParams[PieceTypeBishopD][2].eg=value;
+}
+
+bool evalOptionNew(const char *name, Value *value, Value min, Value max) {
+	// Remember option so evalSetOption() can find it.
+	assert(evalOptionCount<EvalOptionsMax);
+	assert(strlen(name)<sizeof(evalOptions[0].name));
+	EvalOption *option=&evalOptions[evalOptionCount++];
+	strcpy(option->name, name);
+	option->offset=((const char *)value)-((const char *)&evalParams);
+	option->min=min;
+	option->max=max;
+
+	return uciOptionNewSpin(name, &evalSetValue, value, min, max, *value);
 }
 
 bool evalOptionNewVPair(const char *name, VPair *score, Value min, Value max) {
-	return uciOptionNewSpinF("%sMG", &evalSetValue, &score->mg, min, max, score->mg, name) &&
-	       uciOptionNewSpinF("%sEG", &evalSetValue, &score->eg, min, max, score->eg, name);
+	char mgName[64], egName[64];
+	sprintf(mgName, "%sMG", name);
+	sprintf(egName, "%sEG", name);
+	return evalOptionNew(mgName, &score->mg, min, max) &&
+	       evalOptionNew(egName, &score->eg, min, max);
 }
 
 bool evalOptionNewVPairF(const char *nameFormat, VPair *score, Value min, Value max, ...) {
-	char nameFormat1[1024]; // TODO: avoid hardcoded size
-	char nameFormat2[1024]; // TODO: avoid hardcoded size
-	sprintf(nameFormat1, "%sMG", nameFormat);
-	sprintf(nameFormat2, "%sEG", nameFormat);
-
-	va_list ap1, ap2;
-	va_start(ap1, max);
-	va_copy(ap2, ap1);
-
-	bool result=true;
-	result&=!uciOptionNewSpinFV(nameFormat1, &evalSetValue, &score->mg, min, max, score->mg, ap1);
-	result&=!uciOptionNewSpinFV(nameFormat2, &evalSetValue, &score->eg, min, max, score->eg, ap2);
+	char name[64];
+	va_list ap;
+	va_start(ap, max);
+	vsprintf(name, nameFormat, ap);
+	va_end(ap);
 
-	va_end(ap2);
-	va_end(ap1);
-
-	return result;
+	return evalOptionNewVPair(name, score, min, max);
 }
 
 #endif
 
-void evalRecalc(void) {
+#ifndef TABLES
+void evalRecalc(const EvalParams *params, EvalTables *tables) {
 	PieceType pieceType;
+	VPair pst[PieceNB][SqNB]={{{0}}}; // Built unpacked then packed into tables->pst at the end.
 
 	// White pawn PST.
 	Sq sq;
@@ -1128,41 +1369,41 @@ void evalRecalc(void) {
 
 		unsigned y=sqRank(sq);
 		unsigned ya=(y<4 ? y : 7-y);
-		VPair rankScore=evalVPairMul(&evalPstParams[PieceTypePawn][1], ya);
-		VPair advScore=evalVPairMul(&evalPstParams[PieceTypePawn][2], y);
+		VPair rankScore=evalVPairMul(&params->pstParams[PieceTypePawn][1], ya);
+		VPair advScore=evalVPairMul(&params->pstParams[PieceTypePawn][2], y);
 		VPair yScore=evalVPairAdd(&rankScore, &advScore);
 		unsigned x=sqFile(sq);
 		unsigned xa=(x<4 ? x : 7-x);
-		VPair fileScore=evalVPairMul(&evalPstParams[PieceTypePawn][0], xa);
+		VPair fileScore=evalVPairMul(&params->pstParams[PieceTypePawn][0], xa);
 		whitePawnPst[sq]=evalVPairAdd(&yScore, &fileScore);
 
 		if (xa==3 && ya==3)
-			evalVPairAddTo(&whitePawnPst[sq], &evalPawnCentre);
+			evalVPairAddTo(&whitePawnPst[sq], &params->pawnCentre);
 		else if (xa>=2 && ya>=2)
-			evalVPairAddTo(&whitePawnPst[sq], &evalPawnOuterCentre);
+			evalVPairAddTo(&whitePawnPst[sq], &params->pawnOuterCentre);
 
-		evalVPairAddTo(&whitePawnPst[sq], &evalMaterial[PieceTypePawn]);
+		evalVPairAddTo(&whitePawnPst[sq], &params->material[PieceTypePawn]);
 	}
 
 	// White piece PSTs
 	for(PieceType type=PieceTypeKnight; type<=PieceTypeKing; ++type) {
 		for(unsigned y=0; y<8; ++y) {
 			unsigned ya=(y<4 ? y : 7-y);
-			VPair rankScore=evalVPairMul(&evalPstParams[type][1], ya);
-			VPair advScore=evalVPairMul(&evalPstParams[type][2], y);
+			VPair rankScore=evalVPairMul(&params->pstParams[type][1], ya);
+			VPair advScore=evalVPairMul(&params->pstParams[type][2], y);
 			VPair yScore=evalVPairAdd(&rankScore, &advScore);
 			for(unsigned x=0; x<8; ++x) {
 				unsigned xa=(x<4 ? x : 7-x);
-				VPair fileScore=evalVPairMul(&evalPstParams[type][0], xa);
+				VPair fileScore=evalVPairMul(&params->pstParams[type][0], xa);
 				Sq sq=sqMake(x,y);
-				evalPST[pieceMake(type, ColourWhite)][sq]=evalVPairAdd(&yScore, &fileScore);
+				pst[pieceMake(type, ColourWhite)][sq]=evalVPairAdd(&yScore, &fileScore);
 			}
 		}
 	}
 
 	// Manually fix king PST for friendly corner squares
-	evalPST[PieceWKing][SqA1].mg=evalPST[PieceWKing][SqB1].mg;
-	evalPST[PieceWKing][SqH1].mg=evalPST[PieceWKing][SqG1].mg;
+	pst[PieceWKing][SqA1].mg=pst[PieceWKing][SqB1].mg;
+	pst[PieceWKing][SqH1].mg=pst[PieceWKing][SqG1].mg;
 
 	// Pawn table.
 	PawnType type;
@@ -1172,24 +1413,22 @@ void evalRecalc(void) {
 		bool isPassed=((type & PawnTypePassed)!=0);
 		for(sq=0;sq<SqNB;++sq) {
 			// Calculate score for white.
-			VPair *score=&evalPawnValue[ColourWhite][type][sq];
-			*score=VPairZero;
-			evalVPairAddTo(score, &whitePawnPst[sq]);
+			VPair score=whitePawnPst[sq];
 			if (isDoubled)
-				evalVPairAddTo(score, &evalPawnDoubled);
+				evalVPairAddTo(&score, &params->pawnDoubled);
 			if (isIsolated)
-				evalVPairAddTo(score, &evalPawnIsolated);
+				evalVPairAddTo(&score, &params->pawnIsolated);
 			if (isPassed) {
 				// Generate passed pawn score from quadratic coefficients.
 				Rank rank=sqRank(sq);
-				evalVPairAddMulTo(score, &evalPawnPassedQuadA, rank*rank);
-				evalVPairAddMulTo(score, &evalPawnPassedQuadB, rank);
-				evalVPairAddTo(score, &evalPawnPassedQuadC);
+				evalVPairAddMulTo(&score, &params->pawnPassedQuadA, rank*rank);
+				evalVPairAddMulTo(&score, &params->pawnPassedQuadB, rank);
+				evalVPairAddTo(&score, &params->pawnPassedQuadC);
 			}
+			tables->pawnValue[ColourWhite][type][sq]=evalVPairPack(&score);
 
 			// Flip square and negate score for black.
-			evalPawnValue[ColourBlack][type][sqFlip(sq)]=VPairZero;
-			evalVPairSubFrom(&evalPawnValue[ColourBlack][type][sqFlip(sq)], score);
+			tables->pawnValue[ColourBlack][type][sqFlip(sq)]=-tables->pawnValue[ColourWhite][type][sq];
 		}
 	}
 
@@ -1198,17 +1437,17 @@ void evalRecalc(void) {
 		Piece piece=pieceMake(pieceType, ColourWhite);
 		Sq sq;
 		for(sq=0; sq<SqNB; ++sq)
-			evalVPairAddTo(&evalPST[piece][sq], &evalMaterial[pieceType]);
+			evalVPairAddTo(&pst[piece][sq], &params->material[pieceType]);
 	}
 
-	// Copy white PSTs into black.
+	// Pack white PSTs and copy into black.
 	for(pieceType=PieceTypePawn; pieceType<=PieceTypeKing; ++pieceType) {
 		Piece whitePiece=pieceMake(pieceType, ColourWhite);
 		Piece blackPiece=pieceMake(pieceType, ColourBlack);
-		Sq blackSq;
-		for(blackSq=0; blackSq<SqNB; ++blackSq) {
-			evalPST[blackPiece][blackSq]=evalPST[whitePiece][sqFlip(blackSq)];
-			evalVPairNegate(&evalPST[blackPiece][blackSq]);
+		Sq sq;
+		for(sq=0; sq<SqNB; ++sq) {
+			tables->pst[whitePiece][sq]=evalVPairPack(&pst[whitePiece][sq]);
+			tables->pst[blackPiece][sqFlip(sq)]=-tables->pst[whitePiece][sq];
 		}
 	}
 
@@ -1219,56 +1458,49 @@ void evalRecalc(void) {
 		assert(normDist>=0.0 && normDist<=1.0);
 		double normDist2=pow(normDist, 2.0);
 
-		double scoreMg=normDist2*evalKingNearPasserFactor.mg;
-		double scoreEg=normDist2*evalKingNearPasserFactor.eg;
-		evalKingNearPasser[dist].mg=floor(scoreMg);
-		evalKingNearPasser[dist].eg=floor(scoreEg);
+		double scoreMg=normDist2*params->kingNearPasserFactor.mg;
+		double scoreEg=normDist2*params->kingNearPasserFactor.eg;
+		tables->kingNearPasser[dist]=VPACKED(floor(scoreMg), floor(scoreEg));
 	}
 
 	// Calculate factor for number of half moves since capture/pawn move.
 	unsigned int i;
 	for(i=0;i<128;++i) {
-		float factor=exp2f(-((float)(i*i)/((float)evalHalfMoveFactor)));
+		float factor=exp2f(-((float)(i*i)/((float)params->halfMoveFactor)));
 		assert(factor>=0.0 && factor<=1.0);
-		evalHalfMoveFactors[i]=floorf(255.0*factor);
+		tables->halfMoveFactors[i]=floorf(255.0*factor);
 	}
 
 	// Calculate factor for each material weight.
 	for(i=0;i<128;++i) {
-		float factor=exp2f(-(float)(i*i)/((float)evalWeightFactor));
+		float factor=exp2f(-(float)(i*i)/((float)params->weightFactor));
 		assert(factor>=0.0 && factor<=1.0);
-		evalWeightEGFactors[i]=floorf(255.0*factor);
+		tables->weightEGFactors[i]=floorf(255.0*factor);
 	}
 
-	// Clear now-invalid material and pawn tables etc.
-	evalClear();
-
 	// Verify eval weights are all sensible and consistent.
-	evalVerify();
+	evalVerify(params, tables);
 }
+#endif
 
-void evalVerify(void) {
+void evalVerify(const EvalParams *params, const EvalTables *tables) {
 	// Check light/dark bishop entries match
-	assert(evalMaterial[PieceTypeBishopL].mg==evalMaterial[PieceTypeBishopD].mg);
-	assert(evalMaterial[PieceTypeBishopL].eg==evalMaterial[PieceTypeBishopD].eg);
+	assert(params->material[PieceTypeBishopL].mg==params->material[PieceTypeBishopD].mg);
+	assert(params->material[PieceTypeBishopL].eg==params->material[PieceTypeBishopD].eg);
 	for(unsigned i=0; i<3; ++i) {
-		assert(evalPstParams[PieceTypeBishopL][i].mg==evalPstParams[PieceTypeBishopD][i].mg);
-		assert(evalPstParams[PieceTypeBishopL][i].eg==evalPstParams[PieceTypeBishopD][i].eg);
+		assert(params->pstParams[PieceTypeBishopL][i].mg==params->pstParams[PieceTypeBishopD][i].mg);
+		assert(params->pstParams[PieceTypeBishopL][i].eg==params->pstParams[PieceTypeBishopD][i].eg);
 	}
 	for(Sq sq=0; sq<SqNB; ++sq) {
-		assert(evalPST[PieceWBishopL][sq].mg==evalPST[PieceWBishopD][sq].mg);
-		assert(evalPST[PieceWBishopL][sq].eg==evalPST[PieceWBishopD][sq].eg);
-		assert(evalPST[PieceBBishopL][sq].mg==evalPST[PieceBBishopD][sq].mg);
-		assert(evalPST[PieceBBishopL][sq].eg==evalPST[PieceBBishopD][sq].eg);
+		assert(tables->pst[PieceWBishopL][sq]==tables->pst[PieceWBishopD][sq]);
+		assert(tables->pst[PieceBBishopL][sq]==tables->pst[PieceBBishopD][sq]);
 	}
 
 	// Check pawn table is symmetrical
 	for(Sq sq=0; sq<SqNB; ++sq) {
 		for(unsigned i=0; i<PawnTypeNB; ++i) {
-			assert(evalPawnValue[ColourWhite][i][sq].mg==evalPawnValue[ColourWhite][i][sqMirror(sq)].mg);
-			assert(evalPawnValue[ColourWhite][i][sq].eg==evalPawnValue[ColourWhite][i][sqMirror(sq)].eg);
-			assert(evalPawnValue[ColourBlack][i][sq].mg==evalPawnValue[ColourBlack][i][sqMirror(sq)].mg);
-			assert(evalPawnValue[ColourBlack][i][sq].eg==evalPawnValue[ColourBlack][i][sqMirror(sq)].eg);
+			assert(tables->pawnValue[ColourWhite][i][sq]==tables->pawnValue[ColourWhite][i][sqMirror(sq)]);
+			assert(tables->pawnValue[ColourBlack][i][sq]==tables->pawnValue[ColourBlack][i][sqMirror(sq)]);
 		}
 	}
 
@@ -1276,14 +1508,9 @@ void evalVerify(void) {
 	PieceType pieceType;
 	for(pieceType=PieceTypePawn; pieceType<=PieceTypeKing; ++pieceType)
 		for(Sq sq=0; sq<SqNB; ++sq) {
-			assert(evalPST[pieceMake(pieceType, ColourWhite)][sq].mg==evalPST[pieceMake(pieceType, ColourWhite)][sqMirror(sq)].mg);
-			assert(evalPST[pieceMake(pieceType, ColourWhite)][sq].eg==evalPST[pieceMake(pieceType, ColourWhite)][sqMirror(sq)].eg);
-
-			assert(evalPST[pieceMake(pieceType, ColourBlack)][sq].mg==evalPST[pieceMake(pieceType, ColourBlack)][sqMirror(sq)].mg);
-			assert(evalPST[pieceMake(pieceType, ColourBlack)][sq].eg==evalPST[pieceMake(pieceType, ColourBlack)][sqMirror(sq)].eg);
-
-			assert(evalPST[pieceMake(pieceType, ColourBlack)][sq].mg==-evalPST[pieceMake(pieceType, ColourWhite)][sqFlip(sq)].mg);
-			assert(evalPST[pieceMake(pieceType, ColourBlack)][sq].eg==-evalPST[pieceMake(pieceType, ColourWhite)][sqFlip(sq)].eg);
+			assert(tables->pst[pieceMake(pieceType, ColourWhite)][sq]==tables->pst[pieceMake(pieceType, ColourWhite)][sqMirror(sq)]);
+			assert(tables->pst[pieceMake(pieceType, ColourBlack)][sq]==tables->pst[pieceMake(pieceType, ColourBlack)][sqMirror(sq)]);
+			assert(tables->pst[pieceMake(pieceType, ColourBlack)][sq]==-tables->pst[pieceMake(pieceType, ColourWhite)][sqFlip(sq)]);
 		}
 }
 
@@ -1355,12 +1582,12 @@ void evalPstDraw(PieceType type) {
 	for(int y=7; y>=0; --y) {
 		for(int x=0; x<8; ++x) {
 			Sq sq=sqMake(x, y);
-			printf("%5i ", evalPST[pieceMake(type, ColourWhite)][sq].mg-evalMaterial[type].mg);
+			printf("%5i ", evalVPackedMg(evalTables.pst[pieceMake(type, ColourWhite)][sq])-evalParams.material[type].mg);
 		}
 		printf("     ");
 		for(int x=0; x<8; ++x) {
 			Sq sq=sqMake(x, y);
-			printf("%5i ", evalPST[pieceMake(type, ColourWhite)][sq].eg-evalMaterial[type].eg);
+			printf("%5i ", evalVPackedEg(evalTables.pst[pieceMake(type, ColourWhite)][sq])-evalParams.material[type].eg);
 		}
 		printf("\n");
 	}
@@ -7,10 +7,19 @@ typedef int32_t Value;
 typedef struct { Value mg, eg; } VPair;
 extern const VPair VPairZero;
 
+// Packed form of a VPair with mg in the upper half and eg in the lower half,
+// so the pair can be added, subtracted, negated and multiplied by an integer
+// with a single operation (using the usual operators). Used for the PSTs and
+// other hot accumulation paths.
+typedef int64_t VPacked;
+#define VPackedZero ((VPacked)0)
+#define VPACKED(mg, eg) (((VPacked)(mg))*((VPacked)1<<32)+((VPacked)(eg)))
+
 #include "piece.h"
 #include "pos.h"
 #include "score.h"
 #include "square.h"
+#include "tables.h"
 
 typedef enum {
 	EvalMatTypeInvalid,
@@ -23,20 +32,39 @@ typedef enum {
 } EvalMatType;
 #define EvalMatTypeBit 3
 
-extern VPair evalPST[PieceNB][SqNB];
+// Tables derived from the evaluation weights (see evalRecalc() in eval.c).
+typedef struct {
+	VPacked pst[PieceNB][SqNB]; // Pawns are handled by pawnValue instead (so their entries are zero).
+	VPacked pawnValue[ColourNB][16][SqNB]; // Indexed by PawnType (see eval.c) in the middle.
+	int halfMoveFactors[128];
+	uint8_t weightEGFactors[128];
+	VPacked kingNearPasser[8];
+} EvalTables;
+
+extern TABLECONST EvalTables evalTables; // For the default weights (or in tuning builds, those set via the UCI options).
+
+typedef struct Eval Eval; // Holds the hash tables (and in tuning builds, weights) used by evaluate(), one per search context.
 
 void evalInit(void);
-void evalQuit(void);
 
-Score evaluate(const Pos *pos); // Returns score in CP.
+Eval *evalNew(void); // Returns NULL on failure. In tuning builds uses the UCI option weights until changed with evalSetOption().
+void evalFree(Eval *eval);
+
+void evalOptionsNew(Eval *eval); // Adds the PawnHash and MatHash UCI options (and their clear buttons), acting on eval.
+bool evalSetOption(Eval *eval, const char *name, const char *value); // As for the UCI options of the same name (in tuning builds, including the weights), returns false if name is unknown.
+
+Score evaluate(Eval *eval, const Pos *pos); // Returns score in CP.
 
-void evalClear(void); // Clear all saved data (called when we receive 'ucinewgame', for example).
+void evalClear(Eval *eval); // Clear all saved data (called when we receive 'ucinewgame', for example).
 
-EvalMatType evalGetMatType(const Pos *pos);
+void evalStatsWrite(const Eval *eval); // Hash table hit rates since last evalClear().
+
+EvalMatType evalGetMatType(Eval *eval, const Pos *pos);
+EvalMatType evalComputeMatType(const Pos *pos); // As evalGetMatType() but without using the hash table.
 
 const char *evalMatTypeToStr(EvalMatType matType);
 
-VPair evalComputePstScore(const Pos *pos);
+VPacked evalComputePstScore(const Pos *pos);
 
 void evalVPairAddTo(VPair *a, const VPair *b);
 void evalVPairSubFrom(VPair *a, const VPair *b);
@@ -49,4 +77,21 @@ VPair evalVPairSub(const VPair *a, const VPair *b);
 VPair evalVPairMul(const VPair *a, int c);
 VPair evalVPairNegation(const VPair *a);
 
+static inline VPacked evalVPairPack(const VPair *a) {
+	return VPACKED(a->mg, a->eg);
+}
+
+static inline Value evalVPackedEg(VPacked a) {
+	return (int32_t)(uint32_t)a; // Sign extend lower half.
+}
+
+static inline Value evalVPackedMg(VPacked a) {
+	return (int32_t)(uint32_t)(((uint64_t)a+0x80000000u)>>32); // Round to undo the borrow from a negative eg.
+}
+
+static inline VPair evalVPackedUnpack(VPacked a) {
+	VPair result={.mg=evalVPackedMg(a), .eg=evalVPackedEg(a)};
+	return result;
+}
+
 #endif
@@ -0,0 +1,188 @@
+#include <assert.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "fill.h"
+
+#define FillNotA 0xFEFEFEFEFEFEFEFEllu // All squares except the a-file.
+#define FillNotH 0x7F7F7F7F7F7F7F7Fllu // All squares except the h-file.
+#define FillNotAB 0xFCFCFCFCFCFCFCFCllu
+#define FillNotGH 0x3F3F3F3F3F3F3F3Fllu
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+BB fillShift(BB bb, int shift); // Left shift for positive shift, right shift for negative.
+BB fillOccludedAttacks(BB gen, BB empty, int shift, BB wrap); // Attacks in a single sliding direction, wrap is the set of squares which can be reached by the shift.
+
+#ifdef __AVX2__
+__m256i fillShift4(__m256i x, __m256i left, __m256i right);
+__m256i fillOccludedAttacks4(__m256i gen, __m256i empty, __m256i left, __m256i right, __m256i wrap); // As fillOccludedAttacks() but for four directions at once.
+BB fillOr4(__m256i x);
+__m256i fillPopCount4(__m256i x); // Population count of each 64 bit lane.
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+BB fillKnightAttacks(BB set) {
+	BB set1=(((set & FillNotH)<<17) | ((set & FillNotA)<<15) | ((set & FillNotH)>>15) | ((set & FillNotA)>>17));
+	BB set2=(((set & FillNotGH)<<10) | ((set & FillNotAB)<<6) | ((set & FillNotGH)>>6) | ((set & FillNotAB)>>10));
+	return set1 | set2;
+}
+
+BB fillBishopAttacks(BB set, BB occ) {
+#	ifdef __AVX2__
+	// Lanes are NE, NW, SE, SW.
+	const __m256i left=_mm256_setr_epi64x(9, 7, 64, 64), right=_mm256_setr_epi64x(64, 64, 7, 9);
+	const __m256i wrap=_mm256_setr_epi64x(FillNotA, FillNotH, FillNotA, FillNotH);
+	return fillOr4(fillOccludedAttacks4(_mm256_set1_epi64x(set), _mm256_set1_epi64x(~occ), left, right, wrap));
+#	else
+	BB empty=~occ;
+	return fillOccludedAttacks(set, empty, +9, FillNotA) | fillOccludedAttacks(set, empty, +7, FillNotH) |
+	       fillOccludedAttacks(set, empty, -7, FillNotA) | fillOccludedAttacks(set, empty, -9, FillNotH);
+#	endif
+}
+
+BB fillRookAttacks(BB set, BB occ) {
+#	ifdef __AVX2__
+	// Lanes are N, E, S, W.
+	const __m256i left=_mm256_setr_epi64x(8, 1, 64, 64), right=_mm256_setr_epi64x(64, 64, 8, 1);
+	const __m256i wrap=_mm256_setr_epi64x(BBAll, FillNotA, BBAll, FillNotH);
+	return fillOr4(fillOccludedAttacks4(_mm256_set1_epi64x(set), _mm256_set1_epi64x(~occ), left, right, wrap));
+#	else
+	BB empty=~occ;
+	return fillOccludedAttacks(set, empty, +8, BBAll) | fillOccludedAttacks(set, empty, +1, FillNotA) |
+	       fillOccludedAttacks(set, empty, -8, BBAll) | fillOccludedAttacks(set, empty, -1, FillNotH);
+#	endif
+}
+
+BB fillQueenAttacks(BB set, BB occ) {
+	return fillBishopAttacks(set, occ) | fillRookAttacks(set, occ);
+}
+
+BB fillKingAttacks(BB set) {
+	BB attacks=(((set & FillNotH)<<1) | ((set & FillNotA)>>1));
+	set|=attacks;
+	attacks|=((set<<8) | (set>>8));
+	return attacks;
+}
+
+BB fillAttacksPieceType(PieceType type, BB set, BB occ) {
+	switch(type) {
+		case PieceTypeKnight: return fillKnightAttacks(set); break;
+		case PieceTypeBishopL: return fillBishopAttacks(set, occ); break;
+		case PieceTypeBishopD: return fillBishopAttacks(set, occ); break;
+		case PieceTypeRook: return fillRookAttacks(set, occ); break;
+		case PieceTypeQueen: return fillQueenAttacks(set, occ); break;
+		case PieceTypeKing: return fillKingAttacks(set); break;
+		default:
+			assert(false);
+			return BBNone;
+		break;
+	}
+}
+
+unsigned fillKnightMobility(BB set, BB allowed) {
+	// Each of the eight jumps moves every knight to a different square, so
+	// counting per jump direction gives the same total as counting per knight.
+#	ifdef __AVX2__
+	const __m256i left=_mm256_setr_epi64x(17, 15, 10, 6), right=_mm256_setr_epi64x(15, 17, 6, 10);
+	const __m256i mask=_mm256_setr_epi64x(FillNotH, FillNotA, FillNotGH, FillNotAB); // Same for both shift directions.
+	__m256i setV=_mm256_and_si256(_mm256_set1_epi64x(set), mask), allowedV=_mm256_set1_epi64x(allowed);
+	__m256i up=_mm256_and_si256(_mm256_sllv_epi64(setV, left), allowedV);
+	__m256i down=_mm256_and_si256(_mm256_srlv_epi64(setV, right), allowedV);
+	__m256i counts=_mm256_add_epi64(fillPopCount4(up), fillPopCount4(down));
+	__m128i sum=_mm_add_epi64(_mm256_castsi256_si128(counts), _mm256_extracti128_si256(counts, 1));
+	return _mm_cvtsi128_si64(sum)+_mm_extract_epi64(sum, 1);
+#	else
+	return bbPopCount(((set & FillNotH)<<17) & allowed)+bbPopCount(((set & FillNotA)<<15) & allowed)+
+	       bbPopCount(((set & FillNotGH)<<10) & allowed)+bbPopCount(((set & FillNotAB)<<6) & allowed)+
+	       bbPopCount(((set & FillNotH)>>15) & allowed)+bbPopCount(((set & FillNotA)>>17) & allowed)+
+	       bbPopCount(((set & FillNotGH)>>6) & allowed)+bbPopCount(((set & FillNotAB)>>10) & allowed);
+#	endif
+}
+
+BB fillReach(PieceType type, BB init, BB occ, BB target) {
+	assert(type>=PieceTypeKnight && type<=PieceTypeKing);
+
+	// Expand a whole ring of newly reached squares per iteration.
+	BB fill=init;
+	BB frontier=init;
+	while(frontier!=BBNone) {
+		BB attacks=fillAttacksPieceType(type, frontier, occ);
+
+		// Hit target?
+		if ((attacks & target)!=BBNone)
+			return attacks;
+
+		// Continue from new (unoccupied) squares only.
+		frontier=(attacks & ~(fill | occ));
+		fill|=attacks;
+	}
+
+	return fill;
+}
+
+bool fillHasSIMD(void) {
+#	ifdef __AVX2__
+	return true;
+#	else
+	return false;
+#	endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+BB fillShift(BB bb, int shift) {
+	return (shift>=0 ? bb<<shift : bb>>(-shift));
+}
+
+BB fillOccludedAttacks(BB gen, BB empty, int shift, BB wrap) {
+	BB pro=(empty & wrap);
+	gen|=(pro & fillShift(gen, shift));
+	pro&=fillShift(pro, shift);
+	gen|=(pro & fillShift(gen, 2*shift));
+	pro&=fillShift(pro, 2*shift);
+	gen|=(pro & fillShift(gen, 4*shift));
+	return (fillShift(gen, shift) & wrap);
+}
+
+#ifdef __AVX2__
+__m256i fillShift4(__m256i x, __m256i left, __m256i right) {
+	// Shift counts of 64 or more give zero, so each lane only uses one of the two shifts.
+	return _mm256_or_si256(_mm256_sllv_epi64(x, left), _mm256_srlv_epi64(x, right));
+}
+
+__m256i fillOccludedAttacks4(__m256i gen, __m256i empty, __m256i left, __m256i right, __m256i wrap) {
+	__m256i left2=_mm256_add_epi64(left, left), right2=_mm256_add_epi64(right, right);
+	__m256i left4=_mm256_add_epi64(left2, left2), right4=_mm256_add_epi64(right2, right2);
+
+	__m256i pro=_mm256_and_si256(empty, wrap);
+	gen=_mm256_or_si256(gen, _mm256_and_si256(pro, fillShift4(gen, left, right)));
+	pro=_mm256_and_si256(pro, fillShift4(pro, left, right));
+	gen=_mm256_or_si256(gen, _mm256_and_si256(pro, fillShift4(gen, left2, right2)));
+	pro=_mm256_and_si256(pro, fillShift4(pro, left2, right2));
+	gen=_mm256_or_si256(gen, _mm256_and_si256(pro, fillShift4(gen, left4, right4)));
+	return _mm256_and_si256(fillShift4(gen, left, right), wrap);
+}
+
+BB fillOr4(__m256i x) {
+	__m128i y=_mm_or_si128(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+	return ((BB)_mm_cvtsi128_si64(y)) | ((BB)_mm_extract_epi64(y, 1));
+}
+
+__m256i fillPopCount4(__m256i x) {
+	// Nibble lookup then sum the bytes of each lane.
+	const __m256i table=_mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4, 0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+	const __m256i low=_mm256_set1_epi8(0x0F);
+	__m256i lo=_mm256_shuffle_epi8(table, _mm256_and_si256(x, low));
+	__m256i hi=_mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi64(x, 4), low));
+	return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+#endif
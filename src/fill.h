@@ -0,0 +1,29 @@
+#ifndef FILL_H
+#define FILL_H
+
+#include <stdbool.h>
+
+#include "bb.h"
+#include "piece.h"
+
+// Set-wise attack generation (Kogge-Stone occluded fills), computing the union
+// of the attacks of every piece in a set at once rather than one square at a
+// time. The sliding directions are processed in parallel using AVX2 if
+// available, otherwise a portable scalar version is used.
+
+BB fillKnightAttacks(BB set);
+BB fillBishopAttacks(BB set, BB occ);
+BB fillRookAttacks(BB set, BB occ);
+BB fillQueenAttacks(BB set, BB occ);
+BB fillKingAttacks(BB set);
+
+BB fillAttacksPieceType(PieceType type, BB set, BB occ); // As this is colour-agnostic pawns are not supported.
+
+unsigned fillKnightMobility(BB set, BB allowed); // Sum over all knights in set of bbPopCount(attacksKnight(sq) & allowed).
+
+BB fillReach(PieceType type, BB init, BB occ, BB target); // Squares that pieces of the given type starting on init can attack in any number of
+  // moves, without ever moving to a square in occ. Returns early (with at least one target square set) if target is reachable.
+
+bool fillHasSIMD(void); // True if compiled with the AVX2 kernels.
+
+#endif
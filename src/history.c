@@ -6,36 +6,34 @@
 
 const History HistoryMax=(((History)1)<<HistoryBit);
 
-History history[PieceNB][SqNB];
-
-void historyInc(Piece fromPiece, Sq toSq, unsigned int depth) {
+void historyInc(HistoryTable *table, Piece fromPiece, Sq toSq, unsigned int depth) {
 	assert(pieceIsValid(fromPiece));
 	assert(sqIsValid(toSq));
 
 	// Increment count in table.
-	History *counter=&history[fromPiece][toSq];
+	History *counter=&table->counters[fromPiece][toSq];
 	*counter+=(((History)1)<<utilMin(depth, HistoryBit-1));
 
 	// Overflow? (not a literal overflow, but beyond desired range).
 	if (*counter>=HistoryMax)
-		historyAge();
+		historyAge(table);
 	assert(*counter<HistoryMax);
 }
 
-History historyGet(Piece fromPiece, Sq toSq) {
+History historyGet(const HistoryTable *table, Piece fromPiece, Sq toSq) {
 	assert(pieceIsValid(fromPiece));
 	assert(sqIsValid(toSq));
-	assert(history[fromPiece][toSq]<HistoryMax);
-	return history[fromPiece][toSq];
+	assert(table->counters[fromPiece][toSq]<HistoryMax);
+	return table->counters[fromPiece][toSq];
 }
 
-void historyAge(void) {
+void historyAge(HistoryTable *table) {
 	unsigned int i, j;
 	for(i=0;i<PieceNB;++i)
 		for(j=0;j<SqNB;++j)
-			history[i][j]/=2;
+			table->counters[i][j]/=2;
 }
 
-void historyClear(void) {
-	memset(history, 0, sizeof(history));
+void historyClear(HistoryTable *table) {
+	memset(table->counters, 0, sizeof(table->counters));
 }
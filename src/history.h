@@ -10,9 +10,14 @@ typedef uint64_t History;
 #define HistoryBit 41
 extern const History HistoryMax;
 
-void historyInc(Piece fromPiece, Sq toSq, unsigned int depth);
-History historyGet(Piece fromPiece, Sq toSq);
-void historyAge(void);
-void historyClear(void);
+// Entries should be considered private - only here to allow embedding in other structs.
+typedef struct {
+	History counters[PieceNB][SqNB];
+} HistoryTable;
+
+void historyInc(HistoryTable *table, Piece fromPiece, Sq toSq, unsigned int depth);
+History historyGet(const HistoryTable *table, Piece fromPiece, Sq toSq);
+void historyAge(HistoryTable *table);
+void historyClear(HistoryTable *table);
 
 #endif
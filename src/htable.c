@@ -88,6 +88,10 @@ void htableResizeInterface(void *table, long long int sizeMb) {
 	htableResize(table, sizeMb);
 }
 
+size_t htableGetSize(const HTable *table) {
+	return htableGetEntryCount(table)*table->entrySize;
+}
+
 void htableClear(HTable *table) {
 	memset(table->entries, 0, table->entryCount*table->entrySize);
 }
@@ -15,6 +15,7 @@ void htableFree(HTable *table);
 
 bool htableResize(HTable *table, unsigned int sizeMb); // SizeMb>0.
 void htableResizeInterface(void *table, long long int sizeMb); // Interface for UCI spin option code.
+size_t htableGetSize(const HTable *table); // In bytes.
 
 void htableClear(HTable *table);
 void htableClearInterface(void *table); // Interface for UCI button option code.
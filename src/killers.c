@@ -2,28 +2,32 @@
 
 #include "killers.h"
 
-Move killers[DepthMax][KillersPerPly];
-
-void killersCutoff(Depth ply, Move move) {
+void killersCutoff(Killers *killers, Depth ply, Move move) {
 	assert(moveIsValid(move));
 
 	int i;
+	Move *list=killers->moves[ply];
 
 	// Find which slot to overwrite.
 	// (we may have an empty slot, or the move may already be in the list)
 	for(i=0;i<KillersPerPly-1;++i)
-		if (move==killers[ply][i] || killers[ply][i]==MoveInvalid)
+		if (move==list[i] || list[i]==MoveInvalid)
 			break;
 
 	// Move entries down, and insert 'new' move at front.
 	for(;i>0;--i)
-		killers[ply][i]=killers[ply][i-1];
-	killers[ply][0]=move;
+		list[i]=list[i-1];
+	list[0]=move;
 }
 
-void killersClear(void) {
+void killersClear(Killers *killers) {
 	int i, j;
 	for(i=0;i<DepthMax;++i)
 		for(j=0;j<KillersPerPly;++j)
-			killers[i][j]=MoveInvalid;
+			killers->moves[i][j]=MoveInvalid;
+}
+
+const Move *killersGet(const Killers *killers, Depth ply) {
+	assert(depthIsValid(ply));
+	return killers->moves[ply];
 }
@@ -6,9 +6,14 @@
 
 #define KillersPerPly 4
 
-extern Move killers[DepthMax][KillersPerPly];
+// Entries should be considered private - only here to allow embedding in other structs.
+typedef struct {
+	Move moves[DepthMax][KillersPerPly];
+} Killers;
 
-void killersCutoff(Depth ply, Move move);
-void killersClear(void);
+void killersCutoff(Killers *killers, Depth ply, Move move);
+void killersClear(Killers *killers);
+
+const Move *killersGet(const Killers *killers, Depth ply); // Returns KillersPerPly moves, any unused slots (always at the end) are MoveInvalid.
 
 #endif
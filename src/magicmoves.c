@@ -8,6 +8,9 @@
  *The magic keys are not optimal for all squares but they are very close
  *to optimal.
  *
+ *Altered for robocide: if TABLES is defined the databases are generated at
+ *build time (see tables.h) and initmagicmoves() is not available.
+ *
  *Copyright (C) 2007 Pradyumna Kannan.
  *
  *This code is provided 'as-is', without any express or implied warranty.
@@ -28,6 +31,7 @@
  */
 
 #include "magicmoves.h"
+#include "tables.h"
 
 #ifdef _MSC_VER
 	#pragma message("MSC compatible compiler detected -- turning off warning 4312,4146")
@@ -155,7 +159,11 @@ const U64 magicmoves_b_mask[64]=
 };
 
 #ifdef MINIMIZE_MAGIC
+#ifdef TABLES
+extern const U64 magicmovesbdb[5248]; // Generated at build time, see tables.h.
+#else
 U64 magicmovesbdb[5248];
+#endif
 const U64* magicmoves_b_indices[64]=
 {
 	magicmovesbdb+4992, magicmovesbdb+2624,  magicmovesbdb+256,  magicmovesbdb+896,
@@ -185,7 +193,11 @@ const U64* magicmoves_b_indices[64]=
 #endif
 
 #ifdef MINIMIZE_MAGIC
+#ifdef TABLES
+extern const U64 magicmovesrdb[102400]; // Generated at build time, see tables.h.
+#else
 U64 magicmovesrdb[102400];
+#endif
 const U64* magicmoves_r_indices[64]=
 {
 	magicmovesrdb+86016, magicmovesrdb+73728, magicmovesrdb+36864, magicmovesrdb+43008,
@@ -304,6 +316,8 @@ U64 initmagicmoves_Bmoves(const int square, const U64 occ)
 	return ret;
 }
 
+#ifndef TABLES
+
 //used so that the original indices can be left as const so that the compiler can optimize better
 
 #ifndef PERFECT_MAGIC_HASH
@@ -461,3 +475,5 @@ void initmagicmoves(void)
 		}
 	}
 }
+
+#endif // TABLES
@@ -1,15 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "analyse.h"
 #include "attacks.h"
 #include "bb.h"
 #include "bitbase.h"
+#include "book.h"
 #include "eval.h"
 #include "main.h"
+#include "perft.h"
 #include "pos.h"
 #include "search.h"
-#include "tt.h"
 #include "uci.h"
+#include "util.h"
 
 int main(int argc, char **argv) {
 	uciInit();
@@ -18,14 +21,20 @@ int main(int argc, char **argv) {
 	bitbaseInit();
 	posInit();
 	evalInit();
-	ttInit();
 	searchInit();
+	perftInit();
+	bookInit();
 
-	uciLoop();
+	// Either batch analysis from the command line (see analyseArgs()) or UCI as usual.
+	if (argc>1 && utilStrEqual(argv[1], "--batch")) {
+		setvbuf(stdout, NULL, _IOLBF, 0); // So results stream out as each position completes.
+		analyseArgs(argc-2, argv+2);
+	} else
+		uciLoop();
 
+	bookQuit();
+	perftQuit();
 	searchQuit();
-	ttQuit();
-	evalQuit();
 	bitbaseQuit();
 
 	return EXIT_SUCCESS;
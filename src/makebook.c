@@ -0,0 +1,387 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "book.h"
+#include "makebook.h"
+#include "pgn.h"
+#include "thread.h"
+#include "time.h"
+#include "uci.h"
+#include "util.h"
+
+// Books are built in two phases. Each thread parses part of the input, accumulating counts per (key, move) pair in
+// its own hash table. Whenever a table fills up its entries are sorted and written to a temporary file as a run.
+// Then all runs are merged (summing counts for pairs seen in more than one run) and the filtered, weighted result is
+// written out sequentially. So memory use is bounded regardless of the size of the input.
+
+#define MakebookThreadsMax 64
+#define MakebookGroupMax 256 // More than the number of legal moves in any position.
+#define MakebookOutputBufferSize (1u<<20)
+#define MakebookRunBufferSize (1u<<16) // Per run when merging, so many runs can be merged at once.
+
+typedef struct {
+	Key key;
+	uint16_t move, padding;
+	uint32_t games, wins, draws; // From the point of view of the side making the move.
+} MakebookEntry;
+
+typedef struct {
+	const MakebookOptions *options;
+	PgnReader *reader;
+	MakebookEntry *table; // Open addressing with linear probing, empty entries have games set to 0.
+	size_t tableSize, tableCount, tableLimit;
+	FILE **runs;
+	size_t runCount;
+	unsigned long long int games, skipped, positions;
+	bool error;
+} MakebookWork;
+
+typedef struct {
+	FILE *file;
+	char *buffer;
+	MakebookEntry entry;
+} MakebookRun;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+void makebookWorker(void *userData);
+void makebookAdd(MakebookWork *work, Key key, uint16_t move, unsigned int result); // result is 0, 1 or 2 for a loss, draw or win.
+bool makebookSpill(MakebookWork *work); // Sorts the table and writes it out as a new run, leaving the table empty.
+
+bool makebookMerge(MakebookRun *runs, size_t runCount, FILE *output, const MakebookOptions *options, unsigned long long int *entryCount, unsigned long long int *keyCount);
+void makebookHeapDown(MakebookRun **heap, size_t count, size_t index);
+bool makebookRunNext(MakebookRun *run); // Reads the next entry, returning false at the end of the run.
+bool makebookWriteGroup(FILE *output, MakebookEntry *group, size_t count, const MakebookOptions *options, unsigned long long int *entryCount); // All entries should have the same key.
+
+int makebookEntryCompare(const void *a, const void *b); // By key then move.
+int makebookBookEntryCompare(const void *a, const void *b); // By weight, largest first.
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void makebookOptionsInit(MakebookOptions *options) {
+	options->minGames=1;
+	options->maxPly=32;
+	options->winWeight=2;
+	options->drawWeight=1;
+	options->lossWeight=0;
+	options->threads=1;
+	options->hashMb=256;
+}
+
+void makebook(const char *inPath, const char *outPath, const MakebookOptions *options) {
+	unsigned int threads=utilMax(1u, utilMin(options->threads, (unsigned int)MakebookThreadsMax));
+
+	PgnReader *reader=pgnReaderNew(inPath);
+	if (reader==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", inPath);
+		return;
+	}
+	FILE *output=fopen(outPath, "wb");
+	if (output==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", outPath);
+		pgnReaderFree(reader);
+		return;
+	}
+	setvbuf(output, NULL, _IOFBF, MakebookOutputBufferSize);
+
+	// Accumulate counts from each part of the input in its own thread.
+	TimeMs time=timeGet();
+	PgnReader *readers[MakebookThreadsMax];
+	Thread *workers[MakebookThreadsMax];
+	MakebookWork work[MakebookThreadsMax];
+	size_t tableSize=1;
+	while(tableSize*2*sizeof(MakebookEntry)<=(options->hashMb*1024llu*1024llu)/threads)
+		tableSize*=2;
+	unsigned int count=pgnReaderSplit(reader, readers, threads);
+	for(unsigned int i=0;i<count;++i) {
+		memset(&work[i], 0, sizeof(MakebookWork));
+		work[i].options=options;
+		work[i].reader=readers[i];
+		work[i].tableSize=tableSize;
+		work[i].tableLimit=(tableSize*3)/4;
+		workers[i]=threadNew();
+		if (workers[i]==NULL)
+			makebookWorker(&work[i]);
+		else
+			threadRun(workers[i], &makebookWorker, &work[i]);
+	}
+
+	// Wait and collect runs.
+	unsigned long long int games=0, skipped=0, positions=0;
+	size_t runCount=0;
+	bool error=false;
+	for(unsigned int i=0;i<count;++i) {
+		threadFree(workers[i]); // Waits for the thread to finish.
+		pgnReaderFree(readers[i]);
+		games+=work[i].games;
+		skipped+=work[i].skipped;
+		positions+=work[i].positions;
+		runCount+=work[i].runCount;
+		error|=work[i].error;
+	}
+	TimeMs parseTime=timeGet()-time;
+
+	MakebookRun *runs=malloc(runCount*sizeof(MakebookRun)+1);
+	char *buffers=malloc(runCount*MakebookRunBufferSize+1);
+	if (runs==NULL || buffers==NULL) {
+		uciWrite("Error: Could not allocate memory.\n");
+		error=true;
+	}
+	size_t runIndex=0;
+	for(unsigned int i=0;i<count;++i) {
+		for(size_t j=0;j<work[i].runCount;++j) {
+			if (!error) {
+				runs[runIndex].file=work[i].runs[j];
+				runs[runIndex].buffer=buffers+runIndex*MakebookRunBufferSize;
+				setvbuf(runs[runIndex].file, runs[runIndex].buffer, _IOFBF, MakebookRunBufferSize);
+				++runIndex;
+			} else
+				fclose(work[i].runs[j]);
+		}
+		free(work[i].runs);
+	}
+
+	// Merge runs into the final book.
+	unsigned long long int entryCount=0, keyCount=0;
+	if (!error && !makebookMerge(runs, runCount, output, options, &entryCount, &keyCount)) {
+		uciWrite("Error: Could not write to '%s'.\n", outPath);
+		error=true;
+	}
+	for(size_t i=0;i<runIndex;++i)
+		fclose(runs[i].file);
+	free(runs);
+	free(buffers);
+	if (fclose(output)!=0 && !error) {
+		uciWrite("Error: Could not write to '%s'.\n", outPath);
+		error=true;
+	}
+	pgnReaderFree(reader);
+
+	time=timeGet()-time;
+	uciWrite("games %llu (skipped %llu) positions %llu runs %zu keys %llu entries %llu time %llums (parse %llums)%s\n", games, skipped,
+	         positions, runCount, keyCount, entryCount, time, parseTime, (error ? " FAILED" : ""));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void makebookWorker(void *userData) {
+	MakebookWork *work=(MakebookWork *)userData;
+
+	PgnGame *game=malloc(sizeof(PgnGame));
+	Pos *pos=posNew(NULL);
+	work->table=calloc(work->tableSize, sizeof(MakebookEntry));
+	if (game==NULL || pos==NULL || work->table==NULL) {
+		uciWrite("Error: Could not allocate memory.\n");
+		work->error=true;
+		goto cleanup;
+	}
+
+	while(pgnReaderNext(work->reader, game, pos) && !work->error) {
+		if (game->result==PgnResultUnknown) {
+			++work->skipped;
+			continue;
+		}
+		++work->games;
+
+		// Replay game from the start, adding each move (PgnResult values are also white's score).
+		if (!posSetToFEN(pos, game->startFen))
+			continue;
+		unsigned int plies=utilMin(game->moveCount, work->options->maxPly);
+		for(unsigned int ply=0;ply<plies;++ply) {
+			Move move=game->moves[ply];
+			unsigned int result=(posGetSTM(pos)==ColourWhite ? game->result : 2-game->result);
+			makebookAdd(work, bookKey(pos), bookMoveToPolyglot(pos, move), result);
+			posMakeMove(pos, move);
+			++work->positions;
+		}
+	}
+
+	// Write out whatever is left.
+	if (work->tableCount>0 && !work->error)
+		makebookSpill(work);
+
+	cleanup:
+	free(work->table);
+	work->table=NULL;
+	free(game);
+	if (pos!=NULL)
+		posFree(pos);
+}
+
+void makebookAdd(MakebookWork *work, Key key, uint16_t move, unsigned int result) {
+	assert(result<=2);
+
+	size_t mask=work->tableSize-1;
+	for(size_t i=(key^(move*0x9E3779B97F4A7C15llu))&mask;;i=(i+1)&mask) { // Keys are already random so the low bits are fine.
+		MakebookEntry *entry=&work->table[i];
+		if (entry->games==0) {
+			entry->key=key;
+			entry->move=move;
+			++work->tableCount;
+		} else if (entry->key!=key || entry->move!=move)
+			continue;
+
+		++entry->games;
+		entry->wins+=(result==2);
+		entry->draws+=(result==1);
+		break;
+	}
+
+	if (work->tableCount>=work->tableLimit)
+		makebookSpill(work);
+}
+
+bool makebookSpill(MakebookWork *work) {
+	// Compact and sort.
+	size_t count=0;
+	for(size_t i=0;i<work->tableSize;++i)
+		if (work->table[i].games>0)
+			work->table[count++]=work->table[i];
+	qsort(work->table, count, sizeof(MakebookEntry), &makebookEntryCompare);
+
+	// Write run.
+	FILE **runs=realloc(work->runs, (work->runCount+1)*sizeof(FILE *));
+	FILE *run=tmpfile();
+	if (runs!=NULL)
+		work->runs=runs;
+	if (runs==NULL || run==NULL || fwrite(work->table, sizeof(MakebookEntry), count, run)!=count || fflush(run)!=0) {
+		uciWrite("Error: Could not write temporary file.\n");
+		if (run!=NULL)
+			fclose(run);
+		work->error=true;
+		return false;
+	}
+	rewind(run);
+	work->runs[work->runCount++]=run;
+
+	// Clear table.
+	memset(work->table, 0, work->tableSize*sizeof(MakebookEntry));
+	work->tableCount=0;
+
+	return true;
+}
+
+bool makebookMerge(MakebookRun *runs, size_t runCount, FILE *output, const MakebookOptions *options, unsigned long long int *entryCount, unsigned long long int *keyCount) {
+	// Build heap of runs by their first entry.
+	MakebookRun **heap=malloc(runCount*sizeof(MakebookRun *)+1);
+	if (heap==NULL)
+		return false;
+	size_t heapSize=0;
+	for(size_t i=0;i<runCount;++i)
+		if (makebookRunNext(&runs[i]))
+			heap[heapSize++]=&runs[i];
+	for(size_t i=heapSize/2;i-->0;)
+		makebookHeapDown(heap, heapSize, i);
+
+	// Repeatedly take the smallest entry, combining equal ones and writing out each key's moves together.
+	MakebookEntry group[MakebookGroupMax];
+	size_t groupCount=0;
+	while(heapSize>0) {
+		MakebookEntry entry=heap[0]->entry;
+		if (!makebookRunNext(heap[0]))
+			heap[0]=heap[--heapSize];
+		makebookHeapDown(heap, heapSize, 0);
+
+		if (groupCount>0 && group[groupCount-1].key==entry.key && group[groupCount-1].move==entry.move) {
+			group[groupCount-1].games+=entry.games;
+			group[groupCount-1].wins+=entry.wins;
+			group[groupCount-1].draws+=entry.draws;
+			continue;
+		}
+		if (groupCount>0 && (group[0].key!=entry.key || groupCount==MakebookGroupMax)) {
+			if (!makebookWriteGroup(output, group, groupCount, options, entryCount)) {
+				free(heap);
+				return false;
+			}
+			++*keyCount;
+			groupCount=0;
+		}
+		group[groupCount++]=entry;
+	}
+	free(heap);
+	if (groupCount>0) {
+		if (!makebookWriteGroup(output, group, groupCount, options, entryCount))
+			return false;
+		++*keyCount;
+	}
+
+	return true;
+}
+
+void makebookHeapDown(MakebookRun **heap, size_t count, size_t index) {
+	while(1) {
+		size_t smallest=index, left=2*index+1, right=2*index+2;
+		if (left<count && makebookEntryCompare(&heap[left]->entry, &heap[smallest]->entry)<0)
+			smallest=left;
+		if (right<count && makebookEntryCompare(&heap[right]->entry, &heap[smallest]->entry)<0)
+			smallest=right;
+		if (smallest==index)
+			return;
+		MakebookRun *temp=heap[index];
+		heap[index]=heap[smallest];
+		heap[smallest]=temp;
+		index=smallest;
+	}
+}
+
+bool makebookRunNext(MakebookRun *run) {
+	return (fread(&run->entry, sizeof(MakebookEntry), 1, run->file)==1);
+}
+
+bool makebookWriteGroup(FILE *output, MakebookEntry *group, size_t count, const MakebookOptions *options, unsigned long long int *entryCount) {
+	// Filter and weight.
+	BookEntry entries[MakebookGroupMax];
+	unsigned long long int weights[MakebookGroupMax], maxWeight=0;
+	size_t entriesCount=0;
+	for(size_t i=0;i<count;++i) {
+		if (group[i].games<options->minGames)
+			continue;
+		unsigned long long int losses=group[i].games-group[i].wins-group[i].draws;
+		unsigned long long int weight=options->winWeight*(unsigned long long int)group[i].wins+options->drawWeight*(unsigned long long int)group[i].draws+
+		                              options->lossWeight*losses;
+		if (weight==0)
+			continue;
+		entries[entriesCount].key=group[i].key;
+		entries[entriesCount].move=group[i].move;
+		entries[entriesCount].learn=0;
+		weights[entriesCount++]=weight;
+		maxWeight=utilMax(maxWeight, weight);
+	}
+
+	// Scale weights to fit (keeping every move above zero), then order by weight as is usual for Polyglot books.
+	for(size_t i=0;i<entriesCount;++i)
+		entries[i].weight=(maxWeight>UINT16_MAX ? utilMax(1llu, (weights[i]*UINT16_MAX)/maxWeight) : weights[i]);
+	qsort(entries, entriesCount, sizeof(BookEntry), &makebookBookEntryCompare);
+
+	// Write.
+	for(size_t i=0;i<entriesCount;++i) {
+		uint8_t bytes[BookEntrySize];
+		bookEntryWrite(bytes, &entries[i]);
+		if (fwrite(bytes, BookEntrySize, 1, output)!=1)
+			return false;
+	}
+	*entryCount+=entriesCount;
+
+	return true;
+}
+
+int makebookEntryCompare(const void *a, const void *b) {
+	const MakebookEntry *entryA=(const MakebookEntry *)a, *entryB=(const MakebookEntry *)b;
+	if (entryA->key!=entryB->key)
+		return (entryA->key<entryB->key ? -1 : 1);
+	return (int)entryA->move-(int)entryB->move;
+}
+
+int makebookBookEntryCompare(const void *a, const void *b) {
+	const BookEntry *entryA=(const BookEntry *)a, *entryB=(const BookEntry *)b;
+	return (int)entryB->weight-(int)entryA->weight;
+}
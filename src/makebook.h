@@ -0,0 +1,20 @@
+#ifndef MAKEBOOK_H
+#define MAKEBOOK_H
+
+#include <stdbool.h>
+
+typedef struct {
+	unsigned int minGames; // Moves played in fewer games than this are left out.
+	unsigned int maxPly; // Only positions before this ply (counting from the start of each game) are included.
+	unsigned int winWeight, drawWeight, lossWeight; // Per game, from the point of view of the side making the move.
+	unsigned int threads;
+	unsigned int hashMb; // Total memory for accumulating counts before they are spilled to disk.
+} MakebookOptions;
+
+void makebookOptionsInit(MakebookOptions *options);
+
+// Builds a Polyglot style book (see book.h) at outPath from the games in the PGN file at inPath. Games with an unknown
+// result are skipped.
+void makebook(const char *inPath, const char *outPath, const MakebookOptions *options);
+
+#endif
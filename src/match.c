@@ -0,0 +1,465 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "epd.h"
+#include "eval.h"
+#include "match.h"
+#include "moves.h"
+#include "search.h"
+#include "thread.h"
+#include "uci.h"
+#include "util.h"
+
+#define MatchThreadsMax 64
+#define MatchParamsMax 32
+#define MatchParamLenMax 64
+#define MatchRandomPlies 4 // Length of random openings...
+#define MatchOpeningScoreMax 100 // ...which are rejected if unbalanced according to a search (as both games of the pair would likely be won by the same colour).
+#define MatchMaxPlies 400 // Games reaching this are adjudicated as draws.
+#define MatchAdjudicateScore 1500 // Games are adjudicated as wins once the search score exceeds this...
+#define MatchAdjudicatePlies 8 // ...for this many consecutive plies (from both sides' point of view).
+
+typedef struct {
+	char names[MatchParamsMax][MatchParamLenMax], values[MatchParamsMax][MatchParamLenMax];
+	unsigned int count;
+} MatchSet;
+
+typedef struct {
+	Score score;
+	Move bestMove;
+} MatchSearch;
+
+typedef struct MatchShared MatchShared;
+
+typedef struct {
+	MatchShared *shared;
+	Search *searches[2]; // Contexts with set A and set B applied.
+	Pos *pos;
+} MatchWork;
+
+struct MatchShared {
+	const MatchOptions *options;
+	char **openings;
+	size_t openingCount;
+	double lowerBound, upperBound, score0, score1; // SPRT.
+	TimeMs startTime;
+
+	Lock *lock; // Protects the fields below.
+	unsigned int nextPair;
+	unsigned int results[3]; // Loss, draw, win for A.
+	const char *verdict; // Set once the SPRT accepts either hypothesis, stopping further pairs from starting.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+bool matchSetParse(MatchSet *set, const char *string);
+bool matchSetApply(const MatchSet *set, Search *search);
+bool matchSetHasName(const MatchSet *set, const char *name);
+
+char **matchOpeningsLoad(const char *path, size_t *count); // Returns NULL on failure, otherwise the FEN/EPD lines which parsed.
+void matchOpeningsFree(char **openings, size_t count);
+void matchRandomOpening(Pos *pos, Search *search, const MatchOptions *options, uint64_t *randState);
+
+void matchWorker(void *userData);
+void matchWorkerResult(MatchShared *shared, const unsigned int pairResults[3]);
+
+unsigned int matchGame(Pos *pos, Search *white, Search *black, const MatchOptions *options); // Returns result for white (0 loss, 1 draw, 2 win).
+void matchSearch(Search *search, const Pos *pos, const MatchOptions *options, MatchSearch *result);
+void matchSearchDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time);
+
+double matchEloToScore(double elo);
+double matchScoreToElo(double score);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void matchOptionsInit(MatchOptions *options) {
+	options->games=1000;
+	options->moveTime=TimeMsInvalid;
+	options->nodes=0;
+	options->openingsPath=NULL;
+	options->elo0=0.0;
+	options->elo1=5.0;
+	options->alpha=0.05;
+	options->beta=0.05;
+	options->seed=timeGet();
+	options->threads=1;
+}
+
+void match(const char *setAString, const char *setBString, const MatchOptions *options) {
+	unsigned int threads=utilMax(1u, utilMin(options->threads, (unsigned int)MatchThreadsMax));
+
+	// Parse and check parameter sets.
+	MatchSet sets[2];
+	if (!matchSetParse(&sets[0], setAString) || !matchSetParse(&sets[1], setBString))
+		return;
+	for(unsigned int i=0;i<2;++i)
+		for(unsigned int j=0;j<sets[i].count;++j)
+			if (!matchSetHasName(&sets[1-i], sets[i].names[j])) {
+				uciWrite("Error: Option '%s' must be given for both sides.\n", sets[i].names[j]);
+				return;
+			}
+
+	// Load openings.
+	MatchShared shared;
+	memset(&shared, 0, sizeof(shared));
+	shared.options=options;
+	if (options->openingsPath!=NULL) {
+		shared.openings=matchOpeningsLoad(options->openingsPath, &shared.openingCount);
+		if (shared.openings==NULL)
+			return;
+		if (shared.openingCount==0) {
+			uciWrite("Error: No usable positions in '%s'.\n", options->openingsPath);
+			matchOpeningsFree(shared.openings, shared.openingCount);
+			return;
+		}
+	}
+
+	// Create two search contexts and a position for each worker, applying each set to its own context (so unknown
+	// names are caught before any games are played).
+	MatchWork work[MatchThreadsMax];
+	unsigned int workCount=0;
+	bool error=((shared.lock=lockNew(1))==NULL);
+	if (error)
+		uciWrite("Error: Out of memory.\n");
+	while(!error && workCount<threads) {
+		MatchWork *w=&work[workCount];
+		w->shared=&shared;
+		w->searches[0]=searchNew();
+		w->searches[1]=searchNew();
+		w->pos=posNew(NULL);
+		if (w->searches[0]==NULL || w->searches[1]==NULL || w->pos==NULL) {
+			searchFree(w->searches[0]);
+			searchFree(w->searches[1]);
+			if (w->pos!=NULL)
+				posFree(w->pos);
+			if (workCount==0) {
+				uciWrite("Error: Could not allocate search.\n");
+				error=true;
+			} else
+				uciWrite("Error: Could only allocate searches for %u of %u threads.\n", workCount, threads);
+			break;
+		}
+		++workCount;
+		if (!matchSetApply(&sets[0], w->searches[0]) || !matchSetApply(&sets[1], w->searches[1]))
+			error=true;
+	}
+
+	if (!error) {
+		// SPRT bounds on the log-likelihood ratio.
+		shared.lowerBound=log(options->beta/(1.0-options->alpha));
+		shared.upperBound=log((1.0-options->beta)/options->alpha);
+		shared.score0=matchEloToScore(options->elo0);
+		shared.score1=matchEloToScore(options->elo1);
+
+		// Play pairs of games in parallel.
+		shared.verdict=NULL;
+		shared.startTime=timeGet();
+		Thread *workers[MatchThreadsMax];
+		for(unsigned int i=0;i<workCount;++i) {
+			workers[i]=threadNew();
+			if (workers[i]==NULL)
+				matchWorker(&work[i]);
+			else
+				threadRun(workers[i], &matchWorker, &work[i]);
+		}
+		for(unsigned int i=0;i<workCount;++i)
+			threadFree(workers[i]); // Waits for the thread to finish.
+
+		uciWrite("SPRT [%.1f, %.1f]: %s\n", options->elo0, options->elo1, (shared.verdict!=NULL ? shared.verdict : "inconclusive"));
+	}
+
+	// Clean up.
+	for(unsigned int i=0;i<workCount;++i) {
+		searchFree(work[i].searches[0]);
+		searchFree(work[i].searches[1]);
+		posFree(work[i].pos);
+	}
+	lockFree(shared.lock);
+	matchOpeningsFree(shared.openings, shared.openingCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+bool matchSetParse(MatchSet *set, const char *string) {
+	set->count=0;
+
+	char buffer[MatchParamsMax*2*MatchParamLenMax];
+	if (strlen(string)>=sizeof(buffer)) {
+		uciWrite("Error: Option list '%s' too long.\n", string);
+		return false;
+	}
+	strcpy(buffer, string);
+
+	char *savePtr, *part;
+	for(part=strtok_r(buffer, ",", &savePtr);part!=NULL;part=strtok_r(NULL, ",", &savePtr)) {
+		char *value=strchr(part, '=');
+		if (value==NULL || value==part || set->count>=MatchParamsMax || value-part>=MatchParamLenMax || strlen(value+1)>=MatchParamLenMax) {
+			uciWrite("Error: Bad option '%s' (expected name=value).\n", part);
+			return false;
+		}
+		*value++='\0';
+		strcpy(set->names[set->count], part);
+		strcpy(set->values[set->count], value);
+		++set->count;
+	}
+
+	return true;
+}
+
+bool matchSetApply(const MatchSet *set, Search *search) {
+	for(unsigned int i=0;i<set->count;++i)
+		if (!searchSetOption(search, set->names[i], set->values[i])) {
+			uciWrite("Error: Option '%s' cannot be set per game.\n", set->names[i]);
+			return false;
+		}
+	return true;
+}
+
+bool matchSetHasName(const MatchSet *set, const char *name) {
+	for(unsigned int i=0;i<set->count;++i)
+		if (utilStrEqual(set->names[i], name))
+			return true;
+	return false;
+}
+
+char **matchOpeningsLoad(const char *path, size_t *count) {
+	FILE *file=fopen(path, "r");
+	if (file==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", path);
+		return NULL;
+	}
+	Pos *pos=posNew(NULL);
+	if (pos==NULL) {
+		uciWrite("Error: Could not allocate position.\n");
+		fclose(file);
+		return NULL;
+	}
+
+	char **openings=NULL;
+	*count=0;
+	char *line=NULL;
+	size_t lineSize=0, skipped=0;
+	bool error=false;
+	while(getline(&line, &lineSize, file)>=0) {
+		// Skip blank lines, comments and anything we cannot parse.
+		char *c=line+strspn(line, " \t\r\n");
+		if (*c=='\0' || *c=='#')
+			continue;
+		Epd epd;
+		if (!epdParse(c, pos, &epd) || !posLegalMoveExists(pos, MoveTypeAny)) {
+			++skipped;
+			continue;
+		}
+
+		char **newOpenings=realloc(openings, (*count+1)*sizeof(char *));
+		char *opening=malloc(strlen(c)+1);
+		if (newOpenings!=NULL)
+			openings=newOpenings;
+		if (newOpenings==NULL || opening==NULL) {
+			free(opening);
+			error=true;
+			break;
+		}
+		strcpy(opening, c);
+		openings[(*count)++]=opening;
+	}
+	free(line);
+	fclose(file);
+	posFree(pos);
+
+	if (error) {
+		uciWrite("Error: Could not allocate memory.\n");
+		matchOpeningsFree(openings, *count);
+		return NULL;
+	}
+	if (skipped>0)
+		uciWrite("Warning: Skipped %zu unusable lines in '%s'.\n", skipped, path);
+	if (openings==NULL)
+		openings=malloc(1); // So an empty file is distinguishable from failure.
+	return openings;
+}
+
+void matchOpeningsFree(char **openings, size_t count) {
+	if (openings==NULL)
+		return;
+	for(size_t i=0;i<count;++i)
+		free(openings[i]);
+	free(openings);
+}
+
+void matchRandomOpening(Pos *pos, Search *search, const MatchOptions *options, uint64_t *randState) {
+	while(1) {
+		posSetToFEN(pos, NULL);
+		unsigned int ply;
+		for(ply=0;ply<MatchRandomPlies;++ply) {
+			Moves moves;
+			movesInitBulk(&moves, pos);
+			unsigned int count=movesGetCount(&moves);
+			if (count==0)
+				break;
+			unsigned int choice=utilRand64R(randState)%count;
+			Move move;
+			while((move=movesNext(&moves))!=MoveInvalid && choice>0)
+				--choice;
+			posMakeMove(pos, move);
+		}
+		if (ply<MatchRandomPlies || !posLegalMoveExists(pos, MoveTypeAny) || posIsDraw(pos))
+			continue;
+
+		searchClear(search);
+		MatchSearch result;
+		matchSearch(search, pos, options, &result);
+		if (abs(result.score)<=MatchOpeningScoreMax)
+			return;
+	}
+}
+
+void matchWorker(void *userData) {
+	MatchWork *work=(MatchWork *)userData;
+	MatchShared *shared=work->shared;
+	const MatchOptions *options=shared->options;
+
+	while(1) {
+		// Claim next pair (unless finished).
+		lockWait(shared->lock);
+		unsigned int pair=shared->nextPair;
+		bool finished=(shared->verdict!=NULL || 2*pair>=options->games);
+		if (!finished)
+			++shared->nextPair;
+		lockPost(shared->lock);
+		if (finished)
+			break;
+
+		// Choose opening (seeding random ones from the pair number, so that they do not depend on the number of
+		// threads).
+		char fen[128];
+		if (shared->openings!=NULL) {
+			Epd epd;
+			epdParse(shared->openings[pair%shared->openingCount], work->pos, &epd);
+		} else {
+			uint64_t randState=(options->seed^(pair*0x9E3779B97F4A7C15llu))|1;
+			matchRandomOpening(work->pos, work->searches[0], options, &randState);
+		}
+		posGetFEN(work->pos, fen);
+
+		// Play both games of the pair, with A as white then as black.
+		unsigned int pairResults[3]={0, 0, 0};
+		for(unsigned int aColour=0;aColour<2;++aColour) {
+			posSetToFEN(work->pos, fen);
+			Search *a=work->searches[0], *b=work->searches[1];
+			unsigned int result=(aColour==0 ? matchGame(work->pos, a, b, options) : 2-matchGame(work->pos, b, a, options));
+			++pairResults[result];
+		}
+
+		matchWorkerResult(shared, pairResults);
+	}
+}
+
+void matchWorkerResult(MatchShared *shared, const unsigned int pairResults[3]) {
+	lockWait(shared->lock);
+
+	// Pairs finishing after the SPRT has stopped the match are not counted (so the final report is the one which
+	// triggered it).
+	if (shared->verdict!=NULL) {
+		lockPost(shared->lock);
+		return;
+	}
+	for(unsigned int i=0;i<3;++i)
+		shared->results[i]+=pairResults[i];
+	const unsigned int *results=shared->results;
+
+	// Estimate Elo difference and its 95% confidence interval, then the log-likelihood ratio for the SPRT (using the
+	// usual normal approximation over game results).
+	double games=results[0]+results[1]+results[2];
+	double score=(results[2]+0.5*results[1])/games;
+	double variance=(results[2]*(1.0-score)*(1.0-score)+results[1]*(0.5-score)*(0.5-score)+results[0]*score*score)/games;
+	double margin=1.96*sqrt(variance/games);
+	double elo=matchScoreToElo(score);
+	double eloMargin=(matchScoreToElo(score+margin)-matchScoreToElo(score-margin))/2.0;
+	double llr=(variance>0.0 ? games*(shared->score1-shared->score0)*(2.0*score-shared->score0-shared->score1)/(2.0*variance) : 0.0);
+
+	TimeMs time=timeGet()-shared->startTime;
+	uciWrite("games %u +%u =%u -%u score %.1f%% elo %.1f +/- %.1f llr %.2f (%.2f, %.2f) time %llus\n", results[0]+results[1]+results[2],
+	         results[2], results[1], results[0], 100.0*score, elo, eloMargin, llr, shared->lowerBound, shared->upperBound, time/1000);
+
+	if (llr>=shared->upperBound)
+		shared->verdict="H1 accepted";
+	else if (llr<=shared->lowerBound)
+		shared->verdict="H0 accepted";
+
+	lockPost(shared->lock);
+}
+
+unsigned int matchGame(Pos *pos, Search *white, Search *black, const MatchOptions *options) {
+	// Each side searches with its own context, from a clean state at the start of each game.
+	searchClear(white);
+	searchClear(black);
+
+	unsigned int winPlies=0, lossPlies=0;
+	for(unsigned int ply=0;;++ply) {
+		// Game over?
+		if (!posLegalMoveExists(pos, MoveTypeAny))
+			return (posIsSTMInCheck(pos) ? (posGetSTM(pos)==ColourWhite ? 0 : 2) : 1);
+		if (posIsDraw(pos) || ply>=MatchMaxPlies)
+			return 1;
+
+		MatchSearch search;
+		matchSearch((posGetSTM(pos)==ColourWhite ? white : black), pos, options, &search);
+
+		// Adjudicate long-lasting large scores as wins (counting consecutive plies from white's point of view).
+		Score whiteScore=(posGetSTM(pos)==ColourWhite ? search.score : -search.score);
+		winPlies=(whiteScore>=MatchAdjudicateScore ? winPlies+1 : 0);
+		lossPlies=(whiteScore<=-MatchAdjudicateScore ? lossPlies+1 : 0);
+		if (winPlies>=MatchAdjudicatePlies)
+			return 2;
+		if (lossPlies>=MatchAdjudicatePlies)
+			return 0;
+
+		posMakeMove(pos, search.bestMove);
+	}
+}
+
+void matchSearch(Search *search, const Pos *pos, const MatchOptions *options, MatchSearch *result) {
+	result->score=0;
+	result->bestMove=MoveInvalid;
+
+	SearchLimit limit;
+	searchLimitInit(&limit, timeGet());
+	if (options->moveTime!=TimeMsInvalid)
+		searchLimitSetMoveTime(&limit, options->moveTime);
+	if (options->nodes>0)
+		searchLimitSetNodes(&limit, options->nodes);
+	searchRun(search, pos, &limit, &matchSearchDepthCallback, result);
+
+	// Limit too small to complete an iteration?
+	if (!moveIsValid(result->bestMove) || !posCanMakeMove(pos, result->bestMove)) {
+		result->score=evaluate(searchGetEval(search), pos);
+		result->bestMove=posGenLegalMove(pos, MoveTypeAny);
+	}
+}
+
+void matchSearchDepthCallback(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time) {
+	MatchSearch *result=(MatchSearch *)userData;
+	if (pvLength==0)
+		return;
+	result->score=score;
+	result->bestMove=pv[0];
+}
+
+double matchEloToScore(double elo) {
+	return 1.0/(1.0+pow(10.0, -elo/400.0));
+}
+
+double matchScoreToElo(double score) {
+	score=utilMax(1e-6, utilMin(score, 1.0-1e-6));
+	return -400.0*log10(1.0/score-1.0);
+}
@@ -0,0 +1,27 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <stdint.h>
+
+#include "time.h"
+
+typedef struct {
+	unsigned int games; // Maximum number of games, played in pairs from the same opening with colours reversed.
+	TimeMs moveTime; // Per move limit, TimeMsInvalid for none.
+	unsigned long long int nodes; // Per move limit, 0 for none.
+	const char *openingsPath; // EPD file of start positions used in turn, or NULL for random openings.
+	double elo0, elo1, alpha, beta; // SPRT hypotheses (H0: elo=elo0, H1: elo=elo1) and error rates.
+	uint64_t seed; // For random openings.
+	unsigned int threads; // Pairs of games played in parallel.
+} MatchOptions;
+
+void matchOptionsInit(MatchOptions *options);
+
+// Plays games between two sets of UCI option values (each a comma separated list of name=value pairs naming the same
+// options, e.g. "LmrReduction=1" against "LmrReduction=2"), reporting the score and Elo difference of set A against
+// set B after each pair of games. Stops early once the SPRT accepts either hypothesis.
+// Each thread plays its own pairs, with a search context per set so that only options supported by searchSetOption()
+// (e.g. Hash, PawnHash, MatHash and in tuning builds the evaluation and search values) can be used.
+void match(const char *setA, const char *setB, const MatchOptions *options);
+
+#endif
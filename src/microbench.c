@@ -0,0 +1,667 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+#include "attacks.h"
+#include "bb.h"
+#include "bitbase.h"
+#include "eval.h"
+#include "fen.h"
+#include "fill.h"
+#include "magicmoves.h"
+#include "main.h"
+#include "moves.h"
+#include "pos.h"
+#include "search.h"
+#include "see.h"
+#include "tt.h"
+#include "uci.h"
+#include "util.h"
+
+// Microbenchmarks for individual engine kernels, built as a separate binary
+// with 'make microbench'. Each kernel is run over a fixed set of positions
+// (reached by random play from a few typical starting points) and timed in
+// a number of independent samples, giving a mean time per operation along
+// with a 95% confidence interval, and where hardware counters are available
+// the number of L1 data and last level cache read misses per operation.
+
+#define MicrobenchPositionsMax 512
+#define MicrobenchPlayouts 24 // Per start position.
+#define MicrobenchPlayoutPlies 80
+#define MicrobenchKPvKMax 512
+#define MicrobenchSamples 20
+#define MicrobenchT95 2.093 // Student's t for a two sided 95% interval with MicrobenchSamples-1 degrees of freedom.
+#define MicrobenchSampleMs 50 // Approximate target duration of each sample.
+#define MicrobenchSearchPositions 32 // Spread evenly over the collected positions.
+#define MicrobenchSearchDepth 5
+
+typedef struct {
+	Pos *pos;
+	char fen[128];
+	Move moves[MovesMax], captures[MovesMax];
+	unsigned moveCount, captureCount;
+} MicrobenchPosition;
+
+typedef unsigned long long int (MicrobenchKernel)(unsigned index); // Runs kernel on a single position, returning number of operations performed.
+
+typedef struct {
+	const char *name;
+	MicrobenchKernel *kernel;
+	unsigned count; // Number of positions to pass as index.
+} MicrobenchTest;
+
+const char *microbenchStartFens[]={
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"r1bq1rk1/pppnnppp/4p3/3pP3/1b1P4/2NB3N/PPP2PPP/R1BQK2R w KQ - 3 7",
+	"rnbqkb1r/pp1p1ppp/2p5/4P3/2B5/8/PPP1NnPP/RNBQK2R w KQkq - 0 6",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"3B4/1r2p3/r2p1p2/bkp1P1p1/1p1P1PPp/p1P1K2P/PPB5/8 w - - 0 1",
+};
+#define MicrobenchStartFensNB (sizeof(microbenchStartFens)/sizeof(microbenchStartFens[0]))
+
+MicrobenchPosition *microbenchPositions=NULL;
+unsigned microbenchPositionCount=0;
+Pos *microbenchKPvK[MicrobenchKPvKMax];
+unsigned microbenchKPvKCount=0;
+
+volatile uint64_t microbenchSink=0; // Kernel results are accumulated here so that they cannot be optimised away.
+
+#define MicrobenchCountersNB 2
+const char *microbenchCounterNames[MicrobenchCountersNB]={"L1d", "LL"};
+int microbenchCounters[MicrobenchCountersNB]={-1, -1}; // File descriptors of the cache read miss counters (-1 if unavailable).
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+void microbenchPinCpu(int cpu);
+void microbenchCollectPositions(void);
+void microbenchAddPosition(const Pos *pos);
+void microbenchCollectKPvK(void);
+void microbenchCheck(void); // Checks kernels which are compared against each other agree on every position.
+
+void microbenchCountersOpen(void);
+void microbenchCountersClose(void);
+int microbenchCounterOpen(unsigned cache); // Returns file descriptor of a (disabled) hardware cache read miss counter, or -1 if unavailable.
+void microbenchCountersStart(void); // Resets and enables counters.
+void microbenchCountersStop(unsigned long long int *misses); // Disables counters, setting misses[i] for each (or ULLONG_MAX if unavailable).
+
+unsigned long long int microbenchNs(void);
+unsigned long long int microbenchCycles(void); // Time stamp counter (0 if unavailable).
+
+void microbenchRun(const MicrobenchTest *test);
+
+unsigned long long int microbenchKernelGenLegal(unsigned index);
+unsigned long long int microbenchKernelMakeUndo(unsigned index);
+unsigned long long int microbenchKernelCanMakeMove(unsigned index);
+unsigned long long int microbenchKernelEvaluate(unsigned index);
+unsigned long long int microbenchKernelSee(unsigned index);
+unsigned long long int microbenchKernelSeeGE(unsigned index);
+unsigned long long int microbenchKernelTTWrite(unsigned index);
+unsigned long long int microbenchKernelTTRead(unsigned index);
+unsigned long long int microbenchKernelBitbase(unsigned index);
+unsigned long long int microbenchKernelAttacksBishop(unsigned index);
+unsigned long long int microbenchKernelAttacksRook(unsigned index);
+unsigned long long int microbenchKernelMagicBishop(unsigned index);
+unsigned long long int microbenchKernelMagicRook(unsigned index);
+unsigned long long int microbenchKernelFillAttacks(unsigned index);
+unsigned long long int microbenchKernelFillAttacksRef(unsigned index);
+unsigned long long int microbenchKernelFillReach(unsigned index);
+unsigned long long int microbenchKernelFillReachRef(unsigned index);
+unsigned long long int microbenchKernelFillKnightMob(unsigned index);
+unsigned long long int microbenchKernelFillKnightMobRef(unsigned index);
+unsigned long long int microbenchKernelSearch(unsigned index);
+unsigned long long int microbenchKernelFenRead(unsigned index);
+
+BB microbenchAttacksPerSquare(PieceType type, BB set, BB occ); // Reference version of fillAttacksPieceType().
+BB microbenchReachPerSquare(PieceType type, BB init, BB occ, BB target); // Reference version of fillReach().
+unsigned microbenchKnightMobilityPerSquare(BB set, BB allowed); // Reference version of fillKnightMobility().
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv) {
+	// Usage: microbench [cpu] [kernel...]
+	int cpu=(argc>1 ? atoi(argv[1]) : 0);
+	microbenchPinCpu(cpu);
+
+	// Init as usual.
+	uciInit();
+	bbInit();
+	attacksInit();
+	bitbaseInit();
+	posInit();
+	evalInit();
+	searchInit();
+
+	// Collect positions.
+	microbenchCollectPositions();
+	microbenchCollectKPvK();
+	microbenchCheck();
+	microbenchCountersOpen();
+	printf("positions %u, kpvk positions %u, slider attacks %s (%zukb), fill kernels %s, %i samples\n", microbenchPositionCount, microbenchKPvKCount,
+	       (attacksHasPext() ? "pext" : "magic"), attacksSliderTableSize()/1024, (fillHasSIMD() ? "avx2" : "scalar"), MicrobenchSamples);
+	printf("%-16s %12s %10s %10s %10s %10s %10s\n", "kernel", "ops/sample", "ns/op", "+-95%", "cycles/op", "L1d miss", "LL miss");
+
+	const MicrobenchTest tests[]={
+		{"genlegal", &microbenchKernelGenLegal, microbenchPositionCount},
+		{"makeundo", &microbenchKernelMakeUndo, microbenchPositionCount},
+		{"canmakemove", &microbenchKernelCanMakeMove, microbenchPositionCount},
+		{"evaluate", &microbenchKernelEvaluate, microbenchPositionCount},
+		{"see", &microbenchKernelSee, microbenchPositionCount},
+		{"seege", &microbenchKernelSeeGE, microbenchPositionCount},
+		{"ttwrite", &microbenchKernelTTWrite, microbenchPositionCount},
+		{"ttread", &microbenchKernelTTRead, microbenchPositionCount},
+		{"bitbaseprobe", &microbenchKernelBitbase, microbenchKPvKCount},
+		{"attacksbishop", &microbenchKernelAttacksBishop, microbenchPositionCount},
+		{"attacksrook", &microbenchKernelAttacksRook, microbenchPositionCount},
+		{"magicbishop", &microbenchKernelMagicBishop, microbenchPositionCount},
+		{"magicrook", &microbenchKernelMagicRook, microbenchPositionCount},
+		{"fillattacks", &microbenchKernelFillAttacks, microbenchPositionCount},
+		{"fillattacksref", &microbenchKernelFillAttacksRef, microbenchPositionCount},
+		{"fillreach", &microbenchKernelFillReach, microbenchPositionCount},
+		{"fillreachref", &microbenchKernelFillReachRef, microbenchPositionCount},
+		{"fillknightmob", &microbenchKernelFillKnightMob, microbenchPositionCount},
+		{"fillknightmobref", &microbenchKernelFillKnightMobRef, microbenchPositionCount},
+		{"search", &microbenchKernelSearch, utilMin(microbenchPositionCount, (unsigned)MicrobenchSearchPositions)},
+		{"fenread", &microbenchKernelFenRead, microbenchPositionCount},
+	};
+	for(unsigned i=0; i<sizeof(tests)/sizeof(tests[0]); ++i) {
+		// If any kernels are named only run those.
+		bool run=(argc<=2);
+		for(int j=2; j<argc; ++j)
+			run|=utilStrEqual(argv[j], tests[i].name);
+		if (run)
+			microbenchRun(&tests[i]);
+	}
+
+	// Clean up.
+	microbenchCountersClose();
+	for(unsigned i=0; i<microbenchPositionCount; ++i)
+		posFree(microbenchPositions[i].pos);
+	free(microbenchPositions);
+	for(unsigned i=0; i<microbenchKPvKCount; ++i)
+		posFree(microbenchKPvK[i]);
+	searchQuit();
+	bitbaseQuit();
+
+	return EXIT_SUCCESS;
+}
+
+void mainFatalError(const char *format, ...) {
+	va_list ap;
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+	exit(EXIT_FAILURE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void microbenchPinCpu(int cpu) {
+#	ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set)!=0)
+		printf("Warning: Could not pin to cpu %i.\n", cpu);
+#	else
+	printf("Warning: Cpu pinning unsupported.\n");
+#	endif
+}
+
+void microbenchCollectPositions(void) {
+	microbenchPositions=malloc(MicrobenchPositionsMax*sizeof(MicrobenchPosition));
+	if (microbenchPositions==NULL)
+		mainFatalError("Error: Could not allocate positions.\n");
+
+	// Random play from each start position (seeded, so the set is the same every run).
+	utilRandSeed(1);
+	Pos *pos=posNew(NULL);
+	if (pos==NULL)
+		mainFatalError("Error: Could not allocate position.\n");
+	for(unsigned i=0; i<MicrobenchStartFensNB; ++i)
+		for(unsigned playout=0; playout<MicrobenchPlayouts; ++playout) {
+			if (!posSetToFEN(pos, microbenchStartFens[i]))
+				mainFatalError("Error: Bad start FEN '%s'.\n", microbenchStartFens[i]);
+			for(unsigned ply=0; ply<MicrobenchPlayoutPlies; ++ply) {
+				// Game over?
+				Moves moves;
+				movesInitBulk(&moves, pos);
+				unsigned count=movesGetCount(&moves);
+				if (count==0 || posIsDraw(pos))
+					break;
+
+				// Sample every few plies.
+				if (ply%8==playout%8)
+					microbenchAddPosition(pos);
+
+				// Make random move.
+				unsigned choice=utilRand64()%count;
+				Move move;
+				while((move=movesNext(&moves))!=MoveInvalid && choice>0)
+					--choice;
+				posMakeMove(pos, move);
+			}
+		}
+	posFree(pos);
+}
+
+void microbenchAddPosition(const Pos *pos) {
+	if (microbenchPositionCount>=MicrobenchPositionsMax)
+		return;
+
+	MicrobenchPosition *entry=&microbenchPositions[microbenchPositionCount];
+	posGetFEN(pos, entry->fen);
+	if ((entry->pos=posNew(entry->fen))==NULL)
+		return;
+
+	// Store legal moves and captures.
+	entry->moveCount=entry->captureCount=0;
+	Moves moves;
+	movesInitBulk(&moves, entry->pos);
+	Move move;
+	while((move=movesNext(&moves))!=MoveInvalid) {
+		entry->moves[entry->moveCount++]=move;
+		if (posGetPieceOnSq(entry->pos, posMoveGetToSqTrue(entry->pos, move))!=PieceNone && !posMoveIsCastling(entry->pos, move))
+			entry->captures[entry->captureCount++]=move;
+	}
+
+	++microbenchPositionCount;
+}
+
+void microbenchCollectKPvK(void) {
+	while(microbenchKPvKCount<MicrobenchKPvKMax) {
+		// Random placement.
+		Fen fen;
+		for(Sq sq=0; sq<SqNB; ++sq)
+			fen.array[sq]=PieceNone;
+		Sq wKingSq=utilRand64()%SqNB, bKingSq=utilRand64()%SqNB, pawnSq=sqMake(utilRand64()%FileNB, Rank2+utilRand64()%6);
+		if (wKingSq==bKingSq || wKingSq==pawnSq || bKingSq==pawnSq || (attacksKing(wKingSq) & bbSq(bKingSq)))
+			continue;
+		fen.array[wKingSq]=PieceWKing;
+		fen.array[bKingSq]=PieceBKing;
+		fen.array[pawnSq]=PieceWPawn;
+		fen.stm=utilRand64()%ColourNB;
+		fen.castRights=CastRightsNone;
+		fen.epSq=SqInvalid;
+		fen.halfMoveNumber=0;
+		fen.fullMoveNumber=1;
+
+		// Skip if the side not to move is in check.
+		char string[128];
+		fenWrite(&fen, string);
+		Pos *pos=posNew(string);
+		if (pos==NULL)
+			continue;
+		if (posIsSqAttackedByColour(pos, posGetKingSq(pos, colourSwap(posGetSTM(pos))), posGetSTM(pos))) {
+			posFree(pos);
+			continue;
+		}
+
+		microbenchKPvK[microbenchKPvKCount++]=pos;
+	}
+}
+
+void microbenchCheck(void) {
+	for(unsigned i=0; i<microbenchPositionCount; ++i) {
+		const Pos *pos=microbenchPositions[i].pos;
+		BB occ=posGetBBAll(pos), pawns=(posGetBBPiece(pos, PieceWPawn) | posGetBBPiece(pos, PieceBPawn));
+		BB king=posGetBBPiece(pos, pieceMake(PieceTypeKing, colourSwap(posGetSTM(pos))));
+
+		for(Sq sq=0; sq<SqNB; ++sq)
+			if (attacksBishop(sq, occ)!=Bmagic(sq, occ) || attacksRook(sq, occ)!=Rmagic(sq, occ))
+				mainFatalError("Error: Slider attack backends differ for '%s'.\n", microbenchPositions[i].fen);
+
+		for(PieceType type=PieceTypeKnight; type<=PieceTypeKing; ++type) {
+			BB set=posGetBBPiece(pos, pieceMake(type, posGetSTM(pos)));
+			if (fillAttacksPieceType(type, set, occ)!=microbenchAttacksPerSquare(type, set, occ) ||
+			    ((fillReach(type, set, pawns, king) & king)!=BBNone)!=((microbenchReachPerSquare(type, set, pawns, king) & king)!=BBNone) ||
+			    fillKnightMobility(set, ~occ)!=microbenchKnightMobilityPerSquare(set, ~occ))
+				mainFatalError("Error: Set-wise and per-square fills differ for '%s'.\n", microbenchPositions[i].fen);
+		}
+	}
+}
+
+void microbenchCountersOpen(void) {
+#	ifdef __linux__
+	const unsigned caches[MicrobenchCountersNB]={PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_LL};
+	for(unsigned i=0; i<MicrobenchCountersNB; ++i)
+		microbenchCounters[i]=microbenchCounterOpen(caches[i]);
+#	endif
+}
+
+void microbenchCountersClose(void) {
+#	ifdef __linux__
+	for(unsigned i=0; i<MicrobenchCountersNB; ++i)
+		if (microbenchCounters[i]>=0)
+			close(microbenchCounters[i]);
+#	endif
+}
+
+int microbenchCounterOpen(unsigned cache) {
+#	ifdef __linux__
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size=sizeof(attr);
+	attr.type=PERF_TYPE_HW_CACHE;
+	attr.config=(cache | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16));
+	attr.disabled=1;
+	attr.exclude_kernel=1;
+	attr.exclude_hv=1;
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#	else
+	return -1;
+#	endif
+}
+
+void microbenchCountersStart(void) {
+#	ifdef __linux__
+	for(unsigned i=0; i<MicrobenchCountersNB; ++i)
+		if (microbenchCounters[i]>=0) {
+			ioctl(microbenchCounters[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(microbenchCounters[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+#	endif
+}
+
+void microbenchCountersStop(unsigned long long int *misses) {
+	for(unsigned i=0; i<MicrobenchCountersNB; ++i) {
+		misses[i]=ULLONG_MAX;
+#		ifdef __linux__
+		if (microbenchCounters[i]<0)
+			continue;
+		ioctl(microbenchCounters[i], PERF_EVENT_IOC_DISABLE, 0);
+		unsigned long long int value;
+		if (read(microbenchCounters[i], &value, sizeof(value))==sizeof(value))
+			misses[i]=value;
+#		endif
+	}
+}
+
+unsigned long long int microbenchNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000llu+ts.tv_nsec;
+}
+
+unsigned long long int microbenchCycles(void) {
+#	ifdef __x86_64__
+	return __rdtsc();
+#	else
+	return 0;
+#	endif
+}
+
+void microbenchRun(const MicrobenchTest *test) {
+	if (test->count==0)
+		return;
+
+	// Warm up (caches, branch predictors, hash tables) and calibrate number of passes per sample.
+	unsigned long long int t=microbenchNs();
+	for(unsigned i=0; i<test->count; ++i)
+		test->kernel(i);
+	t=microbenchNs()-t;
+	unsigned passes=utilMax(1llu, (MicrobenchSampleMs*1000000llu)/(t+1));
+
+	// Take samples (counting cache misses over all of them).
+	double nsPerOp[MicrobenchSamples], cyclesPerOp=0.0;
+	unsigned long long int ops=0, totalOps=0, misses[MicrobenchCountersNB];
+	microbenchCountersStart();
+	for(unsigned sample=0; sample<MicrobenchSamples; ++sample) {
+		ops=0;
+		unsigned long long int cycles=microbenchCycles();
+		t=microbenchNs();
+		for(unsigned pass=0; pass<passes; ++pass)
+			for(unsigned i=0; i<test->count; ++i)
+				ops+=test->kernel(i);
+		t=microbenchNs()-t;
+		cycles=microbenchCycles()-cycles;
+		nsPerOp[sample]=((double)t)/utilMax(ops, 1llu);
+		cyclesPerOp+=((double)cycles)/utilMax(ops, 1llu);
+		totalOps+=ops;
+	}
+	microbenchCountersStop(misses);
+	cyclesPerOp/=MicrobenchSamples;
+
+	// Mean and confidence interval.
+	double mean=0.0, sumSq=0.0;
+	for(unsigned sample=0; sample<MicrobenchSamples; ++sample)
+		mean+=nsPerOp[sample];
+	mean/=MicrobenchSamples;
+	for(unsigned sample=0; sample<MicrobenchSamples; ++sample)
+		sumSq+=(nsPerOp[sample]-mean)*(nsPerOp[sample]-mean);
+	double interval=MicrobenchT95*sqrt(sumSq/(MicrobenchSamples-1))/sqrt(MicrobenchSamples);
+
+	printf("%-16s %12llu %10.2f %10.2f %10.1f", test->name, ops, mean, interval, cyclesPerOp);
+	for(unsigned i=0; i<MicrobenchCountersNB; ++i)
+		if (misses[i]!=ULLONG_MAX)
+			printf(" %10.3f", ((double)misses[i])/utilMax(totalOps, 1llu));
+		else
+			printf(" %10s", "-");
+	printf("\n");
+}
+
+unsigned long long int microbenchKernelGenLegal(unsigned index) {
+	Moves moves;
+	movesInitBulk(&moves, microbenchPositions[index].pos);
+	microbenchSink+=movesGetCount(&moves);
+	return 1;
+}
+
+unsigned long long int microbenchKernelMakeUndo(unsigned index) {
+	MicrobenchPosition *entry=&microbenchPositions[index];
+	for(unsigned i=0; i<entry->moveCount; ++i) {
+		posMakeMoveUnchecked(entry->pos, entry->moves[i]);
+		microbenchSink+=posGetKey(entry->pos);
+		posUndoMove(entry->pos);
+	}
+	return entry->moveCount;
+}
+
+unsigned long long int microbenchKernelCanMakeMove(unsigned index) {
+	MicrobenchPosition *entry=&microbenchPositions[index];
+	for(unsigned i=0; i<entry->moveCount; ++i)
+		microbenchSink+=posCanMakeMove(entry->pos, entry->moves[i]);
+	return entry->moveCount;
+}
+
+unsigned long long int microbenchKernelEvaluate(unsigned index) {
+	microbenchSink+=evaluate(searchGetEval(searchGetMain()), microbenchPositions[index].pos);
+	return 1;
+}
+
+unsigned long long int microbenchKernelSee(unsigned index) {
+	MicrobenchPosition *entry=&microbenchPositions[index];
+	for(unsigned i=0; i<entry->captureCount; ++i) {
+		Move move=entry->captures[i];
+		microbenchSink+=see(entry->pos, moveGetFromSq(move), posMoveGetToSqTrue(entry->pos, move));
+	}
+	return entry->captureCount;
+}
+
+unsigned long long int microbenchKernelSeeGE(unsigned index) {
+	MicrobenchPosition *entry=&microbenchPositions[index];
+	for(unsigned i=0; i<entry->captureCount; ++i) {
+		Move move=entry->captures[i];
+		microbenchSink+=seeGE(entry->pos, moveGetFromSq(move), posMoveGetToSqTrue(entry->pos, move), 0);
+	}
+	return entry->captureCount;
+}
+
+unsigned long long int microbenchKernelTTWrite(unsigned index) {
+	MicrobenchPosition *entry=&microbenchPositions[index];
+	if (entry->moveCount==0)
+		return 0;
+	ttWrite(searchGetTT(searchGetMain()), entry->pos, 0, 1+index%16, entry->moves[0], 0, BoundExact);
+	return 1;
+}
+
+unsigned long long int microbenchKernelTTRead(unsigned index) {
+	Move move;
+	Depth depth;
+	Score score;
+	Bound bound;
+	microbenchSink+=ttRead(searchGetTT(searchGetMain()), microbenchPositions[index].pos, 0, &move, &depth, &score, &bound);
+	return 1;
+}
+
+unsigned long long int microbenchKernelBitbase(unsigned index) {
+	microbenchSink+=bitbaseProbe(microbenchKPvK[index]);
+	return 1;
+}
+
+unsigned long long int microbenchKernelAttacksBishop(unsigned index) {
+	BB occ=posGetBBAll(microbenchPositions[index].pos), sum=BBNone;
+	for(Sq sq=0; sq<SqNB; ++sq)
+		sum^=attacksBishop(sq, occ);
+	microbenchSink+=sum;
+	return SqNB;
+}
+
+unsigned long long int microbenchKernelAttacksRook(unsigned index) {
+	BB occ=posGetBBAll(microbenchPositions[index].pos), sum=BBNone;
+	for(Sq sq=0; sq<SqNB; ++sq)
+		sum^=attacksRook(sq, occ);
+	microbenchSink+=sum;
+	return SqNB;
+}
+
+unsigned long long int microbenchKernelMagicBishop(unsigned index) {
+	BB occ=posGetBBAll(microbenchPositions[index].pos), sum=BBNone;
+	for(Sq sq=0; sq<SqNB; ++sq)
+		sum^=Bmagic(sq, occ);
+	microbenchSink+=sum;
+	return SqNB;
+}
+
+unsigned long long int microbenchKernelMagicRook(unsigned index) {
+	BB occ=posGetBBAll(microbenchPositions[index].pos), sum=BBNone;
+	for(Sq sq=0; sq<SqNB; ++sq)
+		sum^=Rmagic(sq, occ);
+	microbenchSink+=sum;
+	return SqNB;
+}
+
+unsigned long long int microbenchKernelFillAttacks(unsigned index) {
+	const Pos *pos=microbenchPositions[index].pos;
+	BB occ=posGetBBAll(pos), sum=BBNone;
+	for(PieceType type=PieceTypeKnight; type<=PieceTypeKing; ++type)
+		sum^=fillAttacksPieceType(type, posGetBBPiece(pos, pieceMake(type, posGetSTM(pos))), occ);
+	microbenchSink+=sum;
+	return PieceTypeKing-PieceTypeKnight+1;
+}
+
+unsigned long long int microbenchKernelFillAttacksRef(unsigned index) {
+	const Pos *pos=microbenchPositions[index].pos;
+	BB occ=posGetBBAll(pos), sum=BBNone;
+	for(PieceType type=PieceTypeKnight; type<=PieceTypeKing; ++type)
+		sum^=microbenchAttacksPerSquare(type, posGetBBPiece(pos, pieceMake(type, posGetSTM(pos))), occ);
+	microbenchSink+=sum;
+	return PieceTypeKing-PieceTypeKnight+1;
+}
+
+unsigned long long int microbenchKernelFillReach(unsigned index) {
+	const Pos *pos=microbenchPositions[index].pos;
+	BB pawns=(posGetBBPiece(pos, PieceWPawn) | posGetBBPiece(pos, PieceBPawn)), sum=BBNone;
+	BB king=posGetBBPiece(pos, pieceMake(PieceTypeKing, colourSwap(posGetSTM(pos))));
+	for(PieceType type=PieceTypeKnight; type<=PieceTypeKing; ++type)
+		sum^=fillReach(type, posGetBBPiece(pos, pieceMake(type, posGetSTM(pos))), pawns, king);
+	microbenchSink+=sum;
+	return PieceTypeKing-PieceTypeKnight+1;
+}
+
+unsigned long long int microbenchKernelFillReachRef(unsigned index) {
+	const Pos *pos=microbenchPositions[index].pos;
+	BB pawns=(posGetBBPiece(pos, PieceWPawn) | posGetBBPiece(pos, PieceBPawn)), sum=BBNone;
+	BB king=posGetBBPiece(pos, pieceMake(PieceTypeKing, colourSwap(posGetSTM(pos))));
+	for(PieceType type=PieceTypeKnight; type<=PieceTypeKing; ++type)
+		sum^=microbenchReachPerSquare(type, posGetBBPiece(pos, pieceMake(type, posGetSTM(pos))), pawns, king);
+	microbenchSink+=sum;
+	return PieceTypeKing-PieceTypeKnight+1;
+}
+
+unsigned long long int microbenchKernelFillKnightMob(unsigned index) {
+	const Pos *pos=microbenchPositions[index].pos;
+	microbenchSink+=fillKnightMobility(posGetBBPiece(pos, pieceMake(PieceTypeKnight, posGetSTM(pos))), ~posGetBBAll(pos));
+	return 1;
+}
+
+unsigned long long int microbenchKernelFillKnightMobRef(unsigned index) {
+	const Pos *pos=microbenchPositions[index].pos;
+	microbenchSink+=microbenchKnightMobilityPerSquare(posGetBBPiece(pos, pieceMake(PieceTypeKnight, posGetSTM(pos))), ~posGetBBAll(pos));
+	return 1;
+}
+
+unsigned long long int microbenchKernelSearch(unsigned index) {
+	// Each search starts from cleared tables so that every sample does the same work (ops are nodes).
+	Search *search=searchGetMain();
+	searchClear(search);
+	SearchLimit limit;
+	searchLimitInit(&limit, timeGet());
+	searchLimitSetDepth(&limit, MicrobenchSearchDepth);
+	searchRun(search, microbenchPositions[(index*microbenchPositionCount)/MicrobenchSearchPositions].pos, &limit, NULL, NULL);
+	return searchGetNodeCount(search);
+}
+
+unsigned long long int microbenchKernelFenRead(unsigned index) {
+	Fen fen;
+	microbenchSink+=fenRead(&fen, microbenchPositions[index].fen);
+	return 1;
+}
+
+BB microbenchAttacksPerSquare(PieceType type, BB set, BB occ) {
+	BB attacks=BBNone;
+	while(set) {
+		Sq sq=bbScanReset(&set);
+		attacks|=attacksPieceType(type, sq, occ);
+	}
+	return attacks;
+}
+
+BB microbenchReachPerSquare(PieceType type, BB init, BB occ, BB target) {
+	BB fill=init;
+	BB done=occ;
+	BB todo=init;
+	while(todo!=BBNone) {
+		Sq sq=bbScanReset(&todo);
+		done|=bbSq(sq);
+		BB attacks=attacksPieceType(type, sq, occ);
+		if ((attacks & target)!=BBNone)
+			return attacks;
+		todo|=(attacks & ~done);
+		fill|=attacks;
+	}
+
+	return fill;
+}
+
+unsigned microbenchKnightMobilityPerSquare(BB set, BB allowed) {
+	unsigned mobility=0;
+	while(set) {
+		Sq sq=bbScanReset(&set);
+		mobility+=bbPopCount(attacksKnight(sq) & allowed);
+	}
+	return mobility;
+}
@@ -1,33 +1,61 @@
 #include <assert.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 #include "killers.h"
 #include "moves.h"
 #include "search.h"
+#include "see.h"
+
+const Move movesNoKillers[KillersPerPly]={0}; // All MoveInvalid (see move.c), used when no search is given.
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private prototypes.
 ////////////////////////////////////////////////////////////////////////////////
 
 void movesSort(ScoredMove *start, ScoredMove *end); // Descending order (best move first).
+ScoredMove movesPickBest(Moves *moves); // Moves the best remaining entry to the front of [next, end) then returns it (advancing next).
+ScoredMove *movesFindBest(ScoredMove *start, ScoredMove *end); // Returns ptr to greatest entry (start<end).
+
+bool movesIsLosingCapture(const Moves *moves, Move move); // According to SEE, promotions and en-passent captures are never considered losing.
 
 ////////////////////////////////////////////////////////////////////////////////
 // Public functions.
 ////////////////////////////////////////////////////////////////////////////////
 
-void movesInit(Moves *moves, const Pos *pos, Depth ply, MoveType type) {
+void movesInit(Moves *moves, const Pos *pos, const Search *search, Depth ply, MoveType type) {
 	assert(type==MoveTypeQuiet || type==MoveTypeCapture || type==MoveTypeAny);
 	moves->end=moves->next=moves->list;
 	moves->stage=MovesStageTT;
 	moves->ttMove=MoveInvalid;
 	moves->pos=pos;
-	moves->ply=ply;
+	moves->search=search;
+	moves->killers=(search!=NULL ? searchGetKillers(search, ply) : movesNoKillers);
 	moves->allowed=moves->needed=type;
+	moves->picksLeft=MovesPicksMax;
 	moves->next=moves->list;
+	moves->badEnd=moves->list;
+}
+
+void movesInitBulk(Moves *moves, const Pos *pos) {
+	moves->end=moves->next=moves->list;
+	moves->stage=MovesStageBulk;
+	moves->ttMove=MoveInvalid;
+	moves->pos=pos;
+	moves->search=NULL;
+	moves->killers=movesNoKillers;
+	moves->allowed=MoveTypeAny;
+	moves->needed=MoveTypeNone;
+	moves->badEnd=moves->list;
+	posGenLegalMoves(moves, MoveTypeAny);
 }
 
 void movesRewind(Moves *moves, Move ttMove) {
 	moves->stage=MovesStageTT;
 	moves->next=moves->list;
+	moves->badEnd=moves->list;
+	moves->picksLeft=MovesPicksMax;
 	moves->ttMove=((moveIsValid(ttMove) && (posMoveGetType(moves->pos, ttMove)&moves->allowed)) ? ttMove : MoveInvalid);
 }
 
@@ -37,8 +65,8 @@ Move movesNext(Moves *moves) {
 			// Update stage and next ptr ready for next call (at most one TT move).
 			moves->stage=MovesStageGenCaptures;
 
-			// Do we have a TT move?
-			if (moves->ttMove!=MoveInvalid)
+			// Do we have a (legal) TT move?
+			if (moves->ttMove!=MoveInvalid && posCanMakeMove(moves->pos, moves->ttMove))
 				return moves->ttMove;
 
 			// Fall through.
@@ -47,8 +75,8 @@ Move movesNext(Moves *moves) {
 			if (moves->needed & MoveTypeCapture) {
 				assert(moves->next==moves->list);
 				assert(moves->next==moves->end);
-				posGenPseudoMoves(moves, MoveTypeCapture);
-				movesSort(moves->next, moves->end);
+				posGenLegalMoves(moves, MoveTypeCapture);
+				moves->picksLeft=MovesPicksMax;
 				moves->needed&=~MoveTypeCapture;
 			}
 
@@ -57,9 +85,19 @@ Move movesNext(Moves *moves) {
 		case MovesStageCaptures:
 			// Return moves one at a time.
 			while (moves->next<moves->end) {
-				Move move=scoredMoveGetMove(*moves->next++);
-				if (move!=moves->ttMove) // Exclude TT move as this is searched earlier.
+				Move move=scoredMoveGetMove(movesPickBest(moves));
+				if (move==moves->ttMove) // Exclude TT move as this is searched earlier.
+					continue;
+
+				// SEE is only computed now the move has been reached (often a cutoff happens first).
+				if (!movesIsLosingCapture(moves, move))
 					return move;
+
+				// Losing capture - leave this until after the quiets. Swap rather than overwrite so
+				// that the list still holds every generated move (for movesRewind()).
+				ScoredMove temp=*moves->badEnd;
+				*moves->badEnd++=*(moves->next-1);
+				*(moves->next-1)=temp;
 			}
 
 			// Fall through.
@@ -68,7 +106,7 @@ Move movesNext(Moves *moves) {
 		case MovesStageKillers:
 			while(moves->killersIndex<KillersPerPly) {
 				// Check if any killers left.
-				Move move=killers[moves->ply][moves->killersIndex++];
+				Move move=moves->killers[moves->killersIndex++];
 				if (move==MoveInvalid)
 					break;
 
@@ -76,8 +114,8 @@ Move movesNext(Moves *moves) {
 				if (move==moves->ttMove)
 					continue;
 
-				// Not pseudo-legal in this position?
-				if (!posMoveIsPseudoLegal(moves->pos, move))
+				// Not legal in this position?
+				if (!posMoveIsPseudoLegal(moves->pos, move) || !posCanMakeMove(moves->pos, move))
 					continue;
 
 				return move;
@@ -88,8 +126,8 @@ Move movesNext(Moves *moves) {
 			// No captures left, do we need to generate any quiets?
 			if (moves->needed & MoveTypeQuiet) {
 				assert(moves->next==moves->end);
-				posGenPseudoMoves(moves, MoveTypeQuiet);
-				movesSort(moves->next, moves->end);
+				posGenLegalMoves(moves, MoveTypeQuiet);
+				moves->picksLeft=MovesPicksMax;
 				moves->needed&=~MoveTypeQuiet;
 			}
 
@@ -98,21 +136,35 @@ Move movesNext(Moves *moves) {
 		case MovesStageQuiets:
 			// Return moves one at a time.
 			while (moves->next<moves->end) {
-				Move move=scoredMoveGetMove(*moves->next++);
+				Move move=scoredMoveGetMove(movesPickBest(moves));
 				// Exclude TT and killer moves as these are searched earlier.
 				if (move==moves->ttMove)
 					continue;
 				int i;
 				for(i=0;i<KillersPerPly;++i)
-					if (move==killers[moves->ply][i])
+					if (move==moves->killers[i])
 						break;
 				if (i==KillersPerPly)
 					return move;
 			}
 
+			// Fall through.
+			moves->stage=MovesStageBadCaptures;
+			moves->next=moves->list;
+			moves->end=moves->badEnd;
+		case MovesStageBadCaptures:
+			// Return moves one at a time (already sorted, as they were deferred in the order they were picked).
+			if (moves->next<moves->end)
+				return scoredMoveGetMove(*moves->next++);
+
 			// No moves left
 			return MoveInvalid;
 		break;
+		case MovesStageBulk:
+			if (moves->next<moves->end)
+				return scoredMoveGetMove(*moves->next++);
+			return MoveInvalid;
+		break;
 	}
 
 	assert(false);
@@ -123,11 +175,20 @@ const Pos *movesGetPos(Moves *moves) {
 	return moves->pos;
 }
 
+bool movesIsBadCapturesStage(const Moves *moves) {
+	return (moves->stage==MovesStageBadCaptures);
+}
+
+unsigned movesGetCount(const Moves *moves) {
+	return moves->end-moves->list;
+}
+
 void movesPush(Moves *moves, Move move) {
 	assert(moves->end>=moves->list && moves->end<moves->list+MovesMax);
+	assert(posCanMakeMove(moves->pos, move)); // Generators should only produce legal moves.
 
-	// Combine with score and add to list
-	MoveScore score=searchScoreMove(moves->pos, move);
+	// Combine with score and add to list (bulk generation is never ordered so skip scoring).
+	MoveScore score=(moves->stage!=MovesStageBulk ? searchScoreMove(moves->search, moves->pos, move) : 0);
 	*moves->end++=scoredMoveMake(score, move);
 }
 
@@ -145,3 +206,83 @@ void movesSort(ScoredMove *start, ScoredMove *end) {
 		*(tempPtr+1)=temp;
 	}
 }
+
+ScoredMove movesPickBest(Moves *moves) {
+	assert(moves->next<moves->end);
+
+	// Often only the first move is needed (e.g. cut nodes), so select the
+	// first MovesPicksMax moves individually rather than sorting up front. A
+	// full selection sort needs more comparisons than insertion sort though,
+	// so if more moves are needed sort the remainder in one go.
+	if (moves->picksLeft<0)
+		return *moves->next++;
+	if (moves->picksLeft==0) {
+		movesSort(moves->next, moves->end);
+		moves->picksLeft=-1;
+		return *moves->next++;
+	}
+	--moves->picksLeft;
+
+	// Swap best into next slot.
+	ScoredMove *best=movesFindBest(moves->next, moves->end);
+	ScoredMove temp=*best;
+	*best=*moves->next;
+	*moves->next++=temp;
+
+	return temp;
+}
+
+ScoredMove *movesFindBest(ScoredMove *start, ScoredMove *end) {
+	assert(start<end);
+
+#	ifdef __AVX2__
+	// Find max 4 at a time (entries are unique so there are no ties). AVX2
+	// only has a signed comparison, so flip the top bits to compare unsigned.
+	if (end-start>=8) {
+		const __m256i sign=_mm256_set1_epi64x(INT64_MIN);
+		__m256i maxV=_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)start), sign);
+		ScoredMove *ptr;
+		for(ptr=start+4;ptr+4<=end;ptr+=4) {
+			__m256i v=_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)ptr), sign);
+			maxV=_mm256_blendv_epi8(maxV, v, _mm256_cmpgt_epi64(v, maxV));
+		}
+
+		// Reduce to a single value, including any leftover entries.
+		uint64_t lanes[4];
+		_mm256_storeu_si256((__m256i *)lanes, _mm256_xor_si256(maxV, sign));
+		ScoredMove max=lanes[0];
+		for(unsigned i=1;i<4;++i)
+			if (lanes[i]>max)
+				max=lanes[i];
+		for(;ptr<end;++ptr)
+			if (*ptr>max)
+				max=*ptr;
+
+		// Locate it.
+		__m256i keyV=_mm256_set1_epi64x(max);
+		for(ptr=start;ptr+4<=end;ptr+=4) {
+			int mask=_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)ptr), keyV)));
+			if (mask)
+				return ptr+__builtin_ctz(mask);
+		}
+		for(;;++ptr)
+			if (*ptr==max)
+				return ptr;
+	}
+#	endif
+
+	ScoredMove *best=start, *ptr;
+	for(ptr=start+1;ptr<end;++ptr)
+		if (scoredMoveCompGT(*ptr, *best))
+			best=ptr;
+	return best;
+}
+
+bool movesIsLosingCapture(const Moves *moves, Move move) {
+	const Pos *pos=moves->pos;
+	Sq fromSq=moveGetFromSq(move);
+	Sq toSqTrue=posMoveGetToSqTrue(pos, move);
+	if (posGetPieceOnSq(pos, toSqTrue)==PieceNone || moveGetToPieceType(move)!=pieceGetType(posGetPieceOnSq(pos, fromSq)))
+		return false;
+	return !seeGE(pos, fromSq, toSqTrue, 0);
+}
@@ -4,34 +4,43 @@
 #include <stdbool.h>
 
 typedef struct Moves Moves;
+typedef struct Search Search;
 
 #include "depth.h"
 #include "move.h"
 #include "pos.h"
 #include "scoredmove.h"
 
-typedef enum { MovesStageTT, MovesStageGenCaptures, MovesStageCaptures, MovesStageKillers, MovesStageGenQuiets, MovesStageQuiets } MovesStage;
+#define MovesPicksMax 1 // See movesPickBest() in moves.c.
+
+typedef enum { MovesStageTT, MovesStageGenCaptures, MovesStageCaptures, MovesStageKillers, MovesStageGenQuiets, MovesStageQuiets, MovesStageBadCaptures, MovesStageBulk } MovesStage;
 
 #define MovesMax 256
 struct Moves
 {
 	// All entries should be considered private - only here to allow easy allocation on the stack.
 	ScoredMove list[MovesMax], *next, *end;
+	ScoredMove *badEnd; // Losing captures are moved to [list, badEnd) as they are found, to be returned after the quiets.
 	MovesStage stage;
+	int picksLeft; // Number of moves to select one at a time before sorting the remainder of the list (-1 once sorted).
 	Move ttMove;
 	unsigned int killersIndex;
 	const Pos *pos;
-	Depth ply;
+	const Search *search;
+	const Move *killers;
 	MoveType allowed, needed;
 };
 
-void movesInit(Moves *moves, const Pos *pos, Depth ply, MoveType type);
+void movesInit(Moves *moves, const Pos *pos, const Search *search, Depth ply, MoveType type); // search provides the killers (for ply) and history used for ordering, or can be NULL to use neither.
+void movesInitBulk(Moves *moves, const Pos *pos); // Generates all legal moves immediately, without scoring or ordering (e.g. for perft).
 
 void movesRewind(Moves *moves, Move ttMove);
 
-Move movesNext(Moves *moves); // Returns distinct moves until none remain (then returning MoveInvalid).
+Move movesNext(Moves *moves); // Returns distinct legal moves until none remain (then returning MoveInvalid).
 
 const Pos *movesGetPos(Moves *moves);
+bool movesIsBadCapturesStage(const Moves *moves); // True once movesNext() has started returning captures which lose material (these come last).
+unsigned movesGetCount(const Moves *moves); // Number of moves generated so far (so all legal moves after movesInitBulk()).
 
 void movesPush(Moves *moves, Move move); // Used by generators to add moves.
 
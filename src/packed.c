@@ -0,0 +1,222 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "packed.h"
+#include "time.h"
+#include "uci.h"
+
+#define PackedWriterBufferCount 4096 // Records buffered before each write (128kb).
+
+struct PackedReader {
+	const uint8_t *map;
+	size_t count, next;
+	size_t mapSize;
+};
+
+struct PackedWriter {
+	FILE *file;
+	uint8_t buffer[PackedWriterBufferCount*PackedRecordSize];
+	size_t count;
+	bool error;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t packedGetLE(const uint8_t *bytes, unsigned int size);
+void packedSetLE(uint8_t *bytes, unsigned int size, uint64_t value);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+PackedReader *packedReaderNew(const char *path) {
+	PackedReader *reader=malloc(sizeof(PackedReader));
+	if (reader==NULL)
+		return NULL;
+	reader->map=NULL;
+	reader->count=reader->next=reader->mapSize=0;
+
+	// Map file (an empty file simply has no records).
+	int fd=open(path, O_RDONLY);
+	if (fd<0) {
+		free(reader);
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st)!=0) {
+		close(fd);
+		free(reader);
+		return NULL;
+	}
+	if (st.st_size>0) {
+		void *map=mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map==MAP_FAILED) {
+			close(fd);
+			free(reader);
+			return NULL;
+		}
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+		reader->map=map;
+		reader->mapSize=st.st_size;
+		reader->count=st.st_size/PackedRecordSize;
+	}
+	close(fd);
+
+	return reader;
+}
+
+void packedReaderFree(PackedReader *reader) {
+	if (reader==NULL)
+		return;
+	if (reader->map!=NULL)
+		munmap((void *)reader->map, reader->mapSize);
+	free(reader);
+}
+
+size_t packedReaderGetCount(const PackedReader *reader) {
+	return reader->count;
+}
+
+void packedReaderGet(const PackedReader *reader, size_t index, PosPacked *packed) {
+	assert(index<reader->count);
+	packedRecordRead(reader->map+index*PackedRecordSize, packed);
+}
+
+bool packedReaderNext(PackedReader *reader, PosPacked *packed) {
+	if (reader->next>=reader->count)
+		return false;
+	packedReaderGet(reader, reader->next++, packed);
+	return true;
+}
+
+PackedWriter *packedWriterNew(const char *path, bool append) {
+	PackedWriter *writer=malloc(sizeof(PackedWriter));
+	if (writer==NULL)
+		return NULL;
+	writer->file=fopen(path, (append ? "ab" : "wb"));
+	if (writer->file==NULL) {
+		free(writer);
+		return NULL;
+	}
+	setvbuf(writer->file, NULL, _IONBF, 0); // We do our own buffering.
+	writer->count=0;
+	writer->error=false;
+	return writer;
+}
+
+bool packedWriterFree(PackedWriter *writer) {
+	if (writer==NULL)
+		return true;
+	bool result=packedWriterFlush(writer);
+	result&=(fclose(writer->file)==0);
+	free(writer);
+	return result;
+}
+
+bool packedWriterWrite(PackedWriter *writer, const PosPacked *packed) {
+	packedRecordWrite(writer->buffer+PackedRecordSize*writer->count++, packed);
+	if (writer->count==PackedWriterBufferCount)
+		return packedWriterFlush(writer);
+	return !writer->error;
+}
+
+bool packedWriterFlush(PackedWriter *writer) {
+	if (writer->count>0 && fwrite(writer->buffer, PackedRecordSize, writer->count, writer->file)!=writer->count)
+		writer->error=true;
+	writer->count=0;
+	return !writer->error;
+}
+
+void packedRecordRead(const uint8_t bytes[static PackedRecordSize], PosPacked *packed) {
+	packed->occ=packedGetLE(bytes, 8);
+	memcpy(packed->pieces, bytes+8, 16);
+	packed->stm=bytes[24];
+	packed->halfMoveNumber=bytes[25];
+	packed->fullMoveNumber=packedGetLE(bytes+26, 2);
+	packed->score=(int16_t)packedGetLE(bytes+28, 2);
+	packed->result=bytes[30];
+	packed->padding=bytes[31];
+}
+
+void packedRecordWrite(uint8_t bytes[static PackedRecordSize], const PosPacked *packed) {
+	packedSetLE(bytes, 8, packed->occ);
+	memcpy(bytes+8, packed->pieces, 16);
+	bytes[24]=packed->stm;
+	bytes[25]=packed->halfMoveNumber;
+	packedSetLE(bytes+26, 2, packed->fullMoveNumber);
+	packedSetLE(bytes+28, 2, (uint16_t)packed->score);
+	bytes[30]=packed->result;
+	bytes[31]=packed->padding;
+}
+
+void packedRead(const char *path, size_t max) {
+	PackedReader *reader=packedReaderNew(path);
+	Pos *pos=posNew(NULL);
+	if (reader==NULL || pos==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", path);
+		goto cleanup;
+	}
+
+	// Print first few records.
+	size_t count=packedReaderGetCount(reader);
+	for(size_t i=0;i<count && (max==0 || i<max);++i) {
+		PosPacked packed;
+		packedReaderGet(reader, i, &packed);
+		if (!posFromPacked(pos, &packed)) {
+			uciWrite("%zu invalid\n", i);
+			continue;
+		}
+		char fen[128];
+		posGetFEN(pos, fen);
+		uciWrite("%zu %s score %i result %u\n", i, fen, packed.score, packed.result);
+	}
+
+	// Decode all records (checking they round trip).
+	size_t invalid=0, mismatch=0;
+	TimeMs time=timeGet();
+	PosPacked packed;
+	while(packedReaderNext(reader, &packed)) {
+		PosPacked repacked;
+		if (!posFromPacked(pos, &packed))
+			++invalid;
+		else {
+			posToPacked(pos, &repacked);
+			repacked.score=packed.score;
+			repacked.result=packed.result;
+			repacked.padding=packed.padding;
+			mismatch+=(memcmp(&repacked, &packed, sizeof(PosPacked))!=0);
+		}
+	}
+	time=timeGet()-time;
+	uciWrite("records %zu invalid %zu mismatched %zu time %llums (%.1fM records/s)\n", count, invalid, mismatch, time,
+	         (time>0 ? count/(time*1000.0) : 0.0));
+
+	cleanup:
+	packedReaderFree(reader);
+	if (pos!=NULL)
+		posFree(pos);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t packedGetLE(const uint8_t *bytes, unsigned int size) {
+	uint64_t value=0;
+	for(unsigned int i=0;i<size;++i)
+		value|=((uint64_t)bytes[i])<<(8*i);
+	return value;
+}
+
+void packedSetLE(uint8_t *bytes, unsigned int size, uint64_t value) {
+	for(unsigned int i=0;i<size;++i)
+		bytes[i]=(value>>(8*i))&0xFF;
+}
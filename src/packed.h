@@ -0,0 +1,36 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pos.h"
+
+// Files of PosPacked records (see pos.h), e.g. as written by datagen(). Each record is stored as PackedRecordSize
+// bytes with every field little-endian (in the order declared), so files can be shared between machines.
+
+#define PackedRecordSize 32
+
+typedef struct PackedReader PackedReader;
+typedef struct PackedWriter PackedWriter;
+
+PackedReader *packedReaderNew(const char *path); // Maps the whole file read-only, returns NULL on failure. A trailing partial record is ignored.
+void packedReaderFree(PackedReader *reader);
+
+size_t packedReaderGetCount(const PackedReader *reader);
+void packedReaderGet(const PackedReader *reader, size_t index, PosPacked *packed); // Random access, index must be less than the count.
+bool packedReaderNext(PackedReader *reader, PosPacked *packed); // Sequential access, returns false once all records have been read.
+
+PackedWriter *packedWriterNew(const char *path, bool append); // Returns NULL on failure.
+bool packedWriterFree(PackedWriter *writer); // Flushes then closes the file, returning false if any write failed.
+
+bool packedWriterWrite(PackedWriter *writer, const PosPacked *packed); // Buffered, returns false if a write to the file failed.
+bool packedWriterFlush(PackedWriter *writer);
+
+void packedRecordRead(const uint8_t bytes[static PackedRecordSize], PosPacked *packed);
+void packedRecordWrite(uint8_t bytes[static PackedRecordSize], const PosPacked *packed);
+
+void packedRead(const char *path, size_t max); // Prints up to max records (0 for all) as FEN, score and result, then checks and times decoding every record.
+
+#endif
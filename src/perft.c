@@ -1,13 +1,63 @@
 #include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "htable.h"
 #include "moves.h"
 #include "perft.h"
 #include "time.h"
 #include "uci.h"
 
+typedef struct {
+	Key key;
+	uint64_t nodes:56;
+	uint64_t depth:8;
+} PerftHashEntry;
+
+STATICASSERT(DepthBit<=8);
+
+HTable *perftHash=NULL; // Only allocated by the first perft command, so that play does not pay for it.
+unsigned int perftHashSizeMb=0; // Size to allocate, 0 disables the hash.
+const unsigned int perftHashDefaultSizeMb=16;
+const unsigned int perftHashMaxSizeMb=1024*1024;
+
+#define PerftSuiteMaxDepth 16
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+HTableKey perftHashKey(Key key, Depth depth);
+void perftHashAlloc(void); // Allocates the hash (if enabled and not already done).
+
+void perftHashResizeInterface(void *userData, long long int sizeMb); // Size 0 disables the hash.
+void perftHashClearInterface(void *userData);
+
+bool perftSuiteLine(char *line, unsigned int lineNumber); // Returns true if all depths given in line match.
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void perftInit(void) {
+	// Setup perft hash options (the table itself is allocated on first use).
+	perftHashSizeMb=perftHashDefaultSizeMb;
+	uciOptionNewSpin("PerftHash", &perftHashResizeInterface, NULL, 0, perftHashMaxSizeMb, perftHashDefaultSizeMb);
+	uciOptionNewButton("ClearPerftHash", &perftHashClearInterface, NULL);
+}
+
+void perftQuit(void) {
+	if (perftHash!=NULL)
+		htableFree(perftHash);
+	perftHash=NULL;
+}
+
 void perft(Pos *pos, Depth maxDepth) {
 	assert(depthIsValid(maxDepth));
 
+	perftHashAlloc();
+
 	uciWrite("Perft:\n");
 	uciWrite("%6s %11s %9s %15s\n", "Depth", "Nodes", "Time", "NPS");
 	Depth depth;
@@ -28,14 +78,16 @@ void divide(Pos *pos, Depth depth) {
 	if (depth<1)
 		return;
 
+	perftHashAlloc();
+
 	unsigned long long int total=0;
 	Moves moves;
-	movesInit(&moves, pos, 0, MoveTypeAny);
+	movesInitBulk(&moves, pos);
 	Move move;
 	while((move=movesNext(&moves))!=MoveInvalid) {
 		char str[8];
 		posMoveToStr(pos, move, str);
-		if (!posMakeMove(pos, move))
+		if (!posMakeMoveUnchecked(pos, move))
 			continue;
 		unsigned long long int nodes=perftRaw(pos, depth-1);
 		uciWrite("  %6s %12llu\n", str, nodes);
@@ -51,22 +103,154 @@ unsigned long long int perftRaw(Pos *pos, Depth depth) {
 	if (depth<1)
 		return 1;
 
-	unsigned long long int total=0;
+	// Bulk counting - moves are generated legal so no need to make them.
 	Moves moves;
-	movesInit(&moves, pos, 0, MoveTypeAny);
-	Move move;
+	movesInitBulk(&moves, pos);
+	if (depth==1)
+		return movesGetCount(&moves);
 
-	if (depth==1) {
-		while((move=movesNext(&moves))!=MoveInvalid)
-			total+=posCanMakeMove(pos, move);
-	} else {
-		while((move=movesNext(&moves))!=MoveInvalid) {
-			if (!posMakeMove(pos, move))
-				continue;
-			total+=perftRaw(pos, depth-1);
-			posUndoMove(pos);
+	// Check hash.
+	PerftHashEntry *entry=NULL;
+	HTableKey hashKey=perftHashKey(posGetKey(pos), depth);
+	if (perftHash!=NULL) {
+		entry=htableGrab(perftHash, hashKey);
+		if (entry->key==posGetKey(pos) && entry->depth==depth) {
+			unsigned long long int nodes=entry->nodes;
+			htableRelease(perftHash, hashKey);
+			return nodes;
 		}
+		htableRelease(perftHash, hashKey);
+	}
+
+	// Search.
+	unsigned long long int total=0;
+	Move move;
+	while((move=movesNext(&moves))!=MoveInvalid) {
+		if (!posMakeMoveUnchecked(pos, move))
+			continue;
+		total+=perftRaw(pos, depth-1);
+		posUndoMove(pos);
+	}
+
+	// Update hash (always replace).
+	if (perftHash!=NULL) {
+		entry=htableGrab(perftHash, hashKey);
+		entry->key=posGetKey(pos);
+		entry->nodes=total;
+		entry->depth=depth;
+		htableRelease(perftHash, hashKey);
 	}
 
 	return total;
 }
+
+void perftSuite(const char *path) {
+	FILE *file=fopen(path, "r");
+	if (file==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", path);
+		return;
+	}
+
+	perftHashAlloc();
+
+	// Run each line in turn.
+	char *line=NULL;
+	size_t lineSize=0;
+	unsigned int lineNumber=0, passCount=0, failCount=0;
+	TimeMs time=timeGet();
+	while(getline(&line, &lineSize, file)>=0) {
+		++lineNumber;
+
+		// Skip blank lines and comments.
+		char *c=line+strspn(line, " \t\r\n");
+		if (*c=='\0' || *c=='#')
+			continue;
+
+		if (perftSuiteLine(c, lineNumber))
+			++passCount;
+		else
+			++failCount;
+	}
+	time=timeGet()-time;
+	free(line);
+	fclose(file);
+
+	uciWrite("Suite: %u passed, %u failed (%llu.%03llus)\n", passCount, failCount, time/1000, time%1000);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+HTableKey perftHashKey(Key key, Depth depth) {
+	// Spread different depths of the same position over the table.
+	return (HTableKey)(key^(depth*0x9E3779B97F4A7C15llu));
+}
+
+void perftHashAlloc(void) {
+	if (perftHash!=NULL || perftHashSizeMb==0)
+		return;
+
+	perftHash=htableNew(sizeof(PerftHashEntry), perftHashSizeMb);
+	if (perftHash==NULL)
+		uciWrite("Error: Could not allocate perft hash table, continuing without it.\n");
+}
+
+void perftHashResizeInterface(void *userData, long long int sizeMb) {
+	perftHashSizeMb=sizeMb;
+	if (sizeMb==0) {
+		perftQuit();
+		return;
+	}
+
+	// Only resize an existing table, otherwise the new size is used when it is first needed.
+	if (perftHash!=NULL)
+		htableResize(perftHash, sizeMb);
+}
+
+void perftHashClearInterface(void *userData) {
+	if (perftHash!=NULL)
+		htableClear(perftHash);
+}
+
+bool perftSuiteLine(char *line, unsigned int lineNumber) {
+	// Format is: fen ;D1 20 ;D2 400 ...
+	char *savePtr;
+	char *fen=strtok_r(line, ";", &savePtr);
+	fen[strcspn(fen, "\r\n")]='\0';
+
+	Pos pos;
+	if (!posInitInPlace(&pos, fen)) {
+		uciWrite("%4u FAIL bad fen '%s'\n", lineNumber, fen);
+		return false;
+	}
+
+	// Check each depth given.
+	bool pass=true;
+	unsigned long long int totalNodes=0;
+	Depth maxDepth=0;
+	TimeMs time=timeGet();
+	char *field;
+	while((field=strtok_r(NULL, ";", &savePtr))!=NULL) {
+		unsigned int depth;
+		unsigned long long int expected;
+		if (sscanf(field, " D%u %llu", &depth, &expected)!=2 || depth<1 || depth>PerftSuiteMaxDepth)
+			continue;
+
+		unsigned long long int nodes=perftRaw(&pos, depth);
+		totalNodes+=nodes;
+		if (depth>maxDepth)
+			maxDepth=depth;
+		if (nodes!=expected) {
+			uciWrite("%4u FAIL depth %u expected %llu got %llu: %s\n", lineNumber, depth, expected, nodes, fen);
+			pass=false;
+		}
+	}
+	time=timeGet()-time;
+
+	if (pass)
+		uciWrite("%4u pass depth %2u %12llu nodes %7.1fMnps: %s\n", lineNumber, (unsigned int)maxDepth, totalNodes,
+		         (time>0 ? totalNodes/(time*1000.0) : 0.0), fen);
+
+	return pass;
+}
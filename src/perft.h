@@ -4,8 +4,13 @@
 #include "depth.h"
 #include "pos.h"
 
+void perftInit(void);
+void perftQuit(void);
+
 void perft(Pos *pos, Depth maxDepth);
 void divide(Pos *pos, Depth depth);
-unsigned long long int perftRaw(Pos *pos, Depth depth);
+unsigned long long int perftRaw(Pos *pos, Depth depth); // Uses the perft hash (see 'PerftHash' option) if enabled.
+
+void perftSuite(const char *path); // Runs each EPD line of the form 'fen ;D1 20 ;D2 400 ...' reporting pass/fail. Castling rights are parsed as for Chess960.
 
 #endif
@@ -0,0 +1,415 @@
+#include <assert.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pgn.h"
+#include "thread.h"
+#include "time.h"
+#include "uci.h"
+#include "util.h"
+
+#define PgnScanThreadsMax 64
+#define PgnScanErrorsShown 8 // Per thread.
+
+struct PgnReader {
+	const char *map; // NULL if reader does not own the mapping (see pgnReaderSplit()).
+	size_t mapSize;
+	const char *next, *end;
+};
+
+typedef struct {
+	PgnReader *reader;
+	unsigned long long int games, moves, errors, results[PgnResultNB];
+} PgnScanWork;
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+const char *pgnParseTag(const char *c, const char *end, PgnGame *game, size_t *bufferUsed); // c should point to the opening '['. Returns pointer to after the tag.
+const char *pgnSkipVariation(const char *c, const char *end); // c should point to the opening '('. Returns pointer to after the matching ')'.
+const char *pgnSkipLine(const char *c, const char *end);
+const char *pgnFindGameStart(const char *c, const char *end); // Finds first line starting with '[' following a blank line (or end).
+bool pgnSetupPos(PgnGame *game, Pos *pos);
+PgnResult pgnTokenToResult(const char *token, size_t len); // Returns PgnResultUnknown for '*', and PgnResultNB if not a result token.
+
+void pgnScanWorker(void *userData);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+PgnReader *pgnReaderNew(const char *path) {
+	int fd=open(path, O_RDONLY);
+	if (fd<0)
+		return NULL;
+	struct stat st;
+	if (fstat(fd, &st)!=0) {
+		close(fd);
+		return NULL;
+	}
+
+	PgnReader *reader=malloc(sizeof(PgnReader));
+	if (reader==NULL) {
+		close(fd);
+		return NULL;
+	}
+	reader->map=NULL;
+	reader->mapSize=0;
+	reader->next=reader->end=NULL;
+	if (st.st_size>0) {
+		void *map=mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map==MAP_FAILED) {
+			close(fd);
+			free(reader);
+			return NULL;
+		}
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+		reader->map=map;
+		reader->mapSize=st.st_size;
+		reader->next=map;
+		reader->end=reader->next+st.st_size;
+	}
+	close(fd);
+
+	return reader;
+}
+
+void pgnReaderFree(PgnReader *reader) {
+	if (reader==NULL)
+		return;
+	if (reader->map!=NULL)
+		munmap((void *)reader->map, reader->mapSize);
+	free(reader);
+}
+
+unsigned int pgnReaderSplit(const PgnReader *reader, PgnReader **readers, unsigned int count) {
+	assert(count>0);
+
+	size_t size=reader->end-reader->next;
+	const char *begin=reader->next;
+	unsigned int created=0;
+	for(unsigned int i=0;i<count && begin<reader->end;++i) {
+		const char *end=(i+1<count ? pgnFindGameStart(utilMax(begin, reader->next+(size*(i+1))/count), reader->end) : reader->end);
+		if (end==begin)
+			continue;
+
+		PgnReader *part=malloc(sizeof(PgnReader));
+		if (part==NULL)
+			break;
+		part->map=NULL;
+		part->mapSize=0;
+		part->next=begin;
+		part->end=end;
+		readers[created++]=part;
+		begin=end;
+	}
+
+	return created;
+}
+
+bool pgnReaderNext(PgnReader *reader, PgnGame *game, Pos *pos) {
+	// Reset game.
+	size_t bufferUsed=0;
+	game->tagCount=0;
+	game->startFen[0]='\0';
+	game->moveCount=0;
+	game->result=PgnResultUnknown;
+	game->error[0]='\0';
+
+	// Parse tags then movetext until a result token (or the next game's tags).
+	bool inMoves=false;
+	const char *c=reader->next, *end=reader->end;
+	while(c<end) {
+		if (isspace(*c)) {
+			++c;
+			continue;
+		}
+
+		// Tags.
+		if (*c=='[') {
+			if (inMoves)
+				break; // Next game started without a result token.
+			c=pgnParseTag(c, end, game, &bufferUsed);
+			continue;
+		}
+
+		// Start of movetext (may also be a line comment or escape in the tags).
+		if (*c==';' || (*c=='%' && (c==reader->next || c[-1]=='\n'))) {
+			c=pgnSkipLine(c, end);
+			continue;
+		}
+		if (!inMoves) {
+			inMoves=true;
+			if (!pgnSetupPos(game, pos))
+				snprintf(game->error, PgnErrorMax, "bad FEN tag '%s'", game->startFen);
+		}
+
+		// Comments, variations and NAGs.
+		if (*c=='{') {
+			const char *close=memchr(c, '}', end-c);
+			c=(close!=NULL ? close+1 : end);
+			continue;
+		}
+		if (*c=='(') {
+			c=pgnSkipVariation(c, end);
+			continue;
+		}
+		if (*c==')' || *c=='}' || *c==']') {
+			++c; // Stray.
+			continue;
+		}
+
+		// Otherwise read a token (move, move number or result).
+		const char *token=c;
+		while(c<end && !isspace(*c) && *c!='{' && *c!='}' && *c!='(' && *c!=')' && *c!='[' && *c!=']' && *c!=';' && (c==token || *c!='$'))
+			++c;
+		size_t len=c-token;
+		if (*token=='$')
+			continue;
+
+		PgnResult result=pgnTokenToResult(token, len);
+		if (result!=PgnResultNB) {
+			game->result=result;
+			break;
+		}
+
+		// Skip move number (e.g. '12.' or '12...', possibly attached to the move).
+		const char *san=token;
+		while(san<c && isdigit(*san))
+			++san;
+		if (san<c && *san=='.') {
+			while(san<c && *san=='.')
+				++san;
+		} else
+			san=token;
+		if (san==c || game->error[0]!='\0')
+			continue;
+
+		// Parse and make move.
+		char str[16];
+		size_t sanLen=utilMin((size_t)(c-san), sizeof(str)-1);
+		memcpy(str, san, sanLen);
+		str[sanLen]='\0';
+		if (game->moveCount>=PosGameMax) {
+			snprintf(game->error, PgnErrorMax, "game too long");
+			continue;
+		}
+		Move move=posMoveFromSan(pos, str);
+		if (move==MoveInvalid) {
+			snprintf(game->error, PgnErrorMax, "illegal or ambiguous move '%s' at ply %u", str, game->moveCount+1);
+			continue;
+		}
+		posMakeMove(pos, move);
+		game->moves[game->moveCount++]=move;
+	}
+	reader->next=c;
+
+	// Tags without any movetext at the end of the input still count as a game.
+	if (!inMoves && game->tagCount>0 && !pgnSetupPos(game, pos))
+		snprintf(game->error, PgnErrorMax, "bad FEN tag '%s'", game->startFen);
+
+	return (inMoves || game->tagCount>0);
+}
+
+const char *pgnGameGetTag(const PgnGame *game, const char *name) {
+	for(unsigned int i=0;i<game->tagCount;++i)
+		if (utilStrEqual(game->tagNames[i], name))
+			return game->tagValues[i];
+	return NULL;
+}
+
+void pgnScan(const char *path, unsigned int threads) {
+	threads=utilMax(1u, utilMin(threads, (unsigned int)PgnScanThreadsMax));
+
+	PgnReader *reader=pgnReaderNew(path);
+	if (reader==NULL) {
+		uciWrite("Error: Could not open '%s'.\n", path);
+		return;
+	}
+
+	// Split input and parse each part in its own thread.
+	PgnReader *readers[PgnScanThreadsMax];
+	Thread *workers[PgnScanThreadsMax];
+	PgnScanWork work[PgnScanThreadsMax];
+	TimeMs time=timeGet();
+	unsigned int count=pgnReaderSplit(reader, readers, threads);
+	for(unsigned int i=0;i<count;++i) {
+		memset(&work[i], 0, sizeof(PgnScanWork));
+		work[i].reader=readers[i];
+		workers[i]=threadNew();
+		if (workers[i]==NULL)
+			pgnScanWorker(&work[i]);
+		else
+			threadRun(workers[i], &pgnScanWorker, &work[i]);
+	}
+
+	// Wait and combine results.
+	PgnScanWork total;
+	memset(&total, 0, sizeof(total));
+	for(unsigned int i=0;i<count;++i) {
+		threadFree(workers[i]); // Waits for the thread to finish.
+		pgnReaderFree(readers[i]);
+		total.games+=work[i].games;
+		total.moves+=work[i].moves;
+		total.errors+=work[i].errors;
+		for(unsigned int r=0;r<PgnResultNB;++r)
+			total.results[r]+=work[i].results[r];
+	}
+	time=timeGet()-time;
+
+	uciWrite("games %llu (1-0 %llu, 1/2 %llu, 0-1 %llu, * %llu) moves %llu errors %llu\n", total.games, total.results[PgnResultWhiteWins],
+	         total.results[PgnResultDraw], total.results[PgnResultBlackWins], total.results[PgnResultUnknown], total.moves, total.errors);
+	uciWrite("threads %u time %llums (%.1fMB/s, %.0f games/s)\n", count, time, (time>0 ? reader->mapSize/(time*1000.0) : 0.0),
+	         (time>0 ? (total.games*1000.0)/time : 0.0));
+
+	pgnReaderFree(reader);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+const char *pgnParseTag(const char *c, const char *end, PgnGame *game, size_t *bufferUsed) {
+	assert(*c=='[');
+	++c;
+
+	// Name.
+	while(c<end && isspace(*c))
+		++c;
+	const char *name=c;
+	while(c<end && !isspace(*c) && *c!='"' && *c!=']')
+		++c;
+	size_t nameLen=c-name;
+
+	// Value (unescaping as we go, straight into the buffer if there is room).
+	while(c<end && *c!='"' && *c!=']' && *c!='\n')
+		++c;
+	bool store=(game->tagCount<PgnTagsMax && *bufferUsed+nameLen+1<PgnTagBufferSize);
+	char *dest=game->tagBuffer+*bufferUsed;
+	if (store) {
+		memcpy(dest, name, nameLen);
+		dest[nameLen]='\0';
+		game->tagNames[game->tagCount]=dest;
+		dest+=nameLen+1;
+	}
+	char *value=dest;
+	if (c<end && *c=='"') {
+		++c;
+		while(c<end && *c!='"' && *c!='\n') {
+			if (*c=='\\' && c+1<end)
+				++c;
+			if (store && dest+1<game->tagBuffer+PgnTagBufferSize)
+				*dest++=*c;
+			++c;
+		}
+	}
+	if (store) {
+		*dest++='\0';
+		game->tagValues[game->tagCount++]=value;
+		*bufferUsed=dest-game->tagBuffer;
+		if (utilStrEqual(game->tagNames[game->tagCount-1], "FEN")) {
+			strncpy(game->startFen, value, sizeof(game->startFen)-1);
+			game->startFen[sizeof(game->startFen)-1]='\0';
+		}
+	}
+
+	// Closing bracket.
+	while(c<end && *c!=']' && *c!='\n')
+		++c;
+	return (c<end && *c==']' ? c+1 : c);
+}
+
+const char *pgnSkipVariation(const char *c, const char *end) {
+	assert(*c=='(');
+	unsigned int depth=0;
+	while(c<end) {
+		switch(*c) {
+			case '(': ++depth; ++c; break;
+			case ')': ++c; if (--depth==0) return c; break;
+			case '{': {
+				const char *close=memchr(c, '}', end-c);
+				c=(close!=NULL ? close+1 : end);
+			} break;
+			case ';': c=pgnSkipLine(c, end); break;
+			default: ++c; break;
+		}
+	}
+	return c;
+}
+
+const char *pgnSkipLine(const char *c, const char *end) {
+	const char *newline=memchr(c, '\n', end-c);
+	return (newline!=NULL ? newline+1 : end);
+}
+
+const char *pgnFindGameStart(const char *c, const char *end) {
+	// Start from the next full line.
+	c=pgnSkipLine(c, end);
+	bool prevBlank=false;
+	while(c<end) {
+		if (*c=='[' && prevBlank)
+			return c;
+		const char *next=pgnSkipLine(c, end);
+		prevBlank=true;
+		for(const char *p=c;p<next;++p)
+			if (!isspace(*p)) {
+				prevBlank=false;
+				break;
+			}
+		c=next;
+	}
+	return end;
+}
+
+bool pgnSetupPos(PgnGame *game, Pos *pos) {
+	if (game->startFen[0]!='\0')
+		return posSetToFEN(pos, game->startFen);
+	posSetToFEN(pos, NULL);
+	posGetFEN(pos, game->startFen);
+	return true;
+}
+
+PgnResult pgnTokenToResult(const char *token, size_t len) {
+	if (len==3 && strncmp(token, "1-0", 3)==0)
+		return PgnResultWhiteWins;
+	if (len==3 && strncmp(token, "0-1", 3)==0)
+		return PgnResultBlackWins;
+	if (len==7 && strncmp(token, "1/2-1/2", 7)==0)
+		return PgnResultDraw;
+	if (len==1 && *token=='*')
+		return PgnResultUnknown;
+	return PgnResultNB;
+}
+
+void pgnScanWorker(void *userData) {
+	PgnScanWork *work=(PgnScanWork *)userData;
+
+	PgnGame *game=malloc(sizeof(PgnGame));
+	Pos *pos=posNew(NULL);
+	if (game==NULL || pos==NULL) {
+		free(game);
+		if (pos!=NULL)
+			posFree(pos);
+		return;
+	}
+
+	while(pgnReaderNext(work->reader, game, pos)) {
+		++work->games;
+		work->moves+=game->moveCount;
+		++work->results[game->result];
+		if (game->error[0]!='\0' && work->errors++<PgnScanErrorsShown) {
+			const char *white=pgnGameGetTag(game, "White"), *black=pgnGameGetTag(game, "Black");
+			uciWrite("Error: %s ('%s' v '%s').\n", game->error, (white!=NULL ? white : "?"), (black!=NULL ? black : "?"));
+		}
+	}
+
+	free(game);
+	posFree(pos);
+}
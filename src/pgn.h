@@ -0,0 +1,51 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "move.h"
+#include "pos.h"
+
+#define PgnTagsMax 32
+#define PgnTagBufferSize 2048
+#define PgnErrorMax 128
+
+typedef enum {
+	PgnResultBlackWins=0, // Same values as the result field of datagen records.
+	PgnResultDraw=1,
+	PgnResultWhiteWins=2,
+	PgnResultUnknown=3,
+	PgnResultNB
+} PgnResult;
+
+// A single game, reused between calls to pgnReaderNext() so reading does not allocate.
+typedef struct {
+	const char *tagNames[PgnTagsMax], *tagValues[PgnTagsMax]; // Point into tagBuffer.
+	unsigned int tagCount;
+	char tagBuffer[PgnTagBufferSize];
+	char startFen[128]; // From 'FEN' tag, or the standard initial position.
+	Move moves[PosGameMax];
+	unsigned int moveCount;
+	PgnResult result;
+	char error[PgnErrorMax]; // Empty unless the game could not be fully parsed (moves up to the error are still given).
+} PgnGame;
+
+typedef struct PgnReader PgnReader;
+
+PgnReader *pgnReaderNew(const char *path); // Maps the whole file read-only, returns NULL on failure.
+void pgnReaderFree(PgnReader *reader);
+
+// Splits the remaining input of reader into up to count readers each starting at a game boundary, returning the number
+// created. The new readers share reader's mapping so must be freed before it.
+unsigned int pgnReaderSplit(const PgnReader *reader, PgnReader **readers, unsigned int count);
+
+// Reads the next game, using pos to resolve SAN moves (afterwards pos is at the final position reached). Comments,
+// NAGs and variations are skipped. Returns false once there are no more games.
+bool pgnReaderNext(PgnReader *reader, PgnGame *game, Pos *pos);
+
+const char *pgnGameGetTag(const PgnGame *game, const char *name); // Returns NULL if tag not present.
+
+void pgnScan(const char *path, unsigned int threads); // Parses every game (split over the given number of threads), reporting counts, errors and speed.
+
+#endif
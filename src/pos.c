@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <ctype.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -7,6 +8,7 @@
 #include "eval.h"
 #include "fen.h"
 #include "pos.h"
+#include "tables.h"
 #include "uci.h"
 #include "util.h"
 
@@ -20,50 +22,47 @@ const CastRights CastRightsNone={
 STATICASSERT(MoveBit<=16);
 STATICASSERT(PieceBit<=4);
 STATICASSERT(SqBit<=8);
-typedef struct {
-	Key key;
-	uint64_t lastMove:16;
-	uint64_t lastMoveWasPromo:1;
-	uint64_t halfMoveNumber:15;
-	uint64_t epSq:7;
-	uint64_t capSq:7;
-	uint64_t capPiece:4;
-	uint64_t padding:10;
-	CastRights castRights;
-} PosData;
-
 STATICASSERT(PieceBit<=8);
-struct Pos {
-	BB bbPiece[PieceNB];
-	uint8_t array64[SqNB]; // entries are Pieces
-	PosData *dataStart, *dataEnd, *data;
-	BB bbColour[ColourNB], bbAll;
-	Colour stm;
-	unsigned int fullMoveNumber;
-	Key pawnKey, matKey;
-	VPair pstScore; // From white's POV
-};
+
+#define PosPackedCastRook 12 // PosPacked piece codes, see pos.h (black castling rook is one higher).
+#define PosPackedEPPawn 14
+STATICASSERT(sizeof(PosPacked)==32);
 
 const char *posStartFEN="rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+#ifdef TABLES
+extern const Key posKeySTM, posKeyPiece[16][SqNB], posKeyEP[SqMax], posKeyCastling[SqMax]; // See tables.c.
+extern const Key posPawnKeyPiece[PieceNB][SqNB];
+extern const Key posMatKey[PieceNB];
+#else
 Key posKeySTM, posKeyPiece[16][SqNB], posKeyEP[SqMax], posKeyCastling[SqMax];
 Key posPawnKeyPiece[PieceNB][SqNB];
 Key posMatKey[PieceNB];
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private prototypes.
 ////////////////////////////////////////////////////////////////////////////////
 
 void posClean(Pos *pos);
+void posSetToFenData(Pos *pos, const Fen *fen);
 
 void posPieceAdd(Pos *pos, Piece piece, Sq sq, bool skipMainKeyUpdate);
 void posPieceRemove(Pos *pos, Sq sq, bool skipMainKeyUpdate);
 void posPieceMove(Pos *pos, Sq fromSq, Sq toSq, bool skipMainKeyUpdate);
 void posPieceMoveChange(Pos *pos, Sq fromSq, Sq toSq, Piece toPiece, bool skipMainKeyUpdate);
 
-void posGenPseudoNormal(Moves *moves, BB allowed);
-void posGenPseudoPawnMoves(Moves *moves, MoveType type);
-void posGenPseudoCast(Moves *moves);
+void posGenLegalNormal(Moves *moves, BB allowed, BB pinned); // Knights, bishops, rooks and queens.
+void posGenLegalKing(Moves *moves, BB allowed);
+void posGenLegalEvasions(Moves *moves, MoveType type, BB checkers); // Side to move must be in check (by the pieces in checkers).
+void posGenLegalPawnMoves(Moves *moves, MoveType type, BB target, BB pinned);
+void posGenLegalCast(Moves *moves);
+
+void posUpdateCheckInfo(Pos *pos); // Recomputes the checkers, pinned and discoverers fields of the current data entry.
+BB posComputeCheckers(const Pos *pos); // Pieces giving check to the side to move.
+BB posComputeBlockers(const Pos *pos, Colour colour); // Pieces of either colour which are the only piece between the king of the given colour and an enemy slider.
+BB posPinRay(Sq kingSq, Sq pinnedSq); // Squares a piece on pinnedSq (pinned to the king on kingSq) can move to without exposing the king.
+bool posIsSqAttackedByColourOcc(const Pos *pos, Sq sq, Colour colour, BB occ); // As posIsSqAttackedByColour() but using the given occupancy for sliders.
 
 Key posComputeKey(const Pos *pos);
 Key posComputePawnKey(const Pos *pos);
@@ -79,11 +78,16 @@ bool posMoveIsPseudoLegalInternal(const Pos *pos, Move move);
 
 bool posLegalMoveExistsPiece(const Pos *pos, PieceType type, BB allowed);
 
+bool posMoveGivesCheck(const Pos *pos, Move move); // Move must be legal.
+
+void posSanNormalise(const char *str, char *out, size_t outSize); // Strips check/annotation suffixes and '=', and accepts zeros in castling moves. str and out may be equal.
+
 ////////////////////////////////////////////////////////////////////////////////
 // Public functions.
 ////////////////////////////////////////////////////////////////////////////////
 
 void posInit(void) {
+#	ifndef TABLES
 	// Hash keys
 	utilRandSeed(1804289383);
 	posKeySTM=posRandKey();
@@ -126,27 +130,17 @@ void posInit(void) {
 			Piece piece=pieceMake(pieceType, colour);
 			posMatKey[piece]=posRandKey();
 		}
+#	endif
 }
 
-Pos *posNew(const char *gfen) {
-	const size_t initialPosDataSize=64;
-
+Pos *posNew(const char *fen) {
 	// Create clean position.
 	Pos *pos=malloc(sizeof(Pos));
-	PosData *posData=malloc(initialPosDataSize*sizeof(PosData));
-	if (pos==NULL || posData==NULL) {
-		free(pos);
-		free(posData);
+	if (pos==NULL)
 		return NULL;
-	}
-	pos->dataStart=posData;
-	pos->dataEnd=posData+initialPosDataSize;
-
-	// If no FEN given use initial position.
-	const char *fen=(gfen!=NULL ? gfen : posStartFEN);
 
 	// Set to FEN.
-	if (!posSetToFEN(pos, fen)) {
+	if (!posInitInPlace(pos, fen)) {
 		posFree(pos);
 		return NULL;
 	}
@@ -157,58 +151,42 @@ Pos *posNew(const char *gfen) {
 Pos *posNewFromPos(const Pos *src) {
 	assert(src!=NULL);
 
-	Pos *pos=posNew(NULL);
+	Pos *pos=malloc(sizeof(Pos));
 	if (pos==NULL)
 		return NULL;
 
-	if (!posCopy(pos, src)) {
-		posFree(pos);
-		return NULL;
-	}
+	posCopy(pos, src);
 
 	return pos;
 }
 
 void posFree(Pos *pos) {
-	if (pos==NULL)
-		return;
-	free(pos->dataStart);
 	free(pos);
 }
 
-bool posCopy(Pos *dest, const Pos *src) {
-	assert(dest!=NULL);
-	assert(src!=NULL);
+bool posInitInPlace(Pos *pos, const char *fen) {
+	// Start from the initial position so pos is valid even if the given FEN is not.
+	bool result=posSetToFEN(pos, NULL);
+	assert(result);
 
-	// Allocate more memory if needed
-	size_t srcDataSize=(src->dataEnd-src->dataStart);
-	size_t destDataSize=(dest->dataEnd-dest->dataStart);
-	size_t newDataSize;
-	PosData *newPosData;
-	if (srcDataSize>destDataSize) {
-		newDataSize=srcDataSize;
-		newPosData=realloc(dest->dataStart, newDataSize*sizeof(PosData));
-		if (newPosData==NULL) {
-			free(newPosData);
-			return false;
-		}
-	} else {
-		newDataSize=destDataSize;
-		newPosData=dest->dataStart;
-	}
+	// If no FEN given use initial position.
+	if (fen!=NULL)
+		result=posSetToFEN(pos, fen);
+
+	return result;
+}
 
-	// Set data
-	*dest=*src;
+void posCopy(Pos *dest, const Pos *src) {
+	assert(dest!=NULL);
+	assert(src!=NULL);
 
-	dest->dataStart=newPosData;
-	dest->dataEnd=newPosData+newDataSize;
+	// Copy everything except the unused part of the history.
 	size_t srcDataLen=(src->data-src->dataStart);
-	dest->data=newPosData+srcDataLen;
+	memcpy(dest, src, offsetof(Pos, dataStart));
 	memcpy(dest->dataStart, src->dataStart, (srcDataLen+1)*sizeof(PosData));
+	dest->data=dest->dataStart+srcDataLen;
 
 	assert(posIsConsistent(dest));
-
-	return true;
 }
 
 bool posSetToFEN(Pos *pos, const char *string) {
@@ -220,23 +198,7 @@ bool posSetToFEN(Pos *pos, const char *string) {
 	} else if (!fenRead(&fen, string))
 		return false;
 
-	// Set position to clean state.
-	posClean(pos);
-
-	// Set position to given FEN.
-	Sq sq;
-	for(sq=0;sq<SqNB;++sq)
-		if (fen.array[sq]!=PieceNone)
-			posPieceAdd(pos, fen.array[sq], sq, true);
-	pos->stm=fen.stm;
-	pos->fullMoveNumber=fen.fullMoveNumber;
-	pos->data->halfMoveNumber=fen.halfMoveNumber;
-	pos->data->castRights=fen.castRights;
-	if (fen.epSq!=SqInvalid && posIsEPCap(pos, fen.epSq))
-		pos->data->epSq=fen.epSq;
-	pos->data->key=posComputeKey(pos);
-
-	assert(posIsConsistent(pos));
+	posSetToFenData(pos, &fen);
 
 	return true;
 }
@@ -249,6 +211,139 @@ void posGetFEN(const Pos *pos, char string[static 128]) {
 	fenWrite(&fenData, string);
 }
 
+void posToPacked(const Pos *pos, PosPacked *packed) {
+	memset(packed, 0, sizeof(PosPacked));
+
+	CastRights castRights=posGetCastRights(pos);
+	Sq epPawnSq=(pos->data->epSq!=SqInvalid ? sqBackwardOne(pos->data->epSq, pos->stm) : SqInvalid);
+
+	BB occ=posGetBBAll(pos);
+	packed->occ=occ;
+	unsigned int i=0;
+	while(occ) {
+		Sq sq=bbScanReset(&occ);
+		Piece piece=posGetPieceOnSq(pos, sq);
+		Colour colour=pieceGetColour(piece);
+		unsigned int code;
+		switch(pieceGetType(piece)) {
+			case PieceTypePawn: code=(sq==epPawnSq ? PosPackedEPPawn : 0); break;
+			case PieceTypeKnight: code=1; break;
+			case PieceTypeBishopL: case PieceTypeBishopD: code=2; break;
+			case PieceTypeRook:
+				code=((sq==castRights.rookSq[colour][CastSideA] || sq==castRights.rookSq[colour][CastSideH]) ? PosPackedCastRook : 3);
+			break;
+			case PieceTypeQueen: code=4; break;
+			case PieceTypeKing: code=5; break;
+			default: assert(false); code=0; break;
+		}
+		if (code<=5)
+			code+=(colour==ColourBlack ? 6 : 0);
+		else if (code==PosPackedCastRook)
+			code+=colour;
+		packed->pieces[i/2]|=(code<<(4*(i%2)));
+		++i;
+	}
+	packed->stm=pos->stm;
+	packed->halfMoveNumber=utilMin(posGetHalfMoveNumber(pos), 255u);
+	packed->fullMoveNumber=utilMin(posGetFullMoveNumber(pos), 65535u);
+}
+
+bool posFromPacked(Pos *pos, const PosPacked *packed) {
+	if (bbPopCount(packed->occ)>32 || packed->stm>=ColourNB)
+		return false;
+
+	// Decode pieces, castling rooks and en-passent pawn.
+	Fen fen;
+	for(Sq sq=0;sq<SqNB;++sq)
+		fen.array[sq]=PieceNone;
+	fen.stm=packed->stm;
+	fen.castRights=CastRightsNone;
+	fen.epSq=SqInvalid;
+	fen.halfMoveNumber=packed->halfMoveNumber;
+	fen.fullMoveNumber=packed->fullMoveNumber;
+
+	const PieceType codeTypes[6]={PieceTypePawn, PieceTypeKnight, PieceTypeBishopL, PieceTypeRook, PieceTypeQueen, PieceTypeKing};
+	Sq castRookSqs[8], kingSqs[ColourNB]={SqInvalid, SqInvalid};
+	unsigned int castRookCount=0, i=0;
+	BB occ=packed->occ;
+	while(occ) {
+		Sq sq=bbScanReset(&occ);
+		unsigned int code=(packed->pieces[i/2]>>(4*(i%2)))&15;
+		++i;
+		Colour colour;
+		PieceType type;
+		if (code<12) {
+			colour=(code<6 ? ColourWhite : ColourBlack);
+			type=codeTypes[code%6];
+		} else if (code==PosPackedCastRook || code==PosPackedCastRook+1) {
+			colour=code-PosPackedCastRook;
+			type=PieceTypeRook;
+			if (castRookCount>=8 || sqRank(sq)!=(colour==ColourWhite ? Rank1 : Rank8))
+				return false;
+			castRookSqs[castRookCount++]=sq;
+		} else if (code==PosPackedEPPawn) {
+			colour=colourSwap(fen.stm);
+			type=PieceTypePawn;
+			if (fen.epSq!=SqInvalid || sqRank(sq)!=(colour==ColourWhite ? Rank4 : Rank5))
+				return false;
+			fen.epSq=sqBackwardOne(sq, colour);
+		} else
+			return false;
+
+		if (type==PieceTypeBishopL && !sqIsLight(sq))
+			type=PieceTypeBishopD;
+		if (type==PieceTypeKing) {
+			if (kingSqs[colour]!=SqInvalid)
+				return false;
+			kingSqs[colour]=sq;
+		}
+		if (type==PieceTypePawn && (sqRank(sq)==Rank1 || sqRank(sq)==Rank8))
+			return false;
+		fen.array[sq]=pieceMake(type, colour);
+	}
+	if (kingSqs[ColourWhite]==SqInvalid || kingSqs[ColourBlack]==SqInvalid)
+		return false;
+
+	// Castling side is given by which side of the king the rook is on.
+	for(unsigned int j=0;j<castRookCount;++j) {
+		Sq sq=castRookSqs[j];
+		Colour colour=(sqRank(sq)==Rank1 ? ColourWhite : ColourBlack);
+		if (sqRank(kingSqs[colour])!=sqRank(sq))
+			return false;
+		CastSide side=(sqFile(sq)<sqFile(kingSqs[colour]) ? CastSideA : CastSideH);
+		if (fen.castRights.rookSq[colour][side]!=SqInvalid)
+			return false;
+		fen.castRights.rookSq[colour][side]=sq;
+	}
+
+	posSetToFenData(pos, &fen);
+
+	return true;
+}
+
+void posSetToFenData(Pos *pos, const Fen *fen) {
+	// Set position to clean state.
+	posClean(pos);
+
+	// Set position to given FEN.
+	Sq sq;
+	for(sq=0;sq<SqNB;++sq)
+		if (fen->array[sq]!=PieceNone)
+			posPieceAdd(pos, fen->array[sq], sq, true);
+	pos->stm=fen->stm;
+	pos->fullMoveNumber=fen->fullMoveNumber;
+	pos->data->halfMoveNumber=fen->halfMoveNumber;
+	pos->data->castRights=fen->castRights;
+	if (fen->epSq!=SqInvalid && posGetPieceOnSq(pos, fen->epSq^8)==pieceMake(PieceTypePawn, colourSwap(pos->stm)))
+		pos->data->doublePushSq=fen->epSq;
+	if (fen->epSq!=SqInvalid && posIsEPCap(pos, fen->epSq))
+		pos->data->epSq=fen->epSq;
+	pos->data->key=posComputeKey(pos);
+	posUpdateCheckInfo(pos);
+
+	assert(posIsConsistent(pos));
+}
+
 void posDraw(const Pos *pos) {
 	// Header.
 	uciWrite("Position:\n");
@@ -284,7 +379,7 @@ void posDraw(const Pos *pos) {
 	char fen[128];
 	posGetFEN(pos, fen);
 	uciWrite("FEN string: %s\n", fen);
-	uciWrite("PST score: (%i,%i)\n", pos->pstScore.mg, pos->pstScore.eg);
+	uciWrite("PST score: (%i,%i)\n", evalVPackedMg(pos->pstScore), evalVPackedEg(pos->pstScore));
 }
 
 Colour posGetSTM(const Pos *pos) {
@@ -324,6 +419,10 @@ unsigned int posGetHalfMoveNumber(const Pos *pos) {
 	return pos->data->halfMoveNumber;
 }
 
+unsigned int posGetHistoryCount(const Pos *pos) {
+	return pos->data-pos->dataStart;
+}
+
 unsigned int posGetFullMoveNumber(const Pos *pos) {
 	return pos->fullMoveNumber;
 }
@@ -348,7 +447,11 @@ Sq posGetEPSq(const Pos *pos) {
 	return pos->data->epSq;
 }
 
-VPair posGetPstScore(const Pos *pos) {
+Sq posGetDoublePushSq(const Pos *pos) {
+	return pos->data->doublePushSq;
+}
+
+VPacked posGetPstScore(const Pos *pos) {
 	return pos->pstScore;
 }
 
@@ -359,6 +462,13 @@ bool posMakeMove(Pos *pos, Move move) {
 	if (!posCanMakeMove(pos, move))
 		return false;
 
+	return posMakeMoveUnchecked(pos, move);
+}
+
+bool posMakeMoveUnchecked(Pos *pos, Move move) {
+	assert(moveIsValid(move));
+	assert(posCanMakeMove(pos, move));
+
 	// Grab some move info now before we advance to next data entry.
 	bool isCastlingA=posMoveIsCastlingA(pos, move);
 	bool isCastlingH=posMoveIsCastlingH(pos, move);
@@ -367,17 +477,8 @@ bool posMakeMove(Pos *pos, Move move) {
 	Sq toSqTrue=posMoveGetToSqTrue(pos, move);
 
 	// Use next data entry.
-	if (pos->data+1>=pos->dataEnd) {
-		// We need more space.
-		size_t size=2*(pos->dataEnd-pos->dataStart);
-		PosData *ptr=realloc(pos->dataStart, size*sizeof(PosData));
-		if (ptr==NULL)
-			return false;
-		unsigned int dataOffset=pos->data-pos->dataStart;
-		pos->dataStart=ptr;
-		pos->dataEnd=ptr+size;
-		pos->data=ptr+dataOffset;
-	}
+	if (pos->data+1>=pos->dataStart+PosHistoryMax)
+		return false; // History full.
 	++pos->data;
 
 	// Update generic fields.
@@ -388,6 +489,7 @@ bool posMakeMove(Pos *pos, Move move) {
 	pos->data->lastMoveWasPromo=false;
 	pos->data->halfMoveNumber=(pos->data-1)->halfMoveNumber+1;
 	pos->data->epSq=SqInvalid;
+	pos->data->doublePushSq=SqInvalid;
 	pos->data->key=(pos->data-1)->key^posKeySTM^posKeyEP[(pos->data-1)->epSq];
 	pos->data->castRights=(pos->data-1)->castRights;
 	pos->data->capPiece=PieceNone;
@@ -454,6 +556,7 @@ bool posMakeMove(Pos *pos, Move move) {
 		// If double pawn move check set EP capture square (for next move).
 		if (abs(((int)sqRank(toSqRaw))-((int)sqRank(fromSq)))==2) {
 			Sq epSq=toSqRaw^8;
+			pos->data->doublePushSq=epSq;
 			if (posIsEPCap(pos, epSq)) {
 				pos->data->epSq=epSq;
 				pos->data->key^=posKeyEP[epSq];
@@ -494,6 +597,9 @@ bool posMakeMove(Pos *pos, Move move) {
 		pos->data->castRights.rookSq[nonMovingSide][CastSideH]=SqInvalid;
 	}
 
+	// Update check info.
+	posUpdateCheckInfo(pos);
+
 	assert(posIsConsistent(pos));
 
 	return true;
@@ -515,13 +621,31 @@ bool posCanMakeMove(const Pos *pos, Move move) {
 	BB fromBB=bbSq(fromSq);
 	BB toBB=bbSq(toSqTrue);
 	Sq kingSq=posGetKingSq(pos, stm);
+	bool isEP=(moveGetToPieceType(move)==PieceTypePawn && sqFile(fromSq)!=sqFile(toSqRaw) && posGetPieceOnSq(pos, toSqRaw)==PieceNone);
+
+	// Non-king moves (other than en-passent) can be decided using the check info alone.
+	if (fromSq!=kingSq && !isEP) {
+		BB checkers=posGetCheckers(pos);
+		if (checkers!=BBNone) {
+			// Double check? Only the king can move.
+			if ((checkers & (checkers-1))!=BBNone)
+				return false;
+
+			// Otherwise we must capture the checker or block.
+			if ((toBB & (checkers | bbBetween(kingSq, bbScanForward(checkers))))==BBNone)
+				return false;
+		}
+
+		// Pinned pieces can only move along the pin ray.
+		return ((fromBB & posGetPinned(pos, stm))==BBNone || (toBB & posPinRay(kingSq, fromSq))!=BBNone);
+	}
 
 	if (fromSq==kingSq)
 		kingSq=toSqTrue; // King move.
 	occ&=~fromBB; // Move piece.
 	occ|=toBB;
 	opp&=~toBB; // Potentially capture opp piece (so it cannot attack us later).
-	if (moveGetToPieceType(move)==PieceTypePawn && sqFile(fromSq)!=sqFile(toSqRaw) && posGetPieceOnSq(pos, toSqRaw)==PieceNone) {
+	if (isEP) {
 		// En-passent capture.
 		assert(pos->data->epSq==toSqRaw);
 		occ^=bbSq(toSqRaw^8);
@@ -626,17 +750,8 @@ bool posMakeNullMove(Pos *pos) {
 	assert(!posIsSTMInCheck(pos));
 
 	// Use next data entry.
-	if (pos->data+1>=pos->dataEnd) {
-		// We need more space.
-		size_t size=2*(pos->dataEnd-pos->dataStart);
-		PosData *ptr=realloc(pos->dataStart, size*sizeof(PosData));
-		if (ptr==NULL)
-			return false;
-		unsigned int dataOffset=pos->data-pos->dataStart;
-		pos->dataStart=ptr;
-		pos->dataEnd=ptr+size;
-		pos->data=ptr+dataOffset;
-	}
+	if (pos->data+1>=pos->dataStart+PosHistoryMax)
+		return false; // History full.
 	++pos->data;
 
 	// Update generic fields.
@@ -647,6 +762,7 @@ bool posMakeNullMove(Pos *pos) {
 	pos->data->lastMoveWasPromo=false;
 	pos->data->halfMoveNumber=(pos->data-1)->halfMoveNumber+1;
 	pos->data->epSq=SqInvalid;
+	pos->data->doublePushSq=SqInvalid;
 	pos->data->key=(pos->data-1)->key^posKeySTM^posKeyEP[(pos->data-1)->epSq];
 	pos->data->castRights=(pos->data-1)->castRights;
 	pos->data->capPiece=PieceNone;
@@ -654,6 +770,12 @@ bool posMakeNullMove(Pos *pos) {
 	pos->fullMoveNumber+=(movingSide==ColourBlack); // Inc after black's move.
 	pos->stm=nonMovingSide;
 
+	// Update check info (no pieces have moved so only the discoverers change).
+	pos->data->checkers=BBNone;
+	pos->data->pinned[ColourWhite]=(pos->data-1)->pinned[ColourWhite];
+	pos->data->pinned[ColourBlack]=(pos->data-1)->pinned[ColourBlack];
+	pos->data->discoverers=(posComputeBlockers(pos, movingSide) & posGetBBColour(pos, nonMovingSide));
+
 	assert(posIsConsistent(pos));
 
 	return true;
@@ -671,80 +793,83 @@ void posUndoNullMove(Pos *pos) {
 	--pos->data;
 }
 
-void posGenPseudoMoves(Moves *moves, MoveType type) {
+void posDiscardHistory(Pos *pos) {
+	// Repetition detection only looks back as far as the last capture or pawn move, so keep these entries (and the current one).
+	unsigned int keep=utilMin(posGetHalfMoveNumber(pos), posGetHistoryCount(pos))+1;
+	memmove(pos->dataStart, pos->data+1-keep, keep*sizeof(PosData));
+	pos->data=pos->dataStart+keep-1;
+}
+
+void posGenLegalMoves(Moves *moves, MoveType type) {
 	assert(type==MoveTypeQuiet || type==MoveTypeCapture || type==MoveTypeAny);
 
+	// In check? Only a handful of moves can be legal so use the dedicated generator.
+	const Pos *pos=movesGetPos(moves);
+	BB checkers=posGetCheckers(pos);
+	if (checkers!=BBNone) {
+		posGenLegalEvasions(moves, type, checkers);
+		return;
+	}
+
+	// Find pinned pieces once, so that destination sets can be masked and no illegal moves are produced.
+	Colour stm=posGetSTM(pos);
+	BB occ=posGetBBAll(pos);
+	BB pinned=posGetPinned(pos, stm);
+
 	// Standard moves (no pawns or castling).
-	BB occ=posGetBBAll(movesGetPos(moves));
 	BB allowed=BBNone;
 	if (type & MoveTypeQuiet)
 		allowed|=~occ;
 	if (type & MoveTypeCapture)
 		allowed|=occ;
-	posGenPseudoNormal(moves, allowed);
+	posGenLegalNormal(moves, allowed, pinned);
+	posGenLegalKing(moves, allowed);
 
 	// Pawns.
-	posGenPseudoPawnMoves(moves, type);
+	posGenLegalPawnMoves(moves, type, BBAll, pinned);
 
 	// Castling.
 	if (type & MoveTypeQuiet)
-		posGenPseudoCast(moves);
+		posGenLegalCast(moves);
 }
 
 Move posGenLegalMove(const Pos *pos, MoveType type) {
 	Moves moves;
-	movesInit(&moves, pos, 0, type);
+	movesInit(&moves, pos, NULL, 0, type);
 	Move move;
-	while((move=movesNext(&moves))!=MoveInvalid)
-		if (posCanMakeMove(pos, move))
-			return move;
+	while((move=movesNext(&moves))!=MoveInvalid) {
+		assert(posCanMakeMove(pos, move));
+		return move;
+	}
 	return MoveInvalid;
 }
 
 bool posIsSqAttackedByColour(const Pos *pos, Sq sq, Colour colour) {
-	assert(sqIsValid(sq));
-	assert(colourIsValid(colour));
-	BB occ=posGetBBAll(pos);
-
-	// Pawns.
-	if (bbForwardOne(bbWingify(posGetBBPiece(pos, pieceMake(PieceTypePawn, colour))), colour) & bbSq(sq))
-		return true;
-
-	// Knights.
-	if (attacksKnight(sq) & posGetBBPiece(pos, pieceMake(PieceTypeKnight, colour)))
-		return true;
-
-	// Bishops.
-	BB bishopSet=attacksBishop(sq, occ);
-	if (bishopSet & (posGetBBPiece(pos, pieceMake(PieceTypeBishopL, colour)) |
-	                 posGetBBPiece(pos, pieceMake(PieceTypeBishopD, colour))))
-		return true;
-
-	// Rooks.
-	BB rookSet=attacksRook(sq, occ);
-	if (rookSet & posGetBBPiece(pos, pieceMake(PieceTypeRook, colour)))
-		return true;
+	return posIsSqAttackedByColourOcc(pos, sq, colour, posGetBBAll(pos));
+}
 
-	// Queens.
-	if ((bishopSet | rookSet) & posGetBBPiece(pos, pieceMake(PieceTypeQueen, colour)))
-		return true;
+bool posIsSTMInCheck(const Pos *pos) {
+	return (pos->data->checkers!=BBNone);
+}
 
-	// King.
-	if (attacksKing(sq) & posGetBBPiece(pos, pieceMake(PieceTypeKing, colour)))
-		return true;
+BB posGetCheckers(const Pos *pos) {
+	return pos->data->checkers;
+}
 
-	return false;
+BB posGetPinned(const Pos *pos, Colour colour) {
+	assert(colourIsValid(colour));
+	return pos->data->pinned[colour];
 }
 
-bool posIsSTMInCheck(const Pos *pos) {
-	return posIsSqAttackedByColour(pos, posGetKingSq(pos, pos->stm), colourSwap(pos->stm));
+BB posGetDiscoverers(const Pos *pos) {
+	return pos->data->discoverers;
 }
 
 bool posIsDraw(const Pos *pos) {
 	// False positives are bad, false negatives are OK.
 
 	// Repetition (2-fold).
-	PosData *ptr, *endPtr=utilMax(pos->dataStart, pos->data-posGetHalfMoveNumber(pos));
+	const PosData *ptr, *endPtr=utilMax((const PosData *)pos->dataStart, pos->data-posGetHalfMoveNumber(pos));
 	for(ptr=pos->data-2;ptr>=endPtr;ptr-=2)
 		if (ptr->key==pos->data->key)
 			return true;
@@ -754,7 +879,7 @@ bool posIsDraw(const Pos *pos) {
 		return true;
 
 	// Insufficient material.
-	if (evalGetMatType(pos)==EvalMatTypeDraw)
+	if (evalComputeMatType(pos)==EvalMatTypeDraw)
 		return true;
 
 	return false;
@@ -884,7 +1009,7 @@ bool posMoveIsPseudoLegal(const Pos *pos, Move move) {
 	bool result=posMoveIsPseudoLegalInternal(pos, move);
 #	ifndef NDEBUG
 	Moves moves;
-	movesInit(&moves, pos, 0, MoveTypeAny);
+	movesInit(&moves, pos, NULL, 0, MoveTypeAny);
 	Move move2;
 	bool trueResult=false;
 	while((move2=movesNext(&moves))!=MoveInvalid)
@@ -892,7 +1017,7 @@ bool posMoveIsPseudoLegal(const Pos *pos, Move move) {
 			trueResult=true;
 			break;
 		}
-	assert(result==trueResult);
+	assert((result && posCanMakeMove(pos, move))==trueResult); // Generator only produces legal moves.
 #	endif
 	return result;
 }
@@ -950,7 +1075,7 @@ bool posMoveIsCastlingH(const Pos *pos, Move move) {
 
 Move posMoveFromStr(const Pos *pos, const char str[static 6]){
 	Moves moves;
-	movesInit(&moves, pos, 0, MoveTypeAny);
+	movesInit(&moves, pos, NULL, 0, MoveTypeAny);
 	Move move;
 	while((move=movesNext(&moves))!=MoveInvalid)
 		if (strcmp(str, POSMOVETOSTR(pos, move))==0)
@@ -988,6 +1113,133 @@ void posMoveToStr(const Pos *pos, Move move, char str[static 6]) {
 	str[5]='\0';
 }
 
+Move posMoveFromSan(const Pos *pos, const char *str) {
+	// Normalise given string.
+	char san[16];
+	posSanNormalise(str, san, sizeof(san));
+	size_t len=strlen(san);
+
+	// Castling.
+	bool castA=utilStrEqual(san, "O-O-O"), castH=utilStrEqual(san, "O-O");
+	if (castA || castH) {
+		Moves moves;
+		movesInitBulk(&moves, pos);
+		Move move;
+		while((move=movesNext(&moves))!=MoveInvalid)
+			if ((castA && posMoveIsCastlingA(pos, move)) || (castH && posMoveIsCastlingH(pos, move)))
+				return move;
+		return MoveInvalid;
+	}
+
+	// Split into piece, from file/rank (either, both or neither), to square and promotion piece. Captures are implied.
+	char pieceChar='P', promoChar='\0';
+	const char *c=san;
+	if (*c!='\0' && strchr("NBRQK", *c)!=NULL)
+		pieceChar=*c++;
+	if (len>2 && strchr("NBRQnbrq", san[len-1])!=NULL && pieceChar=='P')
+		promoChar=toupper(san[--len]);
+	if (len<2 || san[len-2]<'a' || san[len-2]>'h' || san[len-1]<'1' || san[len-1]>'8')
+		return MoveInvalid;
+	Sq toSq=sqMake(fileFromChar(san[len-2]), rankFromChar(san[len-1]));
+	File fromFile=FileNB;
+	Rank fromRank=RankNB;
+	for(;c<san+len-2;++c)
+		if (*c>='a' && *c<='h')
+			fromFile=fileFromChar(*c);
+		else if (*c>='1' && *c<='8')
+			fromRank=rankFromChar(*c);
+		else if (*c!='x')
+			return MoveInvalid;
+
+	// Find unique matching legal move.
+	Move match=MoveInvalid;
+	Moves moves;
+	movesInitBulk(&moves, pos);
+	Move move;
+	while((move=movesNext(&moves))!=MoveInvalid) {
+		Sq fromSq=moveGetFromSq(move);
+		if (posMoveIsCastling(pos, move) || moveGetToSqRaw(move)!=toSq ||
+		    toupper(pieceToChar(posGetPieceOnSq(pos, fromSq)))!=pieceChar ||
+		    (fromFile!=FileNB && sqFile(fromSq)!=fromFile) || (fromRank!=RankNB && sqRank(fromSq)!=fromRank))
+			continue;
+		bool isPromo=posMoveIsPromotion(pos, move);
+		if (isPromo!=(promoChar!='\0') || (isPromo && toupper(pieceTypeToPromoChar(pieceGetType(moveGetToPiece(move))))!=promoChar))
+			continue;
+		if (match!=MoveInvalid)
+			return MoveInvalid; // Ambiguous.
+		match=move;
+	}
+
+	return match;
+}
+
+void posMoveToSan(Pos *pos, Move move, char str[static 8]) {
+	// Special case for invalid moves.
+	if (!moveIsValid(move)) {
+		strcpy(str, "--");
+		return;
+	}
+
+	// Sanity checks.
+	assert(posGetSTM(pos)==moveGetColour(move));
+
+	char *c=str;
+	Sq fromSq=moveGetFromSq(move);
+	Sq toSq=posMoveGetToSqTrue(pos, move);
+	Piece fromPiece=posGetPieceOnSq(pos, fromSq);
+	if (posMoveIsCastling(pos, move))
+		c+=sprintf(c, (posMoveIsCastlingA(pos, move) ? "O-O-O" : "O-O"));
+	else if (pieceGetType(fromPiece)==PieceTypePawn) {
+		// Pawn moves: captures (including en-passent) give the from file, promotions the new piece.
+		if (sqFile(fromSq)!=sqFile(toSq)) {
+			*c++=fileToChar(sqFile(fromSq));
+			*c++='x';
+		}
+		*c++=fileToChar(sqFile(toSq));
+		*c++=rankToChar(sqRank(toSq));
+		if (posMoveIsPromotion(pos, move)) {
+			*c++='=';
+			*c++=toupper(pieceTypeToPromoChar(pieceGetType(moveGetToPiece(move))));
+		}
+	} else {
+		// Piece moves: disambiguate by file, then rank, then both, if another piece of the same type can also legally reach toSq.
+		char pieceChar=toupper(pieceToChar(fromPiece));
+		bool ambiguous=false, sameFile=false, sameRank=false;
+		Moves moves;
+		movesInitBulk(&moves, pos);
+		Move other;
+		while((other=movesNext(&moves))!=MoveInvalid) {
+			Sq otherFromSq=moveGetFromSq(other);
+			if (otherFromSq==fromSq || posMoveGetToSqTrue(pos, other)!=toSq || toupper(pieceToChar(posGetPieceOnSq(pos, otherFromSq)))!=pieceChar)
+				continue;
+			ambiguous=true;
+			sameFile|=(sqFile(otherFromSq)==sqFile(fromSq));
+			sameRank|=(sqRank(otherFromSq)==sqRank(fromSq));
+		}
+
+		*c++=pieceChar;
+		if (ambiguous && (!sameFile || sameRank))
+			*c++=fileToChar(sqFile(fromSq));
+		if (ambiguous && sameFile)
+			*c++=rankToChar(sqRank(fromSq));
+		if (posGetPieceOnSq(pos, toSq)!=PieceNone)
+			*c++='x';
+		*c++=fileToChar(sqFile(toSq));
+		*c++=rankToChar(sqRank(toSq));
+	}
+
+	// Check or mate? The move is only made (and undone) when it gives check, to look for a reply.
+	if (posMoveGivesCheck(pos, move)) {
+		bool mate=false;
+		if (posMakeMoveUnchecked(pos, move)) {
+			mate=!posLegalMoveExists(pos, MoveTypeAny);
+			posUndoMove(pos);
+		}
+		*c++=(mate ? '#' : '+');
+	}
+	*c='\0';
+}
+
 Sq posMoveGetToSqTrue(const Pos *pos, Move move) {
 	if (posMoveIsCastling(pos, move)) {
 		File file=(moveGetToSqRaw(move)<moveGetFromSq(move) ? FileC : FileG);
@@ -1060,6 +1312,26 @@ CastRights posCastRightsFromStr(const char *str, const Piece pieceArray[SqNB]) {
 
 				CastSide castSide=(rookSq<kingSq[ColourBlack] ? CastSideA : CastSideH);
 				castRights.rookSq[ColourBlack][castSide]=rookSq;
+			} else if (*c=='K' || *c=='Q' || *c=='k' || *c=='q') {
+				// X-FEN - use outermost rook on the given side of the king.
+				Colour colour=(isupper(*c) ? ColourWhite : ColourBlack);
+				CastSide castSide=(toupper(*c)=='Q' ? CastSideA : CastSideH);
+				if (kingSq[colour]==SqInvalid || sqRank(kingSq[colour])!=(colour==ColourWhite ? Rank1 : Rank8))
+					continue;
+				Rank rank=(colour==ColourWhite ? Rank1 : Rank8);
+				Piece rook=pieceMake(PieceTypeRook, colour);
+				File file;
+				if (castSide==CastSideA) {
+					for(file=FileA; file<sqFile(kingSq[colour]); ++file)
+						if (pieceArray[sqMake(file, rank)]==rook)
+							break;
+				} else {
+					for(file=FileH; file>sqFile(kingSq[colour]); --file)
+						if (pieceArray[sqMake(file, rank)]==rook)
+							break;
+				}
+				if (file!=sqFile(kingSq[colour]))
+					castRights.rookSq[colour][castSide]=sqMake(file, rank);
 			} else
 				return castRights;
 		}
@@ -1093,6 +1365,8 @@ void posMirror(Pos *pos) {
 	// Mirror other fields.
 	if (pos->data->epSq!=SqInvalid)
 		pos->data->epSq=sqMirror(pos->data->epSq);
+	if (pos->data->doublePushSq!=SqInvalid)
+		pos->data->doublePushSq=sqMirror(pos->data->doublePushSq);
 	if (pos->data->capSq!=SqInvalid)
 		pos->data->capSq=sqMirror(pos->data->capSq);
 
@@ -1106,6 +1380,9 @@ void posMirror(Pos *pos) {
 	pos->data->key=posComputeKey(pos);
 	pos->pawnKey=posComputePawnKey(pos);
 	pos->matKey=posComputeMatKey(pos);
+
+	// Update check info.
+	posUpdateCheckInfo(pos);
 }
 
 void posFlip(Pos *pos) {
@@ -1131,6 +1408,8 @@ void posFlip(Pos *pos) {
 	pos->stm=colourSwap(pos->stm);
 	if (pos->data->epSq!=SqInvalid)
 		pos->data->epSq=sqMirror(pos->data->epSq);
+	if (pos->data->doublePushSq!=SqInvalid)
+		pos->data->doublePushSq=sqMirror(pos->data->doublePushSq);
 	if (pos->data->capSq!=SqInvalid)
 		pos->data->capSq=sqMirror(pos->data->capSq);
 
@@ -1144,6 +1423,9 @@ void posFlip(Pos *pos) {
 	pos->data->key=posComputeKey(pos);
 	pos->pawnKey=posComputePawnKey(pos);
 	pos->matKey=posComputeMatKey(pos);
+
+	// Update check info.
+	posUpdateCheckInfo(pos);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1158,12 +1440,13 @@ void posClean(Pos *pos) {
 	pos->fullMoveNumber=1;
 	pos->pawnKey=0;
 	pos->matKey=0;
-	pos->pstScore=VPairZero;
+	pos->pstScore=VPackedZero;
 	pos->data=pos->dataStart;
 	pos->data->lastMove=MoveInvalid;
 	pos->data->lastMoveWasPromo=false;
 	pos->data->halfMoveNumber=0;
 	pos->data->epSq=SqInvalid;
+	pos->data->doublePushSq=SqInvalid;
 	pos->data->castRights=CastRightsNone;
 	pos->data->capPiece=PieceNone;
 	pos->data->capSq=SqInvalid;
@@ -1189,7 +1472,7 @@ void posPieceAdd(Pos *pos, Piece piece, Sq sq, bool skipMainKeyUpdate) {
 	pos->matKey+=posMatKey[piece];
 
 	// Update PST score.
-	evalVPairAddTo(&pos->pstScore, &evalPST[piece][sq]);
+	pos->pstScore+=evalTables.pst[piece][sq];
 }
 
 void posPieceRemove(Pos *pos, Sq sq, bool skipMainKeyUpdate) {
@@ -1211,7 +1494,7 @@ void posPieceRemove(Pos *pos, Sq sq, bool skipMainKeyUpdate) {
 	pos->matKey-=posMatKey[piece];
 
 	// Update PST score.
-	evalVPairSubFrom(&pos->pstScore, &evalPST[piece][sq]);
+	pos->pstScore-=evalTables.pst[piece][sq];
 }
 
 void posPieceMove(Pos *pos, Sq fromSq, Sq toSq, bool skipMainKeyUpdate) {
@@ -1235,8 +1518,7 @@ void posPieceMove(Pos *pos, Sq fromSq, Sq toSq, bool skipMainKeyUpdate) {
 	pos->pawnKey^=posPawnKeyPiece[piece][fromSq]^posPawnKeyPiece[piece][toSq];
 
 	// Update PST score.
-	evalVPairSubFrom(&pos->pstScore, &evalPST[piece][fromSq]);
-	evalVPairAddTo(&pos->pstScore, &evalPST[piece][toSq]);
+	pos->pstScore+=evalTables.pst[piece][toSq]-evalTables.pst[piece][fromSq];
 }
 
 void posPieceMoveChange(Pos *pos, Sq fromSq, Sq toSq, Piece toPiece, bool skipMainKeyUpdate) {
@@ -1253,23 +1535,26 @@ void posPieceMoveChange(Pos *pos, Sq fromSq, Sq toSq, Piece toPiece, bool skipMa
 	posPieceAdd(pos, toPiece, toSq, skipMainKeyUpdate);
 }
 
-void posGenPseudoNormal(Moves *moves, BB allowed) {
+void posGenLegalNormal(Moves *moves, BB allowed, BB pinned) {
 	// Init.
 #	define PUSH(m) movesPush(moves, (m))
 	const Pos *pos=movesGetPos(moves);
 	Colour stm=posGetSTM(pos);
 	allowed&=~posGetBBColour(pos, stm); // Don't want to self-capture.
 	BB occ=posGetBBAll(pos);
+	Sq kingSq=posGetKingSq(pos, stm);
 
-	// Loop over each piece type.
+	// Loop over each piece type (except the king).
 	PieceType type;
-	for(type=PieceTypeKnight;type<=PieceTypeKing;++type) {
+	for(type=PieceTypeKnight;type<PieceTypeKing;++type) {
 		// Loop over each piece of this type.
 		Piece piece=pieceMake(type, stm);
 		BB pieceSet=posGetBBPiece(pos, piece);
 		while(pieceSet) {
 			Sq fromSq=bbScanReset(&pieceSet);
 			BB moveSet=(attacksPiece(piece, fromSq, occ) & allowed);
+			if (pinned & bbSq(fromSq))
+				moveSet&=posPinRay(kingSq, fromSq);
 			while(moveSet)
 				PUSH(moveMake(fromSq, bbScanReset(&moveSet), piece));
 		}
@@ -1277,10 +1562,75 @@ void posGenPseudoNormal(Moves *moves, BB allowed) {
 #	undef PUSH
 }
 
-void posGenPseudoPawnMoves(Moves *moves, MoveType type) {
+void posGenLegalKing(Moves *moves, BB allowed) {
+	// King cannot move to an attacked square, including those currently 'behind' it.
+#	define PUSH(m) movesPush(moves, (m))
+	const Pos *pos=movesGetPos(moves);
+	Colour stm=posGetSTM(pos);
+	Sq kingSq=posGetKingSq(pos, stm);
+	Piece piece=pieceMake(PieceTypeKing, stm);
+	BB moveSet=(attacksKing(kingSq) & allowed & ~posGetBBColour(pos, stm));
+	BB kinglessOcc=(posGetBBAll(pos) & ~bbSq(kingSq));
+	while(moveSet) {
+		Sq toSq=bbScanReset(&moveSet);
+		if (!posIsSqAttackedByColourOcc(pos, toSq, colourSwap(stm), kinglessOcc))
+			PUSH(moveMake(kingSq, toSq, piece));
+	}
+#	undef PUSH
+}
+
+void posGenLegalEvasions(Moves *moves, MoveType type, BB checkers) {
+	assert(checkers!=BBNone);
+#	define PUSH(m) movesPush(moves, (m))
+	const Pos *pos=movesGetPos(moves);
+	Colour stm=posGetSTM(pos);
+	BB occ=posGetBBAll(pos);
+
+	// King moves.
+	BB allowed=BBNone;
+	if (type & MoveTypeQuiet)
+		allowed|=~occ;
+	if (type & MoveTypeCapture)
+		allowed|=occ;
+	posGenLegalKing(moves, allowed);
+
+	// Double check? Only the king can move.
+	if ((checkers & (checkers-1))!=BBNone)
+		return;
+
+	// Otherwise the checker must be captured or the check blocked. Rather than
+	// generating every move and masking, work backwards from each target square
+	// to find the pieces which can reach it. Pinned pieces can never help.
+	Sq kingSq=posGetKingSq(pos, stm);
+	BB target=(checkers | bbBetween(kingSq, bbScanForward(checkers)));
+	BB pinned=posGetPinned(pos, stm);
+	BB queens=posGetBBPiece(pos, pieceMake(PieceTypeQueen, stm));
+	BB knights=posGetBBPiece(pos, pieceMake(PieceTypeKnight, stm));
+	BB bishops=(posGetBBPiece(pos, pieceMake(PieceTypeBishopL, stm)) | posGetBBPiece(pos, pieceMake(PieceTypeBishopD, stm)) | queens);
+	BB rooks=(posGetBBPiece(pos, pieceMake(PieceTypeRook, stm)) | queens);
+	BB toSet=(target & allowed);
+	while(toSet) {
+		Sq toSq=bbScanReset(&toSet);
+		BB fromSet=(((attacksKnight(toSq) & knights) | (attacksBishop(toSq, occ) & bishops) | (attacksRook(toSq, occ) & rooks)) & ~pinned);
+		while(fromSet) {
+			Sq fromSq=bbScanReset(&fromSet);
+			PUSH(moveMake(fromSq, toSq, posGetPieceOnSq(pos, fromSq)));
+		}
+	}
+
+	// Pawns (including en-passent capture of a checking pawn).
+	posGenLegalPawnMoves(moves, type, target, pinned);
+#	undef PUSH
+}
+
+void posGenLegalPawnMoves(Moves *moves, MoveType type, BB target, BB pinned) {
+	// Destinations are masked by target, pinned pawns are checked individually
+	// against their pin ray and en-passent captures are tested in full.
+#	define LEGAL(f,t) (!(pinned & bbSq(f)) || (posPinRay(kingSq, (f)) & bbSq(t)))
 #	define PUSH(m) movesPush(moves, (m))
 	const Pos *pos=movesGetPos(moves);
 	Colour stm=posGetSTM(pos);
+	Sq kingSq=posGetKingSq(pos, stm);
 	BB opp=posGetBBColour(pos, colourSwap(stm));
 	BB empty=~posGetBBAll(pos);
 	Piece piece=pieceMake(PieceTypePawn, stm);
@@ -1292,10 +1642,12 @@ void posGenPseudoPawnMoves(Moves *moves, MoveType type) {
 		BB set, set2;
 
 		// Forward promotions.
-		set=(forwardPawns & empty & backRanks);
+		set=(forwardPawns & empty & backRanks & target);
 		while(set) {
 			Sq toSq=bbScanReset(&set);
 			Sq fromSq=sqBackwardOne(toSq, stm);
+			if (!LEGAL(fromSq, toSq))
+				continue;
 			PUSH(moveMake(fromSq, toSq, pieceMake(PieceTypeQueen, stm)));
 			PUSH(moveMake(fromSq, toSq, pieceMake(PieceTypeRook, stm)));
 			PUSH(moveMake(fromSq, toSq, pieceMake(sqIsLight(toSq) ? PieceTypeBishopL : PieceTypeBishopD, stm)));
@@ -1303,12 +1655,14 @@ void posGenPseudoPawnMoves(Moves *moves, MoveType type) {
 		}
 
 		// Capture left.
-		set=bbWestOne(forwardPawns) & opp;
+		set=(bbWestOne(forwardPawns) & opp & target);
 		set2=(set & backRanks);
 		set&=~backRanks;
 		while(set2) {
 			Sq toSq=bbScanReset(&set2);
 			Sq fromSq=sqEastOne(sqBackwardOne(toSq, stm));
+			if (!LEGAL(fromSq, toSq))
+				continue;
 			PUSH(moveMake(fromSq, toSq, pieceMake(PieceTypeQueen, stm)));
 			PUSH(moveMake(fromSq, toSq, pieceMake(PieceTypeRook, stm)));
 			PUSH(moveMake(fromSq, toSq, pieceMake(sqIsLight(toSq) ? PieceTypeBishopL : PieceTypeBishopD, stm)));
@@ -1317,16 +1671,19 @@ void posGenPseudoPawnMoves(Moves *moves, MoveType type) {
 		while(set) {
 			Sq toSq=bbScanReset(&set);
 			Sq fromSq=sqEastOne(sqBackwardOne(toSq, stm));
-			PUSH(moveMake(fromSq, toSq, piece));
+			if (LEGAL(fromSq, toSq))
+				PUSH(moveMake(fromSq, toSq, piece));
 		}
 
 		// Capture right.
-		set=bbEastOne(forwardPawns) & opp;
+		set=(bbEastOne(forwardPawns) & opp & target);
 		set2=(set & backRanks);
 		set&=~backRanks;
 		while(set2) {
 			Sq toSq=bbScanReset(&set2);
 			Sq fromSq=sqWestOne(sqBackwardOne(toSq, stm));
+			if (!LEGAL(fromSq, toSq))
+				continue;
 			PUSH(moveMake(fromSq, toSq, pieceMake(PieceTypeQueen, stm)));
 			PUSH(moveMake(fromSq, toSq, pieceMake(PieceTypeRook, stm)));
 			PUSH(moveMake(fromSq, toSq, pieceMake(sqIsLight(toSq) ? PieceTypeBishopL : PieceTypeBishopD, stm)));
@@ -1335,7 +1692,8 @@ void posGenPseudoPawnMoves(Moves *moves, MoveType type) {
 		while(set) {
 			Sq toSq=bbScanReset(&set);
 			Sq fromSq=sqWestOne(sqBackwardOne(toSq, stm));
-			PUSH(moveMake(fromSq, toSq, piece));
+			if (LEGAL(fromSq, toSq))
+				PUSH(moveMake(fromSq, toSq, piece));
 		}
 
 		// En-passent captures.
@@ -1343,11 +1701,13 @@ void posGenPseudoPawnMoves(Moves *moves, MoveType type) {
 			Sq toSq=pos->data->epSq, fromSq;
 
 			// Left capture.
-			if (sqFile(pos->data->epSq)!=FileH && posGetPieceOnSq(pos, fromSq=sqEastOne(sqBackwardOne(toSq, stm)))==piece)
+			if (sqFile(pos->data->epSq)!=FileH && posGetPieceOnSq(pos, fromSq=sqEastOne(sqBackwardOne(toSq, stm)))==piece &&
+			    posCanMakeMove(pos, moveMake(fromSq, toSq, piece)))
 				PUSH(moveMake(fromSq, toSq, piece));
 
 			// Right capture.
-			if (sqFile(pos->data->epSq)!=FileA && posGetPieceOnSq(pos, fromSq=sqWestOne(sqBackwardOne(toSq, stm)))==piece)
+			if (sqFile(pos->data->epSq)!=FileA && posGetPieceOnSq(pos, fromSq=sqWestOne(sqBackwardOne(toSq, stm)))==piece &&
+			    posCanMakeMove(pos, moveMake(fromSq, toSq, piece)))
 				PUSH(moveMake(fromSq, toSq, piece));
 		}
 	}
@@ -1358,22 +1718,28 @@ void posGenPseudoPawnMoves(Moves *moves, MoveType type) {
 		BB one=(forwardPawns & allowed);
 		BB two=(bbForwardOne(one, stm) & allowed & (stm==ColourWhite ? bbRank(Rank4) : bbRank(Rank5)));
 
+		one&=target;
+		two&=target;
+
 		// Standard move forward.
 		while(one) {
 			Sq toSq=bbScanReset(&one);
-			PUSH(moveMake(toSq-delta, toSq, piece));
+			if (LEGAL(toSq-delta, toSq))
+				PUSH(moveMake(toSq-delta, toSq, piece));
 		}
 
 		// Double first move.
 		while(two) {
 			Sq toSq=bbScanReset(&two);
-			PUSH(moveMake(toSq-delta-delta, toSq, piece));
+			if (LEGAL(toSq-delta-delta, toSq))
+				PUSH(moveMake(toSq-delta-delta, toSq, piece));
 		}
 	}
 #	undef PUSH
+#	undef LEGAL
 }
 
-void posGenPseudoCast(Moves *moves) {
+void posGenLegalCast(Moves *moves) {
 #	define PUSH(m) movesPush(moves, (m))
 
 	const Pos *pos=movesGetPos(moves);
@@ -1394,14 +1760,98 @@ void posGenPseudoCast(Moves *moves) {
 			BB kingSpan=bbBetween(kingFromSq, kingToSq)|bbSq(kingToSq);
 			BB rookSpan=bbBetween(rookFromSq, rookToSq)|bbSq(rookToSq);
 
-			if (!(((kingSpan | rookSpan) & ~(bbSq(rookFromSq)|bbSq(kingFromSq)))&posGetBBAll(pos)))
-				PUSH(moveMake(kingFromSq, rookFromSq, pieceMake(PieceTypeKing, stm)));
+			Move move=moveMake(kingFromSq, rookFromSq, pieceMake(PieceTypeKing, stm));
+			if (!(((kingSpan | rookSpan) & ~(bbSq(rookFromSq)|bbSq(kingFromSq)))&posGetBBAll(pos)) && posCanMakeMove(pos, move))
+				PUSH(move);
 		}
 	}
 
 #	undef PUSH
 }
 
+void posUpdateCheckInfo(Pos *pos) {
+	Colour stm=posGetSTM(pos);
+	Colour xstm=colourSwap(stm);
+	BB blockersStm=posComputeBlockers(pos, stm), blockersXstm=posComputeBlockers(pos, xstm);
+	pos->data->checkers=posComputeCheckers(pos);
+	pos->data->pinned[stm]=(blockersStm & posGetBBColour(pos, stm));
+	pos->data->pinned[xstm]=(blockersXstm & posGetBBColour(pos, xstm));
+	pos->data->discoverers=(blockersXstm & posGetBBColour(pos, stm));
+}
+
+BB posComputeCheckers(const Pos *pos) {
+	Colour stm=posGetSTM(pos);
+	Colour xstm=colourSwap(stm);
+	Sq kingSq=posGetKingSq(pos, stm);
+	BB occ=posGetBBAll(pos);
+	BB queens=posGetBBPiece(pos, pieceMake(PieceTypeQueen, xstm));
+	BB bishops=(posGetBBPiece(pos, pieceMake(PieceTypeBishopL, xstm)) | posGetBBPiece(pos, pieceMake(PieceTypeBishopD, xstm)) | queens);
+	BB rooks=(posGetBBPiece(pos, pieceMake(PieceTypeRook, xstm)) | queens);
+	return ((attacksPawn(kingSq, stm) & posGetBBPiece(pos, pieceMake(PieceTypePawn, xstm))) |
+	        (attacksKnight(kingSq) & posGetBBPiece(pos, pieceMake(PieceTypeKnight, xstm))) |
+	        (attacksBishop(kingSq, occ) & bishops) |
+	        (attacksRook(kingSq, occ) & rooks));
+}
+
+BB posComputeBlockers(const Pos *pos, Colour colour) {
+	Colour xcolour=colourSwap(colour);
+	Sq kingSq=posGetKingSq(pos, colour);
+	BB occ=posGetBBAll(pos);
+	BB queens=posGetBBPiece(pos, pieceMake(PieceTypeQueen, xcolour));
+	BB bishops=(posGetBBPiece(pos, pieceMake(PieceTypeBishopL, xcolour)) | posGetBBPiece(pos, pieceMake(PieceTypeBishopD, xcolour)) | queens);
+	BB rooks=(posGetBBPiece(pos, pieceMake(PieceTypeRook, xcolour)) | queens);
+
+	// Look for enemy sliders which would attack the king if there was exactly one piece in the way.
+	BB pinners=((attacksBishop(kingSq, BBNone) & bishops) | (attacksRook(kingSq, BBNone) & rooks));
+	BB blockers=BBNone;
+	while(pinners) {
+		Sq sq=bbScanReset(&pinners);
+		BB between=(bbBetween(kingSq, sq) & occ);
+		if (between!=BBNone && (between & (between-1))==BBNone)
+			blockers|=between;
+	}
+
+	return blockers;
+}
+
+BB posPinRay(Sq kingSq, Sq pinnedSq) {
+	return (bbBetween(kingSq, pinnedSq) | bbBeyond(kingSq, pinnedSq));
+}
+
+bool posIsSqAttackedByColourOcc(const Pos *pos, Sq sq, Colour colour, BB occ) {
+	assert(sqIsValid(sq));
+	assert(colourIsValid(colour));
+
+	// Pawns.
+	if (bbForwardOne(bbWingify(posGetBBPiece(pos, pieceMake(PieceTypePawn, colour))), colour) & bbSq(sq))
+		return true;
+
+	// Knights.
+	if (attacksKnight(sq) & posGetBBPiece(pos, pieceMake(PieceTypeKnight, colour)))
+		return true;
+
+	// Bishops.
+	BB bishopSet=attacksBishop(sq, occ);
+	if (bishopSet & (posGetBBPiece(pos, pieceMake(PieceTypeBishopL, colour)) |
+	                 posGetBBPiece(pos, pieceMake(PieceTypeBishopD, colour))))
+		return true;
+
+	// Rooks.
+	BB rookSet=attacksRook(sq, occ);
+	if (rookSet & posGetBBPiece(pos, pieceMake(PieceTypeRook, colour)))
+		return true;
+
+	// Queens.
+	if ((bishopSet | rookSet) & posGetBBPiece(pos, pieceMake(PieceTypeQueen, colour)))
+		return true;
+
+	// King.
+	if (attacksKing(sq) & posGetBBPiece(pos, pieceMake(PieceTypeKing, colour)))
+		return true;
+
+	return false;
+}
+
 Key posComputeKey(const Pos *pos) {
 	// En-passent square and castling rights.
 	Key key=posKeyEP[pos->data->epSq]^posKeyCastling[pos->data->castRights.rookSq[ColourWhite][CastSideA]]
@@ -1587,6 +2037,23 @@ bool posIsConsistent(const Pos *pos) {
 		goto Error;
 	}
 
+	// Test check info matches.
+	Colour stm=posGetSTM(pos);
+	if (pos->data->checkers!=posComputeCheckers(pos)) {
+		sprintf(error, "Current checkers are %016"PRIx64" while true checkers are %016"PRIx64".\n",
+						pos->data->checkers, posComputeCheckers(pos));
+		goto Error;
+	}
+	if (pos->data->pinned[stm]!=(posComputeBlockers(pos, stm) & posGetBBColour(pos, stm)) ||
+	    pos->data->pinned[colourSwap(stm)]!=(posComputeBlockers(pos, colourSwap(stm)) & posGetBBColour(pos, colourSwap(stm)))) {
+		strcpy(error, "Pinned pieces do not match.\n");
+		goto Error;
+	}
+	if (pos->data->discoverers!=(posComputeBlockers(pos, colourSwap(stm)) & posGetBBColour(pos, stm))) {
+		strcpy(error, "Discovered check candidates do not match.\n");
+		goto Error;
+	}
+
 	// Test pawn hash keys match.
 	Key truePawnKey=posComputePawnKey(pos);
 	Key pawnKey=posGetPawnKey(pos);
@@ -1606,10 +2073,10 @@ bool posIsConsistent(const Pos *pos) {
 	}
 
 	// Test PST score is accurate.
-	VPair truePstScore=evalComputePstScore(pos);
-	if (pos->pstScore.mg!=truePstScore.mg || pos->pstScore.eg!=truePstScore.eg) {
+	VPacked truePstScore=evalComputePstScore(pos);
+	if (pos->pstScore!=truePstScore) {
 		sprintf(error, "Current pst score is (%i,%i) while true is (%i,%i).\n",
-						pos->pstScore.mg, pos->pstScore.eg, truePstScore.mg, truePstScore.eg);
+						evalVPackedMg(pos->pstScore), evalVPackedEg(pos->pstScore), evalVPackedMg(truePstScore), evalVPackedEg(truePstScore));
 		goto Error;
 	}
 
@@ -1757,3 +2224,48 @@ bool posLegalMoveExistsPiece(const Pos *pos, PieceType type, BB allowed) {
 	}
 	return false;
 }
+
+bool posMoveGivesCheck(const Pos *pos, Move move) {
+	Colour stm=posGetSTM(pos);
+	Sq kingSq=posGetKingSq(pos, colourSwap(stm));
+	Sq fromSq=moveGetFromSq(move);
+	Sq toSq=posMoveGetToSqTrue(pos, move);
+
+	// Castling and en-passent captures also move or remove a second piece, so test every slider against the resulting occupancy.
+	bool isEP=(pieceGetType(posGetPieceOnSq(pos, fromSq))==PieceTypePawn && sqFile(fromSq)!=sqFile(toSq) && posGetPieceOnSq(pos, toSq)==PieceNone);
+	if (isEP || posMoveIsCastling(pos, move)) {
+		BB queens=posGetBBPiece(pos, pieceMake(PieceTypeQueen, stm));
+		BB bishops=(posGetBBPiece(pos, pieceMake(PieceTypeBishopL, stm)) | posGetBBPiece(pos, pieceMake(PieceTypeBishopD, stm)) | queens);
+		BB rooks=(posGetBBPiece(pos, pieceMake(PieceTypeRook, stm)) | queens);
+		BB occ=((posGetBBAll(pos) ^ bbSq(fromSq)) | bbSq(toSq));
+		if (isEP) {
+			if (attacksPawn(toSq, stm) & bbSq(kingSq))
+				return true;
+			occ^=bbSq(toSq^8);
+		} else {
+			Sq rookFromSq=moveGetToSqRaw(move);
+			Sq rookToSq=sqMake((posMoveIsCastlingA(pos, move) ? FileD : FileF), sqRank(fromSq));
+			occ=(((occ & ~bbSq(rookFromSq)) | bbSq(rookToSq)) | bbSq(toSq));
+			rooks=((rooks ^ bbSq(rookFromSq)) | bbSq(rookToSq));
+		}
+		return (((attacksBishop(kingSq, occ) & bishops) | (attacksRook(kingSq, occ) & rooks))!=BBNone);
+	}
+
+	// Discovered check (moving off the line between one of our sliders and the enemy king)?
+	if ((posGetDiscoverers(pos) & bbSq(fromSq))!=BBNone && (posPinRay(kingSq, fromSq) & bbSq(toSq))==BBNone)
+		return true;
+
+	// Direct check from the moved (or promoted) piece?
+	BB occ=((posGetBBAll(pos) ^ bbSq(fromSq)) | bbSq(toSq));
+	return ((attacksPiece(moveGetToPiece(move), toSq, occ) & bbSq(kingSq))!=BBNone);
+}
+
+void posSanNormalise(const char *str, char *out, size_t outSize) {
+	size_t len=0;
+	for(;*str!='\0' && !isspace(*str) && len+1<outSize;++str) {
+		if (*str=='+' || *str=='#' || *str=='!' || *str=='?' || *str=='=')
+			continue;
+		out[len++]=(*str=='0' ? 'O' : *str);
+	}
+	out[len]='\0';
+}
@@ -17,6 +17,7 @@ typedef enum {
 
 #include "bb.h"
 #include "colour.h"
+#include "depth.h"
 #include "piece.h"
 #include "move.h"
 #include "moves.h"
@@ -35,22 +36,76 @@ extern const CastRights CastRightsNone;
 
 #define POSMOVETOSTRMAXLEN 8
 #define POSMOVETOSTR(pos, move) ({char *str=alloca(POSMOVETOSTRMAXLEN); posMoveToStr((pos), (move), str); (const char *)str;})
+#define POSMOVETOSANMAXLEN 8
+#define POSMOVETOSAN(pos, move) ({char *str=alloca(POSMOVETOSANMAXLEN); posMoveToSan((pos), (move), str); (const char *)str;})
 
 typedef uint64_t Key;
 #define PRIxKey PRIx64
 
+// Fixed size position encoding (see posToPacked()). Fields are in host byte order, files use the little-endian
+// encoding of packedRecordWrite() (see packed.h).
+// pieces holds a 4-bit code for each set bit of occ in square order, two per byte with the low nibble first: 0-5 white
+// pawn, knight, bishop, rook, queen, king, 6-11 the same for black, 12/13 a white/black rook which can still castle and
+// 14 a pawn which can be captured en-passent.
+typedef struct {
+	uint64_t occ;
+	uint8_t pieces[16];
+	uint8_t stm;
+	uint8_t halfMoveNumber;
+	uint16_t fullMoveNumber;
+	int16_t score; // score and result are not used by posToPacked()/posFromPacked() and are free for callers (e.g. see datagen()).
+	uint8_t result;
+	uint8_t padding;
+} PosPacked;
+
 #include "eval.h"
 
+#define PosGameMax 1024 // Longest game history supported (in half moves).
+#define PosHistoryMax (PosGameMax+DepthMax) // Room for the game plus a search on top of it.
+
+typedef struct {
+	Key key;
+	uint64_t lastMove:16;
+	uint64_t lastMoveWasPromo:1;
+	uint64_t halfMoveNumber:15;
+	uint64_t epSq:7;
+	uint64_t capSq:7;
+	uint64_t capPiece:4;
+	uint64_t doublePushSq:7; // Square passed over by a double pawn push on the last move, even if no en-passent capture is possible (unlike epSq).
+	uint64_t padding:3;
+	CastRights castRights;
+	BB checkers; // Pieces giving check to the side to move.
+	BB pinned[ColourNB]; // Pieces pinned to their own king, by colour.
+	BB discoverers; // Side to move's pieces which would give check by moving off the line to the enemy king.
+} PosData;
+
+struct Pos {
+	// All entries should be considered private - only here to allow placing positions on the stack (see posInitInPlace()).
+	BB bbPiece[PieceNB];
+	uint8_t array64[SqNB]; // entries are Pieces
+	PosData *data;
+	BB bbColour[ColourNB], bbAll;
+	Colour stm;
+	unsigned int fullMoveNumber;
+	Key pawnKey, matKey;
+	VPacked pstScore; // From white's POV
+	PosData dataStart[PosHistoryMax]; // Must be last, see posCopy().
+};
+
 void posInit(void);
 
 Pos *posNew(const char *fen); // If fen is NULL uses standard initial position.
 Pos *posNewFromPos(const Pos *src);
 void posFree(Pos *pos);
 
-bool posCopy(Pos *dest, const Pos *src);
+bool posInitInPlace(Pos *pos, const char *fen); // As posNew() but uses the given memory rather than allocating. On failure pos is left as the initial position.
+
+void posCopy(Pos *dest, const Pos *src);
 
 bool posSetToFEN(Pos *pos, const char *string); // If fails pos is unchanged.
 void posGetFEN(const Pos *pos, char string[static 128]);
+void posToPacked(const Pos *pos, PosPacked *packed); // Caller fields (score and result) are set to 0.
+bool posFromPacked(Pos *pos, const PosPacked *packed); // If fails (invalid encoding) pos is unchanged.
 
 void posDraw(const Pos *pos);
 
@@ -66,26 +121,33 @@ unsigned int posGetPieceCount(const Pos *pos, Piece piece);
 Sq posGetKingSq(const Pos *pos, Colour colour);
 
 unsigned int posGetHalfMoveNumber(const Pos *pos);
+unsigned int posGetHistoryCount(const Pos *pos); // Number of moves which can be undone.
 unsigned int posGetFullMoveNumber(const Pos *pos);
 Key posGetKey(const Pos *pos);
 Key posGetPawnKey(const Pos *pos);
 Key posGetMatKey(const Pos *pos);
 CastRights posGetCastRights(const Pos *pos);
 Sq posGetEPSq(const Pos *pos);
-VPair posGetPstScore(const Pos *pos);
+Sq posGetDoublePushSq(const Pos *pos); // Square passed over by a double pawn push on the last move (whether or not it can be captured en-passent), otherwise SqInvalid.
+VPacked posGetPstScore(const Pos *pos);
 
 bool posMakeMove(Pos *pos, Move move);
+bool posMakeMoveUnchecked(Pos *pos, Move move); // As posMakeMove() but skips the legality test, so move must be legal (e.g. returned by movesNext()).
 bool posCanMakeMove(const Pos *pos, Move move); // Returns the same result as posMakeMove() but does not actually make the move on the board.
 void posUndoMove(Pos *pos);
 bool posMakeNullMove(Pos *pos);
 void posUndoNullMove(Pos *pos);
+void posDiscardHistory(Pos *pos); // Forgets moves made before the last capture or pawn move (none of which can repeat), these can no longer be undone.
 
-void posGenPseudoMoves(Moves *moves, MoveType type);
+void posGenLegalMoves(Moves *moves, MoveType type);
 Move posGenLegalMove(const Pos *pos, MoveType type);
 
 bool posIsSqAttackedByColour(const Pos *pos, Sq sq, Colour colour);
 
 bool posIsSTMInCheck(const Pos *pos);
+BB posGetCheckers(const Pos *pos); // Pieces giving check to the side to move.
+BB posGetPinned(const Pos *pos, Colour colour); // Pieces of the given colour which are pinned to their own king.
+BB posGetDiscoverers(const Pos *pos); // Side to move's pieces which would give a discovered check by moving off the line to the enemy king.
 
 bool posIsDraw(const Pos *pos);
 bool posIsMate(const Pos *pos);
@@ -104,6 +166,8 @@ bool posMoveIsCastlingA(const Pos *pos, Move move);
 bool posMoveIsCastlingH(const Pos *pos, Move move);
 Move posMoveFromStr(const Pos *pos, const char str[static 6]);
 void posMoveToStr(const Pos *pos, Move move, char str[static 6]);
+Move posMoveFromSan(const Pos *pos, const char *str); // Standard algebraic notation, ignoring check/annotation suffixes and an optional '=' before promotions. Returns MoveInvalid if no legal move matches.
+void posMoveToSan(Pos *pos, Move move, char str[static 8]); // pos is restored before returning (the move is made to test for mate).
 Sq posMoveGetToSqTrue(const Pos *pos, Move move); // Adjusted if castling
 
 void posCastRightsToStr(CastRights castRights, char str[static 8]);
@@ -1,16 +1,18 @@
 #include <assert.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "attacks.h"
 #include "bitbase.h"
+#include "book.h"
 #include "eval.h"
+#include "fill.h"
 #include "history.h"
 #include "killers.h"
 #include "main.h"
 #include "score.h"
 #include "search.h"
-#include "see.h"
 #include "thread.h"
 #include "tt.h"
 #include "tune.h"
@@ -19,10 +21,72 @@
 
 const MoveScore MoveScoreMax=(((MoveScore)1)<<MoveScoreBit);
 
-Thread *searchThread=NULL;
+typedef struct {
+	int nullReduction;
+	int iidMin, iidReduction;
+	bool historyHeuristic, killersHeuristic;
+	int lmrReduction, lmrReductionDepthLimit, lmrReductionMoveLimit;
+} SearchParams;
+
+TUNECONST SearchParams searchParams={
+	.nullReduction=1,
+	.iidMin=2,
+	.iidReduction=3,
+	.historyHeuristic=true,
+	.killersHeuristic=true,
+	.lmrReduction=1,
+	.lmrReductionDepthLimit=3,
+	.lmrReductionMoveLimit=2,
+};
+
+#ifdef TUNE
+typedef struct {
+	const char *name;
+	size_t offset; // Within SearchParams.
+	bool isCheck; // Otherwise an int spin option between min and max.
+	int min, max;
+} SearchOption;
+const SearchOption searchOptions[]={
+	{"NullReduction", offsetof(SearchParams, nullReduction), false, 0, 8},
+	{"IIDMin", offsetof(SearchParams, iidMin), false, 0, 32},
+	{"IIDReduction", offsetof(SearchParams, iidReduction), false, 0, 32},
+	{"HistoryHeuristic", offsetof(SearchParams, historyHeuristic), true, 0, 1},
+	{"KillersHeuristic", offsetof(SearchParams, killersHeuristic), true, 0, 1},
+	{"LmrReduction", offsetof(SearchParams, lmrReduction), false, 0, 32},
+	{"LmrReductionDepthLimit", offsetof(SearchParams, lmrReductionDepthLimit), false, 0, 32},
+	{"LmrReductionMoveLimit", offsetof(SearchParams, lmrReductionMoveLimit), false, 0, 256},
+};
+#define SearchOptionsNB (sizeof(searchOptions)/sizeof(searchOptions[0]))
+#endif
+
+STATICASSERT(MoveBit<=16); // See pv below.
+struct Search {
+	unsigned long long int nodeCount; // Number of nodes entered since beginning of last search.
+	unsigned long long int nodeNext; // Node count at which we should next check the time.
+	bool stopFlag;
+	Lock *activity; // Once reached depth limit, search will wait for this before printing bestmove command.
+	Pos posStorage, *pos; // Part of the context so that searching never touches the heap.
+	TimeMs endTime;
+	TimeMs nextRegularOutputTime;
+	bool showCurrmove;
+	SearchLimit limit;
+	bool output;
+	SearchDepthCallback *depthCallback;
+	void *depthCallbackUserData;
+	TT *tt;
+	Eval *eval;
+	HistoryTable history;
+	Killers killers;
+	uint16_t pv[DepthMax][DepthMax];
+#	ifdef TUNE
+	const SearchParams *params; // Either &searchParams (the UCI option values) or &ownParams after searchSetOption().
+	SearchParams ownParams;
+#	endif
+};
 
 typedef struct {
 	// Search functions should not modify these entries:
+	Search *search;
 	Pos *pos;
 	Depth depth, ply;
 	Score alpha, beta;
@@ -32,28 +96,8 @@ typedef struct {
 	Bound bound;
 } Node;
 
-unsigned long long int searchNodeCount; // Number of nodes entered since beginning of last search.
-unsigned long long int searchNodeNext; // Node count at which we should next check the time.
-bool searchStopFlag;
-Lock *searchActivity=NULL; // Once reached depth limit, search will wait for this before printing bestmove command.
-Pos *searchPos=NULL;
-TimeMs searchEndTime;
-TimeMs searchNextRegularOutputTime;
-bool searchShowCurrmove;
-SearchLimit searchLimit;
-unsigned int searchDate; // Incremented after each searchThink() call.
-bool searchOutput;
-STATICASSERT(MoveBit<=16);
-uint16_t searchPv[DepthMax][DepthMax];
-
-TUNECONST int searchNullReduction=1;
-TUNECONST int searchIIDMin=2;
-TUNECONST int searchIIDReduction=3;
-TUNECONST bool searchHistoryHeuristic=true;
-TUNECONST bool searchKillersHeuristic=true;
-TUNECONST int searchLmrReduction=1;
-TUNECONST int searchLmrReductionDepthLimit=3;
-TUNECONST int searchLmrReductionMoveLimit=2;
+Search *searchMain=NULL; // Used by the UCI commands, with searches run by searchThread.
+Thread *searchThread=NULL;
 
 bool searchPonder=true;
 
@@ -61,19 +105,20 @@ bool searchPonder=true;
 // Private prototypes.
 ////////////////////////////////////////////////////////////////////////////////
 
-void searchThinkClear(void);
-void searchStopInternal(void); // indicate search should stop asap - sets stop flag and updates activity lock. Can be called by worker thread (as opposed to external version searchStop).
+void searchPrepare(Search *search, const Pos *srcPos, const SearchLimit *limit, bool output); // Setup search ready for searchIDLoop().
+void searchThinkClear(Search *search);
+void searchStopInternal(Search *search); // indicate search should stop asap - sets stop flag and updates activity lock. Can be called by worker thread (as opposed to external version searchStop).
 
-void searchIDLoop(void *posPtr);
+void searchIDLoop(void *searchPtr);
 
 Score searchNode(Node *node);
 Score searchQNode(Node *node);
 void searchNodeInternal(Node *node);
 void searchQNodeInternal(Node *node);
 
-bool searchIsTimeUp(void);
+bool searchIsTimeUp(Search *search);
 
-void searchOutputRegular(void); // Regular infomation such as hashfull and nps.
+void searchOutputRegular(Search *search); // Regular infomation such as hashfull and nps.
 void searchOutputDepthPre(Node *node); // Called at begining of searching a new depth.
 void searchOutputDepthPost(Node *node); // Called at end of searching a particular depth.
 
@@ -88,11 +133,11 @@ bool searchInteriorRecogKNNvK(Node *node);
 bool searchInteriorRecogKPvK(Node *node);
 bool searchInteriorRecogKBPvK(Node *node);
 
-BB searchFill(PieceType type, BB init, BB occ, BB target);
-
 bool searchNodeIsPV(const Node *node);
 bool searchNodeIsQ(const Node *node);
 
+const SearchParams *searchGetParams(const Search *search);
+
 void searchInterfacePonder(void *dummy, bool ponder);
 
 #ifdef TUNE
@@ -105,38 +150,31 @@ void searchInterfaceCheckValue(void *ptr, bool value);
 ////////////////////////////////////////////////////////////////////////////////
 
 void searchInit(void) {
-	// Create worker thread and lock.
+	// Create the UCI engine's context, and the thread to run its searches.
+	searchMain=searchNew();
+	if (searchMain==NULL)
+		mainFatalError("Error: Could not allocate search.\n");
 	searchThread=threadNew();
 	if (searchThread==NULL)
 		mainFatalError("Error: Could not start search worker thread.\n");
-	searchActivity=lockNew(0);
-	if (searchActivity==NULL)
-		mainFatalError("Error: Could not init lock for search.\n");
-
-	// Create position
-	searchPos=posNew(NULL);
-	if (searchPos==NULL)
-		mainFatalError("Error: Could not create position for search.\n");
 
-	// Set all structures to clean state.
-	searchClear();
-
-	// Set searchThink fields for first search
-	searchThinkClear();
+	// Options acting on the context's tables.
+	ttOptionsNew(searchMain->tt);
+	evalOptionsNew(searchMain->eval);
 
 	// Init pondering option.
 	uciOptionNewCheck("Ponder", &searchInterfacePonder, NULL, searchPonder);
 
 	// Setup callbacks for tuning values.
 # ifdef TUNE
-	uciOptionNewSpin("NullReduction", &searchInterfaceSpinValue, &searchNullReduction, 0, 8, searchNullReduction);
-	uciOptionNewSpin("IIDMin", &searchInterfaceSpinValue, &searchIIDMin, 0, 32, searchIIDMin);
-	uciOptionNewSpin("IIDReduction", &searchInterfaceSpinValue, &searchIIDReduction, 0, 32, searchIIDReduction);
-	uciOptionNewCheck("HistoryHeuristic", &searchInterfaceCheckValue, &searchHistoryHeuristic, searchHistoryHeuristic);
-	uciOptionNewCheck("KillersHeuristic", &searchInterfaceCheckValue, &searchKillersHeuristic, searchKillersHeuristic);
-	uciOptionNewSpin("LmrReduction", &searchInterfaceSpinValue, &searchLmrReduction, 0, 32, searchLmrReduction);
-	uciOptionNewSpin("LmrReductionDepthLimit", &searchInterfaceSpinValue, &searchLmrReductionDepthLimit, 0, 32, searchLmrReductionDepthLimit);
-	uciOptionNewSpin("LmrReductionMoveLimit", &searchInterfaceSpinValue, &searchLmrReductionMoveLimit, 0, 256, searchLmrReductionMoveLimit);
+	for(unsigned int i=0; i<SearchOptionsNB; ++i) {
+		const SearchOption *option=&searchOptions[i];
+		void *value=((char *)&searchParams)+option->offset;
+		if (option->isCheck)
+			uciOptionNewCheck(option->name, &searchInterfaceCheckValue, value, *(bool *)value);
+		else
+			uciOptionNewSpin(option->name, &searchInterfaceSpinValue, value, option->min, option->max, *(int *)value);
+	}
 # endif
 }
 
@@ -144,65 +182,112 @@ void searchQuit(void) {
 	// If searching, signal to stop and wait until done.
 	searchStopAndWait();
 
-	// Free position
-	posFree(searchPos);
-
-	// Free the worker thread and lock;
+	// Free the worker thread and context.
 	threadFree(searchThread);
-	lockFree(searchActivity);
+	searchFree(searchMain);
 }
 
-void searchThink(const Pos *srcPos, const SearchLimit *limit, bool output) {
-	// Make sure we are not already searching (and if we are, set stop flag and wait until finished).
-	searchStopAndWait();
+Search *searchNew(void) {
+	// Allocate context and its tables.
+	Search *search=malloc(sizeof(Search));
+	if (search==NULL)
+		return NULL;
+	search->activity=lockNew(0);
+	search->tt=ttNew(searchMain!=NULL ? ttGetSizeMb(searchMain->tt) : ttDefaultSizeMb);
+	search->eval=evalNew();
+	if (search->activity==NULL || search->tt==NULL || search->eval==NULL) {
+		searchFree(search);
+		return NULL;
+	}
+#	ifdef TUNE
+	search->params=&searchParams;
+#	endif
 
-	// Sanity checks
-	assert(searchNodeNext==1);
-	assert(searchShowCurrmove==false);
-	assert(searchEndTime==TimeMsInvalid);
-	assert(searchNextRegularOutputTime==0);
+	// Init position.
+	search->pos=&search->posStorage;
+	posInitInPlace(search->pos, NULL);
 
-	// Prepare for search.
-	if (!posCopy(searchPos, srcPos))
+	// Set all structures to clean state.
+	search->depthCallback=NULL;
+	search->depthCallbackUserData=NULL;
+	searchClear(search);
+
+	// Set searchThink fields for first search
+	searchThinkClear(search);
+
+	return search;
+}
+
+void searchFree(Search *search) {
+	if (search==NULL)
 		return;
 
-	searchStopFlag=false;
-	searchNodeCount=0;
-	searchLimit=*limit;
-	searchLimit.searchMovesNext=searchLimit.searchMoves+(limit->searchMovesNext-limit->searchMoves);
-	searchOutput=output;
+	if (search->activity!=NULL)
+		lockFree(search->activity);
+	ttFree(search->tt);
+	evalFree(search->eval);
+	free(search);
+}
 
-	while (lockTryWait(searchActivity)) ; // Reset to 0.
+bool searchSetOption(Search *search, const char *name, const char *value) {
+	// Transposition table size.
+	if (utilStrEqual(name, "Hash"))
+		return ttResize(search->tt, utilMax(atoi(value), 1));
 
-	// Decide how to use our time.
-	if (searchLimit.nodes==0)
-		searchLimit.nodes=~0; // To avoid an extra searchLimit.nodes!=0 check in searchIsTimeUp().
+	// Search tuning values.
+#	ifdef TUNE
+	for(unsigned int i=0; i<SearchOptionsNB; ++i) {
+		const SearchOption *option=&searchOptions[i];
+		if (!utilStrEqual(name, option->name))
+			continue;
 
-	TimeMs searchTime=TimeMsInvalid;
-	if (searchLimit.totalTime!=TimeMsInvalid || searchLimit.incTime!=TimeMsInvalid) {
-		if (searchLimit.totalTime==TimeMsInvalid)
-			searchLimit.totalTime=0;
-		if (searchLimit.incTime==TimeMsInvalid)
-			searchLimit.incTime=0;
-		if (searchLimit.movesToGo==0)
-			searchLimit.movesToGo=15;
-		TimeMs maxTime=searchLimit.totalTime-20;
-		searchTime=utilMin(searchTime, searchLimit.totalTime/searchLimit.movesToGo+searchLimit.incTime);
-		searchTime=utilMin(searchTime, maxTime);
+		// Take a private copy of the values if still using the UCI option ones.
+		if (search->params==&searchParams) {
+			search->ownParams=searchParams;
+			search->params=&search->ownParams;
+		}
+
+		// Set value.
+		void *ptr=((char *)&search->ownParams)+option->offset;
+		if (option->isCheck)
+			*(bool *)ptr=utilStrEqual(value, "true");
+		else
+			*(int *)ptr=utilMin(utilMax(atoi(value), option->min), option->max);
+
+		// Clear now-invalid TT and history etc.
+		searchClear(search);
+
+		return true;
 	}
-	if (searchLimit.moveTime!=TimeMsInvalid)
-		searchTime=utilMin(searchTime, searchLimit.moveTime);
-	if (searchTime!=TimeMsInvalid)
-		searchEndTime=searchLimit.startTime+searchTime;
+#	endif
+
+	// Otherwise perhaps an evaluation option.
+	return evalSetOption(search->eval, name, value);
+}
+
+void searchRun(Search *search, const Pos *pos, const SearchLimit *limit, SearchDepthCallback *callback, void *userData) {
+	search->depthCallback=callback;
+	search->depthCallbackUserData=userData;
+	searchPrepare(search, pos, limit, false);
+	searchIDLoop(search);
+}
+
+void searchThink(const Pos *srcPos, const SearchLimit *limit, bool output) {
+	// Make sure we are not already searching (and if we are, set stop flag and wait until finished).
+	searchStopAndWait();
+
+	// Prepare for search.
+	searchMain->depthCallback=NULL;
+	searchPrepare(searchMain, srcPos, limit, output);
 
 	// Set away worker
-	threadRun(searchThread, &searchIDLoop, NULL);
+	threadRun(searchThread, &searchIDLoop, searchMain);
 }
 
 void searchStopAndWait(void) {
 	// Signal for search to stop.
-	searchLimit.infinite=false;
-	searchStopInternal();
+	searchMain->limit.infinite=false;
+	searchStopInternal(searchMain);
 
 	// Wait until actually finished.
 	searchWait();
@@ -212,44 +297,55 @@ void searchWait(void) {
 	threadWaitReady(searchThread);
 }
 
-unsigned long long int searchBenchmark(const Pos *pos, Depth depth) {
+unsigned long long int searchBenchmark(Search *search, const Pos *pos, Depth depth) {
 	// Set search limit to given depth.
 	SearchLimit limit;
 	searchLimitInit(&limit, 0);
 	searchLimitSetDepth(&limit, depth);
 
-	// Search and wait to complete.
-	searchThink(pos, &limit, false);
-	searchWait();
+	// Search on this thread.
+	searchRun(search, pos, &limit, NULL, NULL);
 
 	// Return node count.
-	return searchNodeCount;
+	return search->nodeCount;
 }
 
-void searchClear(void) {
+void searchClear(Search *search) {
 	// Clear history tables.
-	historyClear();
+	historyClear(&search->history);
 
-	// Clear transposition table.
-	ttClear();
+	// Clear transposition table (also resetting its date).
+	ttClear(search->tt);
 
 	// Clear killer moves.
-	killersClear();
+	killersClear(&search->killers);
 
-	// Reset search date.
-	searchDate=0;
+	// Clear evaluation hash tables.
+	evalClear(search->eval);
 
 	// Clear PV array
 	assert(MoveInvalid==0);
-	memset(searchPv, 0, sizeof(searchPv));
+	memset(search->pv, 0, sizeof(search->pv));
 }
 
 void searchPonderHit(void) {
-	searchLimit.infinite=false;
-	lockPost(searchActivity);
+	searchMain->limit.infinite=false;
+	lockPost(searchMain->activity);
+}
+
+Search *searchGetMain(void) {
+	return searchMain;
+}
+
+Eval *searchGetEval(Search *search) {
+	return search->eval;
 }
 
-MoveScore searchScoreMove(const Pos *pos, Move move) {
+TT *searchGetTT(Search *search) {
+	return search->tt;
+}
+
+MoveScore searchScoreMove(const Search *search, const Pos *pos, Move move) {
 	// Sanity checks.
 	assert(moveIsValid(move));
 
@@ -269,19 +365,19 @@ MoveScore searchScoreMove(const Pos *pos, Move move) {
 	score<<=HistoryBit;
 
 	// Further sort using history tables
-	if (searchHistoryHeuristic)
-		score+=historyGet(fromPiece, toSqTrue);
+	if (search!=NULL && searchGetParams(search)->historyHeuristic)
+		score+=historyGet(&search->history, fromPiece, toSqTrue);
 
 	assert(score<MoveScoreMax);
 	return score;
 }
 
-unsigned int searchGetDate(void) {
-	return searchDate;
+const Move *searchGetKillers(const Search *search, Depth ply) {
+	return killersGet(&search->killers, ply);
 }
 
-unsigned int searchDateToAge(unsigned int date) {
-	return (date<=searchDate ? searchDate-date : DateMax+searchDate-date);
+unsigned long long int searchGetNodeCount(const Search *search) {
+	return search->nodeCount;
 }
 
 void searchLimitInit(SearchLimit *limit, TimeMs startTime) {
@@ -334,39 +430,85 @@ void searchLimitAddMove(SearchLimit *limit, const Pos *pos, Move move) {
 // Private functions.
 ////////////////////////////////////////////////////////////////////////////////
 
-void searchThinkClear(void) {
-	searchNodeNext=1;
-	searchShowCurrmove=false;
-	searchEndTime=TimeMsInvalid;
-	searchNextRegularOutputTime=0;
-	searchDate=(searchDate+1)%DateMax;
+void searchPrepare(Search *search, const Pos *srcPos, const SearchLimit *limit, bool output) {
+	// Sanity checks
+	assert(search->nodeNext==1);
+	assert(search->showCurrmove==false);
+	assert(search->endTime==TimeMsInvalid);
+	assert(search->nextRegularOutputTime==0);
+
+	// Prepare for search.
+	posCopy(search->pos, srcPos);
+
+	search->stopFlag=false;
+	search->nodeCount=0;
+	search->limit=*limit;
+	search->limit.searchMovesNext=search->limit.searchMoves+(limit->searchMovesNext-limit->searchMoves);
+	search->output=output;
+
+	while (lockTryWait(search->activity)) ; // Reset to 0.
+
+	// Decide how to use our time.
+	if (search->limit.nodes==0)
+		search->limit.nodes=~0; // To avoid an extra limit.nodes!=0 check in searchIsTimeUp().
+
+	TimeMs searchTime=TimeMsInvalid;
+	if (search->limit.totalTime!=TimeMsInvalid || search->limit.incTime!=TimeMsInvalid) {
+		if (search->limit.totalTime==TimeMsInvalid)
+			search->limit.totalTime=0;
+		if (search->limit.incTime==TimeMsInvalid)
+			search->limit.incTime=0;
+		if (search->limit.movesToGo==0)
+			search->limit.movesToGo=15;
+		TimeMs maxTime=search->limit.totalTime-20;
+		searchTime=utilMin(searchTime, search->limit.totalTime/search->limit.movesToGo+search->limit.incTime);
+		searchTime=utilMin(searchTime, maxTime);
+	}
+	if (search->limit.moveTime!=TimeMsInvalid)
+		searchTime=utilMin(searchTime, search->limit.moveTime);
+	if (searchTime!=TimeMsInvalid)
+		search->endTime=search->limit.startTime+searchTime;
 }
 
-void searchStopInternal(void) {
+void searchThinkClear(Search *search) {
+	search->nodeNext=1;
+	search->showCurrmove=false;
+	search->endTime=TimeMsInvalid;
+	search->nextRegularOutputTime=0;
+	ttAge(search->tt);
+}
+
+void searchStopInternal(Search *search) {
 	// Set flag to indicate to return asap
-	searchStopFlag=true;
+	search->stopFlag=true;
 
 	// Update activity lock
-	lockPost(searchActivity);
+	lockPost(search->activity);
 }
 
-void searchIDLoop(void *userData) {
-	assert(userData==NULL);
+void searchIDLoop(void *searchPtr) {
+	Search *search=searchPtr;
 
 	// Make node structure for root node.
 	Node node;
-	node.pos=searchPos;
+	node.search=search;
+	node.pos=search->pos;
 	node.ply=0;
 	node.alpha=-ScoreInf;
 	node.beta=ScoreInf;
 	node.inCheck=posIsSTMInCheck(node.pos);
 
+	// Book move? (only when playing, i.e. with output, not analysing and no restrictions on the root moves).
+	Move bookMove=MoveInvalid;
+	if (search->output && !search->limit.infinite && search->limit.searchMovesNext==search->limit.searchMoves)
+		bookMove=bookGetMove(search->pos);
+
 	// Loop, increasing search depth until we run out of 'time'.
-	Move bestMove=MoveInvalid, ponderMove=MoveInvalid;
-	for(node.depth=1;node.depth<=searchLimit.depth;++node.depth) {
+	Move bestMove=bookMove, ponderMove=MoveInvalid;
+	for(node.depth=1;node.depth<=search->limit.depth && !moveIsValid(bookMove);++node.depth) {
 		// After 1s start showing 'currmove' info.
-		if (searchOutput && timeGet()>=searchLimit.startTime+1000)
-			searchShowCurrmove=true;
+		if (search->output && timeGet()>=search->limit.startTime+1000)
+			search->showCurrmove=true;
 
 		// Output pre info.
 		searchOutputDepthPre(&node);
@@ -379,71 +521,83 @@ void searchIDLoop(void *userData) {
 			break;
 
 		// Update bestMove
-		bestMove=searchPv[node.ply][0];
-		ponderMove=(bestMove!=MoveInvalid ? searchPv[node.ply][1] : MoveInvalid);
+		bestMove=search->pv[node.ply][0];
+		ponderMove=(bestMove!=MoveInvalid ? search->pv[node.ply][1] : MoveInvalid);
 
 		// Output post info.
 		searchOutputDepthPost(&node);
 
+		// Inform any interested party.
+		if (search->depthCallback!=NULL) {
+			Move pv[DepthMax];
+			unsigned int pvLength=0;
+			while(pvLength<DepthMax && search->pv[node.ply][pvLength]!=MoveInvalid) {
+				pv[pvLength]=search->pv[node.ply][pvLength];
+				++pvLength;
+			}
+			search->depthCallback(search->depthCallbackUserData, node.depth, node.score, node.bound, pv, pvLength, search->nodeCount, timeGet()-search->limit.startTime);
+		}
+
 		// Time to end?
-		if (searchIsTimeUp())
+		if (searchIsTimeUp(search))
 			break;
 	}
 
 	// Ensure we have a legal bestMove
-	if (!moveIsValid(bestMove) || !posCanMakeMove(searchPos, bestMove)) {
-		if (searchLimit.searchMovesNext>searchLimit.searchMoves)
-			bestMove=searchLimit.searchMoves[0];
+	if (!moveIsValid(bestMove) || !posCanMakeMove(search->pos, bestMove)) {
+		if (search->limit.searchMovesNext>search->limit.searchMoves)
+			bestMove=search->limit.searchMoves[0];
 		else
-			bestMove=posGenLegalMove(searchPos, MoveTypeAny);
+			bestMove=posGenLegalMove(search->pos, MoveTypeAny);
 	}
 
 	// If in pondering mode try to extract ponder move.
 	if (searchPonder && moveIsValid(bestMove) && !moveIsValid(ponderMove)) {
-		assert(posCanMakeMove(searchPos, bestMove));
-		posMakeMove(searchPos, bestMove);
-		ponderMove=ttReadMove(searchPos, 1);
-		if (!moveIsValid(ponderMove) || !posCanMakeMove(searchPos, ponderMove))
-			ponderMove=posGenLegalMove(searchPos, MoveTypeAny);
-		posUndoMove(searchPos);
+		assert(posCanMakeMove(search->pos, bestMove));
+		posMakeMove(search->pos, bestMove);
+		ponderMove=ttReadMove(search->tt, search->pos, 1);
+		if (!moveIsValid(ponderMove) || !posCanMakeMove(search->pos, ponderMove))
+			ponderMove=posGenLegalMove(search->pos, MoveTypeAny);
+		posUndoMove(search->pos);
 	}
 
 	// This is to handle infinite mode - wait until told to stop.
 	bool doExtraInfoCommand=false;
-	if (searchLimit.infinite && !lockTryWait(searchActivity)) {
+	if (search->limit.infinite && !lockTryWait(search->activity)) {
 		// Set flag to indicate we will have to repeat last proper 'info' command right before we send bestmove command
 		doExtraInfoCommand=true;
 
 		// Wait until told to stop
-		while(searchLimit.infinite)
-			lockWait(searchActivity);
+		while(search->limit.infinite)
+			lockWait(search->activity);
 	}
 
 	// Send best move (and potentially ponder move) to GUI.
-	if (searchOutput) {
+	if (search->output) {
 		if (doExtraInfoCommand)
 			searchOutputDepthPost(&node);
 
 		char str[8];
-		posMoveToStr(searchPos, bestMove, str);
+		posMoveToStr(search->pos, bestMove, str);
 		if (moveIsValid(ponderMove)) {
-			posMakeMove(searchPos, bestMove);
-			uciWrite("bestmove %s ponder %s\n", str, POSMOVETOSTR(searchPos, ponderMove));
-			posUndoMove(searchPos);
+			posMakeMove(search->pos, bestMove);
+			uciWrite("bestmove %s ponder %s\n", str, POSMOVETOSTR(search->pos, ponderMove));
+			posUndoMove(search->pos);
 		} else
 			uciWrite("bestmove %s\n", str);
 	}
 
 	// Age history table.
-	if (searchHistoryHeuristic)
-		historyAge();
+	const SearchParams *params=searchGetParams(search);
+	if (params->historyHeuristic)
+		historyAge(&search->history);
 
 	// Clear killers (do here to avoid having to spend time at start of next search).
-	if (searchKillersHeuristic)
-		killersClear();
+	if (params->killersHeuristic)
+		killersClear(&search->killers);
 
 	// Reset searchThink fields for next search
-	searchThinkClear();
+	searchThinkClear(search);
 }
 
 Score searchNode(Node *node) {
@@ -488,11 +642,14 @@ Score searchQNode(Node *node) {
 }
 
 void searchNodeInternal(Node *node) {
+	Search *search=node->search;
+	const SearchParams *params=searchGetParams(search);
+
 	// Q node?
 	if (searchNodeIsQ(node)) {
 		// Don't collect PV in qsearch
 		if (node->ply<DepthMax)
-			searchPv[node->ply][0]=MoveInvalid;
+			search->pv[node->ply][0]=MoveInvalid;
 
 		searchQNode(node);
 		return;
@@ -501,13 +658,13 @@ void searchNodeInternal(Node *node) {
 	// Ply limit reached?
 	if (node->ply>=DepthMax) {
 		node->bound=BoundExact;
-		node->score=evaluate(node->pos);
+		node->score=evaluate(search->eval, node->pos);
 		return;
 	}
 
 	// Node begins.
-	searchPv[node->ply][0]=MoveInvalid;
-	++searchNodeCount;
+	search->pv[node->ply][0]=MoveInvalid;
+	++search->nodeCount;
 
 	// Mate distance pruning.
 	if (node->ply>0) {
@@ -535,7 +692,7 @@ void searchNodeInternal(Node *node) {
 	unsigned int ttDepth;
 	Score ttScore;
 	Bound ttBound;
-	if (ttRead(node->pos, node->ply, &ttMove, &ttDepth, &ttScore, &ttBound)) {
+	if (ttRead(search->tt, node->pos, node->ply, &ttMove, &ttDepth, &ttScore, &ttBound)) {
 		// Sanity checks.
 		assert(moveIsValid(ttMove));
 		assert(scoreIsValid(ttScore));
@@ -548,23 +705,24 @@ void searchNodeInternal(Node *node) {
 		    (ttBound==BoundUpper && (ttScore<=node->alpha)))) {
 			node->bound=ttBound;
 			node->score=ttScore;
-			searchPv[node->ply][0]=ttMove;
-			searchPv[node->ply][1]=MoveInvalid;
+			search->pv[node->ply][0]=ttMove;
+			search->pv[node->ply][1]=MoveInvalid;
 			return;
 		}
 	}
 
 	// Null move pruning.
 	Node child;
+	child.search=search;
 	child.pos=node->pos;
 	child.ply=node->ply+1;
-	if (!searchNodeIsPV(node) && searchNullReduction>0 && node->depth>1+searchNullReduction &&
-	    !scoreIsMate(node->beta) && !searchIsZugzwang(node) && evaluate(node->pos)>=node->beta) {
+	if (!searchNodeIsPV(node) && params->nullReduction>0 && node->depth>1+params->nullReduction &&
+	    !scoreIsMate(node->beta) && !searchIsZugzwang(node) && evaluate(search->eval, node->pos)>=node->beta) {
 		assert(!node->inCheck); // searchIsZugzwang returning false ensures this is the case
 
 		posMakeNullMove(node->pos);
 		child.inCheck=false;
-		child.depth=node->depth-1-searchNullReduction;
+		child.depth=node->depth-1-params->nullReduction;
 		child.alpha=-node->beta;
 		child.beta=1-node->beta;
 		Score score=-searchNode(&child);
@@ -578,19 +736,19 @@ void searchNodeInternal(Node *node) {
 	}
 
 	// Internal iterative deepening.
-	if (searchIIDReduction>0 && node->depth>=searchIIDMin && node->depth>searchIIDReduction && searchNodeIsPV(node) && !moveIsValid(ttMove)) {
+	if (params->iidReduction>0 && node->depth>=params->iidMin && node->depth>params->iidReduction && searchNodeIsPV(node) && !moveIsValid(ttMove)) {
 		assert(ttMove==MoveInvalid);
 
 		// No hash move available - search current node but with a reduced depth to obtain a good guess at the best move.
 		Node child=*node;
-		child.depth-=searchIIDReduction;
+		child.depth-=params->iidReduction;
 		searchNode(&child);
-		ttMove=searchPv[child.ply][0];
+		ttMove=search->pv[child.ply][0];
 	}
 
 	// Move loop.
 	Moves moves;
-	movesInit(&moves, node->pos, node->ply, MoveTypeAny);
+	movesInit(&moves, node->pos, search, node->ply, MoveTypeAny);
 	movesRewind(&moves, ttMove);
 	Score alpha=node->alpha;
 	node->score=ScoreInvalid;
@@ -601,40 +759,40 @@ void searchNodeInternal(Node *node) {
 	unsigned moveNumber=0, lmrMoveNumber=0;
 	while((move=movesNext(&moves))!=MoveInvalid) {
 		// If we are the root ensure this move is one that was specified (if any restriction given)
-		if (node->ply==0 && searchLimit.searchMovesNext>searchLimit.searchMoves) {
+		if (node->ply==0 && search->limit.searchMovesNext>search->limit.searchMoves) {
 			Move *movePtr;
-			for(movePtr=searchLimit.searchMoves; movePtr!=searchLimit.searchMovesNext; ++movePtr)
+			for(movePtr=search->limit.searchMoves; movePtr!=search->limit.searchMovesNext; ++movePtr)
 				if (move==*movePtr)
 					break;
-			if (movePtr==searchLimit.searchMovesNext)
+			if (movePtr==search->limit.searchMovesNext)
 				continue;
 		}
 
 		// Find move string for UCI output.
 		char moveStr[8]; // Only used if root node.
-		if (searchShowCurrmove && node->ply==0)
+		if (search->showCurrmove && node->ply==0)
 			posMoveToStr(node->pos, move, moveStr); // Must do this before making the move.
 
-		// Make move (might leave us in check, if so skip).
+		// Make move.
 		MoveType moveType=posMoveGetType(node->pos, move);
-		if (!posMakeMove(node->pos, move))
+		if (!posMakeMoveUnchecked(node->pos, move))
 			continue;
 		++moveNumber;
 
 		// 'currmove' UCI output.
-		if (searchShowCurrmove && node->ply==0)
+		if (search->showCurrmove && node->ply==0)
 			uciWrite("info depth %u currmove %s currmovenumber %u\n", node->depth, moveStr, moveNumber);
 
 		// Calculate child values.
-		child.inCheck=posIsSTMInCheck(node->pos);
+		child.inCheck=posIsSTMInCheck(child.pos);
 
 		// Calculate search depth.
 		int extension=0, reduction=0;
 		extension+=child.inCheck; // Check extension;
-		if (extension==0 && !node->inCheck && !child.inCheck && node->depth>=searchLmrReductionDepthLimit && moveType==MoveTypeQuiet) {
+		if (extension==0 && !node->inCheck && !child.inCheck && node->depth>=params->lmrReductionDepthLimit && moveType==MoveTypeQuiet) {
 			++lmrMoveNumber;
-			if (lmrMoveNumber>searchLmrReductionMoveLimit)
-				reduction+=searchLmrReduction; // Late-move-reductions.
+			if (lmrMoveNumber>params->lmrReductionMoveLimit)
+				reduction+=params->lmrReduction; // Late-move-reductions.
 		}
 		child.depth=node->depth-1+extension-reduction;
 
@@ -669,7 +827,7 @@ void searchNodeInternal(Node *node) {
 		posUndoMove(node->pos);
 
 		// Out of time? (previous search result is invalid).
-		if (searchIsTimeUp()) {
+		if (searchIsTimeUp(search)) {
 			// No moves searched?
 			if (node->bound==BoundNone) {
 				node->bound=BoundNone;
@@ -677,10 +835,10 @@ void searchNodeInternal(Node *node) {
 				return;
 			}
 			assert(scoreIsValid(node->score));
-			assert(moveIsValid(searchPv[node->ply][0]));
+			assert(moveIsValid(search->pv[node->ply][0]));
 
 			// We may have useful info, update TT.
-			ttWrite(node->pos, node->ply, node->depth, searchPv[node->ply][0], node->score, node->bound);
+			ttWrite(search->tt, node->pos, node->ply, node->depth, search->pv[node->ply][0], node->score, node->bound);
 
 			return;
 		}
@@ -689,16 +847,16 @@ void searchNodeInternal(Node *node) {
 		if (score>node->score) {
 			// Update best score and update PV.
 			node->score=score;
-			searchPv[node->ply][0]=move;
+			search->pv[node->ply][0]=move;
 			if (node->ply+1<DepthMax) {
 				for(unsigned i=0; i<DepthMax-1; ++i) {
-					searchPv[node->ply][i+1]=searchPv[node->ply+1][i];
-					if (searchPv[node->ply+1][i]==MoveInvalid)
+					search->pv[node->ply][i+1]=search->pv[node->ply+1][i];
+					if (search->pv[node->ply+1][i]==MoveInvalid)
 						break;
 				}
-				searchPv[node->ply][DepthMax-1]=MoveInvalid; // ensure array in terminated even if copied a large sub-PV
+				search->pv[node->ply][DepthMax-1]=MoveInvalid; // ensure array in terminated even if copied a large sub-PV
 			} else
-				searchPv[node->ply][1]=MoveInvalid;
+				search->pv[node->ply][1]=MoveInvalid;
 
 			// Alpha improvement?
 			if (score>alpha) {
@@ -708,8 +866,8 @@ void searchNodeInternal(Node *node) {
 				// Cutoff?
 				if (score>=node->beta) {
 					// Update killers.
-					if (searchKillersHeuristic && posMoveGetType(node->pos, searchPv[node->ply][0])==MoveTypeQuiet)
-						killersCutoff(node->ply, searchPv[node->ply][0]);
+					if (params->killersHeuristic && posMoveGetType(node->pos, search->pv[node->ply][0])==MoveTypeQuiet)
+						killersCutoff(&search->killers, node->ply, search->pv[node->ply][0]);
 
 					goto cutoff;
 				}
@@ -739,10 +897,10 @@ void searchNodeInternal(Node *node) {
 
 	// Root node - no need to continue searching?
 	// (continue searching anyway if in infinite/pondering mode)
-	if (!searchLimit.infinite && node->ply==0) {
+	if (!search->limit.infinite && node->ply==0) {
 		// Single legal move?
 		if (moveNumber==1)
-			searchStopInternal();
+			searchStopInternal(search);
 
 		// 'Good enough' mate?
 		// We say 'good' rather than 'unbeatable' because of depth reductions within nodes (such as LMR).
@@ -752,41 +910,43 @@ void searchNodeInternal(Node *node) {
 			// Note: +1 is because if we find a depth n+1 mate at depth n then continuing to search is only going to find a depth n+1 mate at depth n+1
 			// (again with same caveat as above)
 			if (scoreMateDistancePly(node->score)<=node->depth+1)
-				searchStopInternal();
+				searchStopInternal(search);
 		}
 	}
 
 	cutoff:
 
 	// We now know the best move.
-	assert(moveIsValid(searchPv[node->ply][0]));
+	assert(moveIsValid(search->pv[node->ply][0]));
 	assert(scoreIsValid(node->score));
 	assert(node->bound!=BoundNone);
 
 	// Update history table.
-	if (searchHistoryHeuristic && posMoveGetType(node->pos, searchPv[node->ply][0])==MoveTypeQuiet) {
-		Piece fromPiece=moveGetToPiece(searchPv[node->ply][0]);
-		assert(fromPiece==posGetPieceOnSq(node->pos, moveGetFromSq(searchPv[node->ply][0]))); // Could only disagree if move is promotion, but these are classed as captures.
-		Sq toSq=moveGetToSqRaw(searchPv[node->ply][0]);
-		historyInc(fromPiece, toSq, node->depth);
+	if (params->historyHeuristic && posMoveGetType(node->pos, search->pv[node->ply][0])==MoveTypeQuiet) {
+		Piece fromPiece=moveGetToPiece(search->pv[node->ply][0]);
+		assert(fromPiece==posGetPieceOnSq(node->pos, moveGetFromSq(search->pv[node->ply][0]))); // Could only disagree if move is promotion, but these are classed as captures.
+		Sq toSq=moveGetToSqRaw(search->pv[node->ply][0]);
+		historyInc(&search->history, fromPiece, toSq, node->depth);
 	}
 
 	// Update transposition table.
-	ttWrite(node->pos, node->ply, node->depth, searchPv[node->ply][0], node->score, node->bound);
+	ttWrite(search->tt, node->pos, node->ply, node->depth, search->pv[node->ply][0], node->score, node->bound);
 
 	return;
 }
 
 void searchQNodeInternal(Node *node) {
+	Search *search=node->search;
+
 	// Ply limit reached?
 	if (node->ply>=DepthMax) {
 		node->bound=BoundExact;
-		node->score=evaluate(node->pos);
+		node->score=evaluate(search->eval, node->pos);
 		return;
 	}
 
 	// Init.
-	++searchNodeCount;
+	++search->nodeCount;
 	Score alpha=node->alpha;
 
 	// Interior node recogniser (also handles draws).
@@ -795,7 +955,7 @@ void searchQNodeInternal(Node *node) {
 
 	// Standing pat (when not in check).
 	if (!node->inCheck) {
-		Score eval=evaluate(node->pos);
+		Score eval=evaluate(search->eval, node->pos);
 		if (eval>=node->beta) {
 			node->bound=BoundLower;
 			node->score=node->beta;
@@ -808,29 +968,30 @@ void searchQNodeInternal(Node *node) {
 	Node child;
 	node->bound=BoundLower;
 	node->score=alpha;
+	child.search=search;
 	child.pos=node->pos;
 	child.depth=node->depth;
 	child.ply=node->ply+1;
 	child.alpha=-node->beta;
 	child.beta=-alpha;
 	Moves moves;
-	movesInit(&moves, node->pos, 0, (node->inCheck ? MoveTypeAny : MoveTypeCapture));
+	movesInit(&moves, node->pos, search, 0, (node->inCheck ? MoveTypeAny : MoveTypeCapture));
 	Move move;
 	bool noLegalMove=true;
 	while((move=movesNext(&moves))!=MoveInvalid) {
-		// If SEE is negative, skip move.
-		if (!node->inCheck && !posMoveIsPromotion(node->pos, move) && seeSign(node->pos, moveGetFromSq(move), posMoveGetToSqTrue(node->pos, move))<0)
-			continue;
+		// Only losing captures left? Not worth searching (unless in check).
+		if (!node->inCheck && movesIsBadCapturesStage(&moves))
+			break;
 
 		// Search move.
-		if (!posMakeMove(node->pos, move))
+		if (!posMakeMoveUnchecked(node->pos, move))
 			continue;
-		child.inCheck=posIsSTMInCheck(node->pos);
+		child.inCheck=posIsSTMInCheck(child.pos);
 		Score score=-searchQNode(&child);
 		posUndoMove(node->pos);
 
 		// Out of time? (previous search result is invalid).
-		if (searchIsTimeUp())
+		if (searchIsTimeUp(search))
 			return;
 
 		// We have a legal move.
@@ -870,64 +1031,65 @@ void searchQNodeInternal(Node *node) {
 	return;
 }
 
-bool searchIsTimeUp(void) {
+bool searchIsTimeUp(Search *search) {
 	// If stop flag is set we are expected to quit as soon as possible.
-	if (searchStopFlag)
+	if (search->stopFlag)
 		return true;
 
 	// Check node count.
-	if (searchNodeCount>=searchLimit.nodes)
+	if (search->nodeCount>=search->limit.nodes)
 		goto timeup;
 
 	// Time to check the real clock?
-	if (searchNodeCount>=searchNodeNext) {
+	if (search->nodeCount>=search->nodeNext) {
 		// Is time up? (want to return asap).
 		TimeMs currTime=timeGet();
-		if (currTime>=searchEndTime)
+		if (currTime>=search->endTime)
 			goto timeup;
 
 		// Print regular debugging information every so often.
-		if (currTime>=searchNextRegularOutputTime) {
-			searchOutputRegular();
-			searchNextRegularOutputTime=currTime+1000;
+		if (currTime>=search->nextRegularOutputTime) {
+			searchOutputRegular(search);
+			search->nextRegularOutputTime=currTime+1000;
 		}
 
-		// Update searchNodeNext to check again in the future.
-		if (currTime>searchLimit.startTime) {
+		// Update search->nodeNext to check again in the future.
+		if (currTime>search->limit.startTime) {
 			// Aim to check again 50% through our remaining time for this move.
 			// So if, for example, we allocated 16s for the current search, and have
 			// already used 12s, we aim to check again at 14s (12+(16-12)/2).
 			// We use the node counter and previous nps as a rough timer to avoid
 			// checking the real time too often.
-			TimeMs timeDelay=64*utilMin(searchEndTime-currTime, 2*1000); // We /128 later to avoid losing accuracy. Also limit to 1s.
-			unsigned long long int nodeDelay=(searchNodeCount*timeDelay)/(128*(currTime-searchLimit.startTime));
-			searchNodeNext=searchNodeCount+nodeDelay;
+			TimeMs timeDelay=64*utilMin(search->endTime-currTime, 2*1000); // We /128 later to avoid losing accuracy. Also limit to 1s.
+			unsigned long long int nodeDelay=(search->nodeCount*timeDelay)/(128*(currTime-search->limit.startTime));
+			search->nodeNext=search->nodeCount+nodeDelay;
 		} else
 			// No time passed yet since we started searching, check again later.
-			searchNodeNext*=2;
+			search->nodeNext*=2;
 	}
 
 	return false;
 
 	timeup:
-	searchStopInternal();
+	searchStopInternal(search);
 
 	return true;
 }
 
-void searchOutputRegular(void) {
-	if (!searchOutput)
+void searchOutputRegular(Search *search) {
+	if (!search->output)
 		return;
 
-	TimeMs time=timeGet()-searchLimit.startTime;
-	uciWrite("info nodes %llu time %llu", (unsigned long long int)searchNodeCount, (unsigned long long int)time);
+	TimeMs time=timeGet()-search->limit.startTime;
+	uciWrite("info nodes %llu time %llu", (unsigned long long int)search->nodeCount, (unsigned long long int)time);
 	if (time>0)
-		uciWrite(" nps %llu", (searchNodeCount*1000llu)/time);
-	uciWrite(" hashfull %u\n", ttFull());
+		uciWrite(" nps %llu", (search->nodeCount*1000llu)/time);
+	uciWrite(" hashfull %u\n", ttFull(search->tt));
 }
 
 void searchOutputDepthPre(Node *node) {
-	if (!searchOutput)
+	Search *search=node->search;
+	if (!search->output)
 		return;
 
 	uciWrite("info depth %u\n", (unsigned int)node->depth);
@@ -937,25 +1099,26 @@ void searchOutputDepthPost(Node *node) {
 	assert(scoreIsValid(node->score));
 	assert(node->bound!=BoundNone);
 
-	if (!searchOutput)
+	Search *search=node->search;
+	if (!search->output)
 		return;
 
 	// Various bits of data
-	TimeMs time=timeGet()-searchLimit.startTime;
-	uciWrite("info depth %u score %s nodes %llu time %llu", (unsigned int)node->depth, SCORETOSTR(node->score, node->bound), searchNodeCount, (unsigned long long int)time);
+	TimeMs time=timeGet()-search->limit.startTime;
+	uciWrite("info depth %u score %s nodes %llu time %llu", (unsigned int)node->depth, SCORETOSTR(node->score, node->bound), search->nodeCount, (unsigned long long int)time);
 	if (time>0)
-		uciWrite(" nps %llu", (searchNodeCount*1000llu)/time);
+		uciWrite(" nps %llu", (search->nodeCount*1000llu)/time);
 
 	// PV (extracted from array and also potentially the TT)
 	uciWrite(" pv");
 	unsigned int ply=0;
-	while(ply<node->depth && searchPv[0][ply]!=MoveInvalid) {
+	while(ply<node->depth && search->pv[0][ply]!=MoveInvalid) {
 		// Compute move string before we make the move.
 		char str[32];
-		posMoveToStr(node->pos, searchPv[0][ply], str);
+		posMoveToStr(node->pos, search->pv[0][ply], str);
 
 		// Make move.
-		if (!posMakeMove(node->pos, searchPv[0][ply]))
+		if (!posMakeMove(node->pos, search->pv[0][ply]))
 			break;
 		++ply;
 
@@ -969,7 +1132,7 @@ void searchOutputDepthPost(Node *node) {
 
 	while(ply<node->depth) {
 		// Attempt to read move from TT
-		Move move=ttReadMove(node->pos, ply);
+		Move move=ttReadMove(search->tt, node->pos, ply);
 		if (move==MoveInvalid)
 			break;
 
@@ -1095,7 +1258,7 @@ bool searchInteriorRecog(Node *node) {
 	}
 
 	// Special material combination recognizers.
-	switch(evalGetMatType(node->pos)) {
+	switch(evalGetMatType(node->search->eval, node->pos)) {
 		case EvalMatTypeKNNvK: if (searchInteriorRecogKNNvK(node)) return true; break;
 		case EvalMatTypeKPvK: if (searchInteriorRecogKPvK(node)) return true; break;
 		case EvalMatTypeKBPvK: if (searchInteriorRecogKBPvK(node)) return true; break;
@@ -1148,7 +1311,7 @@ bool searchInteriorRecogBlocked(Node *node) {
 		// This is a bitboard with 1s for all squares the pieces can move to with
 		// any number of steps, but without moving from an 'occupied' square.
 		BB attackers=posGetBBPiece(pos, pieceMake(type, atk));
-		BB fill=searchFill(type, attackers, fillOcc, target);
+		BB fill=fillReach(type, attackers, fillOcc, target);
 		if ((fill & target)!=BBNone)
 			return false;
 		atkInfluence|=fill;
@@ -1171,7 +1334,7 @@ bool searchInteriorRecogBlocked(Node *node) {
 
 	// King fill.
 	BB atkKing=posGetBBPiece(pos, pieceMake(PieceTypeKing, atk));
-	BB fill=searchFill(PieceTypeKing, atkKing, (defAttacks | atkPawns), target);
+	BB fill=fillReach(PieceTypeKing, atkKing, (defAttacks | atkPawns), target);
 	if ((fill & target)!=BBNone)
 		return false;
 	atkInfluence|=fill;
@@ -1253,34 +1416,6 @@ bool searchInteriorRecogKBPvK(Node *node) {
 	return false;
 }
 
-BB searchFill(PieceType type, BB init, BB occ, BB target) {
-	assert(type>=PieceTypeKnight && type<=PieceTypeKing);
-
-	BB fill=init;
-	BB done=occ;
-	BB todo=init;
-	while(todo!=BBNone) {
-		assert((done & todo)==BBNone);
-
-		// Choose a new square to generate the moves for.
-		Sq sq=bbScanReset(&todo);
-
-		// Mark this square as done.
-		done|=bbSq(sq);
-
-		// Hit target?
-		BB attacks=attacksPieceType(type, sq, occ);
-		if ((attacks & target)!=BBNone)
-			return attacks;
-
-		// Add attacks from this square to 'todo' list (if not already done).
-		todo|=(attacks & ~done);
-		fill|=attacks;
-	}
-
-	return fill;
-}
-
 bool searchNodeIsPV(const Node *node) {
 	return (node->beta-node->alpha>1);
 }
@@ -1289,6 +1424,14 @@ bool searchNodeIsQ(const Node *node) {
 	return node->depth<1;
 }
 
+const SearchParams *searchGetParams(const Search *search) {
+#	ifdef TUNE
+	return search->params;
+#	else
+	return &searchParams;
+#	endif
+}
+
 void searchInterfacePonder(void *dummy, bool ponder) {
 	searchPonder=ponder;
 }
@@ -1299,7 +1442,7 @@ void searchInterfaceSpinValue(void *ptr, long long value) {
 	*((int *)ptr)=value;
 
 	// Clear now-invalid TT and history etc.
-	searchClear();
+	searchClear(searchMain);
 }
 
 void searchInterfaceCheckValue(void *ptr, bool value) {
@@ -1307,6 +1450,6 @@ void searchInterfaceCheckValue(void *ptr, bool value) {
 	*((bool *)ptr)=value;
 
 	// Clear now-invalid TT and history etc.
-	searchClear();
+	searchClear(searchMain);
 }
 #endif
@@ -4,14 +4,17 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+typedef struct Search Search;
+
+#include "bound.h"
 #include "depth.h"
+#include "eval.h"
 #include "move.h"
 #include "pos.h"
+#include "score.h"
 #include "scoredmove.h"
 #include "time.h"
-
-#define DateBit 6 // Number of bits searchGetDate() will actually use in its return value.
-#define DateMax (1u<<DateBit)
+#include "tt.h"
 
 // Entries should be considered private - only here to allow easy allocation on the stack.
 // Use searchLimit* functions instead.
@@ -26,23 +29,36 @@ typedef struct {
 	Move searchMoves[MovesMax], *searchMovesNext;
 } SearchLimit;
 
-void searchInit(void);
+typedef void (SearchDepthCallback)(void *userData, Depth depth, Score score, Bound bound, const Move *pv, unsigned int pvLength, unsigned long long int nodes, TimeMs time); // pv[0] is the best move.
+
+void searchInit(void); // Also creates the context used by the UCI engine (see searchThink() and searchGetMain()).
 void searchQuit(void);
 
-void searchThink(const Pos *pos, const SearchLimit *limit, bool output);
+Search *searchNew(void); // Additional context, e.g. for running searches in parallel. Uses the UCI engine's Hash size (and in tuning builds, values) until changed by searchSetOption(). Returns NULL on failure.
+void searchFree(Search *search);
+
+bool searchSetOption(Search *search, const char *name, const char *value); // As for the UCI option of the same name but only affecting search (returns false if not supported).
+
+void searchRun(Search *search, const Pos *pos, const SearchLimit *limit, SearchDepthCallback *callback, void *userData); // Searches on the calling thread without any UCI output. callback (if not NULL) is called after each completed iteration, with time measured from the limit's startTime.
+
+void searchThink(const Pos *pos, const SearchLimit *limit, bool output); // Searches using the UCI engine's context, on its own thread.
 void searchStopAndWait(void); // Instruct search to stop as soon as possible and wait for it to finish.
 void searchWait(void); // Wait for search to finish (but do not instruct it to stop immediately if still thinking).
 
-unsigned long long int searchBenchmark(const Pos *pos, Depth depth);
+unsigned long long int searchBenchmark(Search *search, const Pos *pos, Depth depth); // Searches on the calling thread, returning the node count.
 
-void searchClear(void); // Clear any data search has collected (e.g. history tables).
+void searchClear(Search *search); // Clear any data search has collected (e.g. history and hash tables).
 
 void searchPonderHit(void); // Tell the search our pondering guess was correct.
 
-MoveScore searchScoreMove(const Pos *pos, Move move);
+Search *searchGetMain(void); // The UCI engine's context.
+Eval *searchGetEval(Search *search);
+TT *searchGetTT(Search *search);
+
+MoveScore searchScoreMove(const Search *search, const Pos *pos, Move move); // search can be NULL to score without history.
+const Move *searchGetKillers(const Search *search, Depth ply); // See killersGet().
 
-unsigned int searchGetDate(void);
-unsigned int searchDateToAge(unsigned int date);
+unsigned long long int searchGetNodeCount(const Search *search); // Nodes entered by the last (or current) search.
 
 void searchLimitInit(SearchLimit *limit, TimeMs startTime); // startTime should be as close as possible to the time we received the 'go' command.
 void searchLimitSetInfinite(SearchLimit *limit, bool infinite); // From 'infinite' or 'ponder'.
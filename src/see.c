@@ -84,6 +84,57 @@ int seeSign(const Pos *pos, Sq fromSq, Sq toSq) {
 	return see(pos, fromSq, toSq);
 }
 
+bool seeGE(const Pos *pos, Sq fromSq, Sq toSq, int threshold) {
+	PieceType attackerType=pieceGetType(posGetPieceOnSq(pos, fromSq));
+	PieceType victimType=pieceGetType(posGetPieceOnSq(pos, toSq));
+	Colour stm=posGetSTM(pos);
+	assert(pieceTypeIsValid(attackerType));
+	assert(pieceTypeIsValid(victimType));
+
+	// Below threshold even if the capture is free?
+	int swap=seePieceValue[victimType]-threshold;
+	if (swap<0)
+		return false;
+
+	// Still at or above threshold even if we lose the capturing piece?
+	swap=seePieceValue[attackerType]-swap;
+	if (swap<=0)
+		return true;
+
+	BB occ=posGetBBAll(pos);
+	BB atkDef=seeAttacksTo(pos, toSq, occ);
+	BB fromSet=bbSq(fromSq);
+
+	BB mayXRay=occ^posGetBBPiece(pos, PieceWKnight)^posGetBBPiece(pos, PieceWKing)^
+	               posGetBBPiece(pos, PieceBKnight)^posGetBBPiece(pos, PieceBKing);
+
+	// Each side recaptures in turn with its least valuable piece, until one side
+	// cannot recapture or does not need to (result is then known).
+	bool result=true;
+	while(1) {
+		// 'Capture'.
+		occ^=fromSet; // Remove piece from occupancy.
+		atkDef^=fromSet; // Remove piece from attacks & defenders list.
+		stm=colourSwap(stm); // Swap colour.
+
+		// Add any new attacks needed.
+		if (fromSet & mayXRay)
+			atkDef|=seeAttacksTo(pos, toSq, occ);
+
+		// Look for next attacker.
+		fromSet=seeGetLeastValuable(pos, atkDef, stm, &attackerType);
+		if (fromSet==BBNone)
+			break;
+
+		result=!result;
+		swap=seePieceValue[attackerType]-swap;
+		if (swap<(int)result)
+			break;
+	}
+
+	return result;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Private Functions.
 ////////////////////////////////////////////////////////////////////////////////
@@ -1,10 +1,13 @@
 #ifndef SEE_H
 #define SEE_H
 
+#include <stdbool.h>
+
 #include "pos.h"
 #include "square.h"
 
 int see(const Pos *pos, Sq fromSq, Sq toSq);
 int seeSign(const Pos *pos, Sq fromSq, Sq toSq);
+bool seeGE(const Pos *pos, Sq fromSq, Sq toSq, int threshold); // Does the capture gain at least threshold? Stops as soon as the answer is known, so cheaper than see().
 
 #endif
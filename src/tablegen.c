@@ -0,0 +1,242 @@
+#include <assert.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "attacks.h"
+#include "bb.h"
+#include "bitbase.h"
+#include "eval.h"
+#include "magicmoves.h"
+#include "main.h"
+#include "pos.h"
+#include "uci.h"
+
+// Table generator, run as part of the build (see the Makefile and tables.h).
+// This is built from the same sources as the engine but without TABLES
+// defined, so after the usual initialisation all derived tables have been
+// computed and can simply be written out as C source.
+
+#ifdef TABLES
+#	error tablegen must be built without TABLES defined
+#endif
+
+extern BB BBPawnSq[SqNB], BBBetween[SqNB][SqNB], BBBeyond[SqNB][SqNB];
+extern BB attacksArrayKnight[SqNB], attacksArrayKing[SqNB];
+extern U64 magicmovesbdb[5248], magicmovesrdb[102400];
+#ifdef ATTACKSPEXT
+#ifdef ATTACKSPEXT16
+extern uint16_t attacksPextBishopDB[5248], attacksPextRookDB[102400];
+#else
+extern BB attacksPextBishopDB[5248], attacksPextRookDB[102400];
+#endif
+extern unsigned attacksPextBishopOffset[SqNB], attacksPextRookOffset[SqNB];
+extern BB attacksPextBishopLine[SqNB], attacksPextRookLine[SqNB];
+#endif
+extern uint64_t *bitbase;
+extern Key posKeySTM, posKeyPiece[16][SqNB], posKeyEP[SqMax], posKeyCastling[SqMax];
+extern Key posPawnKeyPiece[PieceNB][SqNB];
+extern Key posMatKey[PieceNB];
+
+#define TableGenDimMax 4
+
+typedef void (TableGenPrintFunction)(FILE *file, const void *element);
+
+////////////////////////////////////////////////////////////////////////////////
+// Private prototypes.
+////////////////////////////////////////////////////////////////////////////////
+
+void tablegenWrite(FILE *file, const char *type, const char *name, const void *data, size_t elementSize, TableGenPrintFunction *print, unsigned dimCount, ...); // dimCount dimensions (as size_t) follow.
+void tablegenWriteMember(FILE *file, const char *name, const void *data, size_t elementSize, TableGenPrintFunction *print, unsigned dimCount, ...); // As tablegenWrite() but for a struct member (using a designated initialiser).
+const void *tablegenWriteRaw(FILE *file, const void *data, size_t elementSize, TableGenPrintFunction *print, unsigned dimCount, const size_t *dims, unsigned depth);
+
+void tablegenWriteIndent(FILE *file, unsigned depth); // Starts a new line.
+
+void tablegenPrintU64(FILE *file, const void *element);
+void tablegenPrintVPacked(FILE *file, const void *element);
+void tablegenPrintInt(FILE *file, const void *element);
+void tablegenPrintUInt(FILE *file, const void *element);
+void tablegenPrintUInt8(FILE *file, const void *element);
+void tablegenPrintUInt16(FILE *file, const void *element);
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions.
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv) {
+	if (argc!=2)
+		mainFatalError("Usage: %s output-file\n", argv[0]);
+
+	// Compute tables in the usual way.
+	uciInit();
+	bbInit();
+	attacksInit();
+	bitbaseInit();
+	posInit();
+	evalInit();
+
+	// Write them out.
+	FILE *file=fopen(argv[1], "w");
+	if (file==NULL)
+		mainFatalError("Error: Could not open '%s' for writing.\n", argv[1]);
+
+	fprintf(file, "// Generated by tablegen, do not edit.\n\n");
+	fprintf(file, "#include <stdint.h>\n\n");
+	fprintf(file, "#include \"bb.h\"\n");
+	fprintf(file, "#include \"eval.h\"\n");
+	fprintf(file, "#include \"magicmoves.h\"\n");
+	fprintf(file, "#include \"pos.h\"\n\n");
+	fprintf(file, "#ifdef TABLES\n\n");
+
+	tablegenWrite(file, "BB", "BBPawnSq", BBPawnSq, sizeof(BB), &tablegenPrintU64, 1, (size_t)SqNB);
+	tablegenWrite(file, "BB", "BBBetween", BBBetween, sizeof(BB), &tablegenPrintU64, 2, (size_t)SqNB, (size_t)SqNB);
+	tablegenWrite(file, "BB", "BBBeyond", BBBeyond, sizeof(BB), &tablegenPrintU64, 2, (size_t)SqNB, (size_t)SqNB);
+
+	tablegenWrite(file, "BB", "attacksArrayKnight", attacksArrayKnight, sizeof(BB), &tablegenPrintU64, 1, (size_t)SqNB);
+	tablegenWrite(file, "BB", "attacksArrayKing", attacksArrayKing, sizeof(BB), &tablegenPrintU64, 1, (size_t)SqNB);
+	tablegenWrite(file, "U64", "magicmovesbdb", magicmovesbdb, sizeof(U64), &tablegenPrintU64, 1, (size_t)5248);
+	tablegenWrite(file, "U64", "magicmovesrdb", magicmovesrdb, sizeof(U64), &tablegenPrintU64, 1, (size_t)102400);
+#	ifdef ATTACKSPEXT
+#	ifdef ATTACKSPEXT16
+	tablegenWrite(file, "uint16_t", "attacksPextBishopDB", attacksPextBishopDB, sizeof(uint16_t), &tablegenPrintUInt16, 1, (size_t)5248);
+	tablegenWrite(file, "uint16_t", "attacksPextRookDB", attacksPextRookDB, sizeof(uint16_t), &tablegenPrintUInt16, 1, (size_t)102400);
+#	else
+	tablegenWrite(file, "BB", "attacksPextBishopDB", attacksPextBishopDB, sizeof(BB), &tablegenPrintU64, 1, (size_t)5248);
+	tablegenWrite(file, "BB", "attacksPextRookDB", attacksPextRookDB, sizeof(BB), &tablegenPrintU64, 1, (size_t)102400);
+#	endif
+	tablegenWrite(file, "BB", "attacksPextBishopLine", attacksPextBishopLine, sizeof(BB), &tablegenPrintU64, 1, (size_t)SqNB);
+	tablegenWrite(file, "BB", "attacksPextRookLine", attacksPextRookLine, sizeof(BB), &tablegenPrintU64, 1, (size_t)SqNB);
+	tablegenWrite(file, "unsigned", "attacksPextBishopOffset", attacksPextBishopOffset, sizeof(unsigned), &tablegenPrintUInt, 1, (size_t)SqNB);
+	tablegenWrite(file, "unsigned", "attacksPextRookOffset", attacksPextRookOffset, sizeof(unsigned), &tablegenPrintUInt, 1, (size_t)SqNB);
+#	endif
+
+	tablegenWrite(file, "uint64_t", "bitbase", bitbase, sizeof(uint64_t), &tablegenPrintU64, 1, (size_t)((FileNB/2)*RankNB*SqNB*ColourNB));
+
+	tablegenWrite(file, "Key", "posKeySTM", &posKeySTM, sizeof(Key), &tablegenPrintU64, 0);
+	tablegenWrite(file, "Key", "posKeyPiece", posKeyPiece, sizeof(Key), &tablegenPrintU64, 2, (size_t)16, (size_t)SqNB);
+	tablegenWrite(file, "Key", "posKeyEP", posKeyEP, sizeof(Key), &tablegenPrintU64, 1, (size_t)SqMax);
+	tablegenWrite(file, "Key", "posKeyCastling", posKeyCastling, sizeof(Key), &tablegenPrintU64, 1, (size_t)SqMax);
+	tablegenWrite(file, "Key", "posPawnKeyPiece", posPawnKeyPiece, sizeof(Key), &tablegenPrintU64, 2, (size_t)PieceNB, (size_t)SqNB);
+	tablegenWrite(file, "Key", "posMatKey", posMatKey, sizeof(Key), &tablegenPrintU64, 1, (size_t)PieceNB);
+
+	fprintf(file, "const EvalTables evalTables={\n");
+	tablegenWriteMember(file, "pst", evalTables.pst, sizeof(VPacked), &tablegenPrintVPacked, 2, (size_t)PieceNB, (size_t)SqNB);
+	tablegenWriteMember(file, "pawnValue", evalTables.pawnValue, sizeof(VPacked), &tablegenPrintVPacked, 3, (size_t)ColourNB, (size_t)16, (size_t)SqNB);
+	tablegenWriteMember(file, "halfMoveFactors", evalTables.halfMoveFactors, sizeof(int), &tablegenPrintInt, 1, (size_t)128);
+	tablegenWriteMember(file, "weightEGFactors", evalTables.weightEGFactors, sizeof(uint8_t), &tablegenPrintUInt8, 1, (size_t)128);
+	tablegenWriteMember(file, "kingNearPasser", evalTables.kingNearPasser, sizeof(VPacked), &tablegenPrintVPacked, 1, (size_t)8);
+	fprintf(file, "};\n\n");
+
+	fprintf(file, "#endif\n");
+
+	if (ferror(file) | (fclose(file)!=0)) {
+		remove(argv[1]);
+		mainFatalError("Error: Could not write '%s'.\n", argv[1]);
+	}
+
+	bitbaseQuit();
+
+	return EXIT_SUCCESS;
+}
+
+void mainFatalError(const char *format, ...) {
+	va_list ap;
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+	exit(EXIT_FAILURE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions.
+////////////////////////////////////////////////////////////////////////////////
+
+void tablegenWrite(FILE *file, const char *type, const char *name, const void *data, size_t elementSize, TableGenPrintFunction *print, unsigned dimCount, ...) {
+	assert(dimCount<=TableGenDimMax);
+
+	// Collect dimensions.
+	size_t dims[TableGenDimMax];
+	va_list ap;
+	va_start(ap, dimCount);
+	for(unsigned i=0; i<dimCount; ++i)
+		dims[i]=va_arg(ap, size_t);
+	va_end(ap);
+
+	// Write declaration and initialiser.
+	fprintf(file, "const %s %s", type, name);
+	for(unsigned i=0; i<dimCount; ++i)
+		fprintf(file, "[%zu]", dims[i]);
+	fprintf(file, "=");
+	tablegenWriteRaw(file, data, elementSize, print, dimCount, dims, 0);
+	fprintf(file, ";\n\n");
+}
+
+void tablegenWriteMember(FILE *file, const char *name, const void *data, size_t elementSize, TableGenPrintFunction *print, unsigned dimCount, ...) {
+	assert(dimCount<=TableGenDimMax);
+
+	// Collect dimensions.
+	size_t dims[TableGenDimMax];
+	va_list ap;
+	va_start(ap, dimCount);
+	for(unsigned i=0; i<dimCount; ++i)
+		dims[i]=va_arg(ap, size_t);
+	va_end(ap);
+
+	// Write designator and initialiser.
+	fprintf(file, "\t.%s=", name);
+	tablegenWriteRaw(file, data, elementSize, print, dimCount, dims, 1);
+	fprintf(file, ",\n");
+}
+
+const void *tablegenWriteRaw(FILE *file, const void *data, size_t elementSize, TableGenPrintFunction *print, unsigned dimCount, const size_t *dims, unsigned depth) {
+	// Single element?
+	if (dimCount==0) {
+		print(file, data);
+		return ((const uint8_t *)data)+elementSize;
+	}
+
+	// Otherwise write each sub-array in turn (four elements per line for the innermost dimension).
+	fprintf(file, "{");
+	for(size_t i=0; i<dims[0]; ++i) {
+		if (dimCount>1 || i%4==0)
+			tablegenWriteIndent(file, depth+1);
+		data=tablegenWriteRaw(file, data, elementSize, print, dimCount-1, dims+1, depth+1);
+		fprintf(file, ",");
+	}
+	tablegenWriteIndent(file, depth);
+	fprintf(file, "}");
+
+	return data;
+}
+
+void tablegenWriteIndent(FILE *file, unsigned depth) {
+	fprintf(file, "\n");
+	while(depth-->0)
+		fprintf(file, "\t");
+}
+
+void tablegenPrintU64(FILE *file, const void *element) {
+	fprintf(file, "0x%016llXllu", (unsigned long long)*(const uint64_t *)element);
+}
+
+void tablegenPrintVPacked(FILE *file, const void *element) {
+	VPacked vpacked=*(const VPacked *)element;
+	fprintf(file, "VPACKED(%i,%i)", evalVPackedMg(vpacked), evalVPackedEg(vpacked));
+}
+
+void tablegenPrintInt(FILE *file, const void *element) {
+	fprintf(file, "%i", *(const int *)element);
+}
+
+void tablegenPrintUInt(FILE *file, const void *element) {
+	fprintf(file, "%uu", *(const unsigned *)element);
+}
+
+void tablegenPrintUInt8(FILE *file, const void *element) {
+	fprintf(file, "%u", (unsigned)*(const uint8_t *)element);
+}
+
+void tablegenPrintUInt16(FILE *file, const void *element) {
+	fprintf(file, "%u", (unsigned)*(const uint16_t *)element);
+}
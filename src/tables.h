@@ -0,0 +1,19 @@
+#ifndef TABLES_H
+#define TABLES_H
+
+// If TABLES is defined (as it is for all non-tuning builds, see the Makefile)
+// derived lookup tables such as attack sets, hash keys and PSTs are computed at
+// build time by tablegen and compiled into tables.c as constant data, rather
+// than being computed at startup.
+
+#if defined(TABLES) && defined(TUNE)
+#	error TABLES and TUNE cannot be used together (tuning requires derived tables to be recomputed at runtime)
+#endif
+
+#ifdef TABLES
+#	define TABLECONST const
+#else
+#	define TABLECONST
+#endif
+
+#endif
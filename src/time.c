@@ -10,3 +10,9 @@ TimeMs timeGet(void) {
 	gettimeofday(&tp, NULL);
 	return tp.tv_sec*1000llu+tp.tv_usec/1000llu;
 }
+
+TimeUs timeGetUs(void) {
+	struct timeval tp;
+	gettimeofday(&tp, NULL);
+	return tp.tv_sec*1000000llu+tp.tv_usec;
+}
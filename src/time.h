@@ -6,4 +6,7 @@ extern const TimeMs TimeMsInvalid;
 
 TimeMs timeGet(void);
 
+typedef unsigned long long int TimeUs;
+TimeUs timeGetUs(void); // As timeGet() but in microseconds (for benchmarking).
+
 #endif
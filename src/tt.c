@@ -3,12 +3,13 @@
 #include <stdlib.h>
 
 #include "htable.h"
-#include "main.h"
-#include "search.h"
 #include "tt.h"
 #include "uci.h"
 #include "util.h"
 
+#define DateBit 6 // Number of bits used to store dates in entries.
+#define DateMax (1u<<DateBit)
+
 // Transposition table entry - 64 bits.
 STATICASSERT(MoveBit<=16);
 STATICASSERT(ScoreBit<=16);
@@ -32,9 +33,12 @@ typedef struct {
 	TTEntry entries[ttClusterSize];
 } TTCluster;
 
-HTable *tt=NULL;
+struct TT {
+	HTable *table;
+	unsigned int date; // Incremented (modulo DateMax) by ttAge() after each search.
+};
 
-const size_t ttDefaultSizeMb=16;
+const unsigned int ttDefaultSizeMb=16;
 #define ttMaxClusters HTableMaxEntryCount // 2^32
 #define ttMaxEntries (ttMaxClusters*ttClusterSize) // 2^34
 const size_t ttMaxSizeMb=(ttMaxClusters*sizeof(TTCluster))/(1024*1024); // 128gb
@@ -43,6 +47,11 @@ const size_t ttMaxSizeMb=(ttMaxClusters*sizeof(TTCluster))/(1024*1024); // 128gb
 // Private prototypes.
 ////////////////////////////////////////////////////////////////////////////////
 
+void ttResizeInterface(void *tt, long long int sizeMb);
+void ttClearInterface(void *tt);
+
+unsigned int ttDateToAge(const TT *tt, unsigned int date);
+
 bool ttEntryMatch(const Pos *pos, const TTEntry *entry);
 bool ttEntryUnused(const TTEntry *entry);
 
@@ -57,30 +66,56 @@ HTableKey ttHTableKeyFromPos(const Pos *pos);
 // Public functions.
 ////////////////////////////////////////////////////////////////////////////////
 
-void ttInit(void) {
-	// Setup tt as a HTable.
-	tt=htableNew(sizeof(TTCluster), ttDefaultSizeMb);
+TT *ttNew(unsigned int sizeMb) {
+	TT *tt=malloc(sizeof(TT));
+	if (tt==NULL)
+		return NULL;
+
+	// Setup table as a HTable.
+	tt->table=htableNew(sizeof(TTCluster), sizeMb);
+	if (tt->table==NULL) {
+		free(tt);
+		return NULL;
+	}
+	tt->date=0;
+
+	return tt;
+}
+
+void ttFree(TT *tt) {
 	if (tt==NULL)
-		mainFatalError("Error: Could not allocate transposition table.\n");
+		return;
+	htableFree(tt->table);
+	free(tt);
+}
 
+void ttOptionsNew(TT *tt) {
 	// Add uci options to change size and clear.
-	uciOptionNewSpin("Hash", &htableResizeInterface, tt, 1, ttMaxSizeMb, ttDefaultSizeMb);
-	uciOptionNewButton("Clear Hash", &htableClearInterface, tt);
+	uciOptionNewSpin("Hash", &ttResizeInterface, tt, 1, ttMaxSizeMb, ttDefaultSizeMb);
+	uciOptionNewButton("Clear Hash", &ttClearInterface, tt);
 }
 
-void ttQuit(void) {
-	htableFree(tt);
-	tt=NULL;
+void ttClear(TT *tt) {
+	htableClear(tt->table);
+	tt->date=0;
 }
 
-void ttClear(void) {
-	htableClear(tt);
+void ttAge(TT *tt) {
+	tt->date=(tt->date+1)%DateMax;
 }
 
-bool ttRead(const Pos *pos, Depth ply, Move *move, Depth *depth, Score *score, Bound *bound) {
+bool ttResize(TT *tt, unsigned int sizeMb) {
+	return htableResize(tt->table, sizeMb);
+}
+
+unsigned int ttGetSizeMb(const TT *tt) {
+	return htableGetSize(tt->table)/(1024*1024);
+}
+
+bool ttRead(TT *tt, const Pos *pos, Depth ply, Move *move, Depth *depth, Score *score, Bound *bound) {
 	// Grab cluster.
 	HTableKey hTableKey=ttHTableKeyFromPos(pos);
-	TTCluster *cluster=htableGrab(tt, hTableKey);
+	TTCluster *cluster=htableGrab(tt->table, hTableKey);
 
 	// Loop over entries in cluster looking for a match.
 	unsigned int i;
@@ -88,7 +123,7 @@ bool ttRead(const Pos *pos, Depth ply, Move *move, Depth *depth, Score *score, B
 	for(i=0,entry=cluster->entries;i<ttClusterSize;++i,++entry)
 		if (ttEntryMatch(pos, entry)) {
 			// Update entry date (to reset age to 0).
-			entry->date=searchGetDate();
+			entry->date=tt->date;
 
 			// Extract information.
 			*move=entry->move;
@@ -96,17 +131,17 @@ bool ttRead(const Pos *pos, Depth ply, Move *move, Depth *depth, Score *score, B
 			*score=ttScoreOut(entry->score, ply);
 			*bound=entry->bound;
 
-			htableRelease(tt, hTableKey);
+			htableRelease(tt->table, hTableKey);
 
 			return true;
 		}
 
 	// No match.
-	htableRelease(tt, hTableKey);
+	htableRelease(tt->table, hTableKey);
 	return false;
 }
 
-Move ttReadMove(const Pos *pos, Depth ply) {
+Move ttReadMove(TT *tt, const Pos *pos, Depth ply) {
 	// Sanity checks.
 	assert(depthIsValid(ply));
 
@@ -114,11 +149,11 @@ Move ttReadMove(const Pos *pos, Depth ply) {
 	Depth dummyDepth;
 	Score dummyScore;
 	Bound dummyBound;
-	ttRead(pos, ply, &move, &dummyDepth, &dummyScore, &dummyBound);
+	ttRead(tt, pos, ply, &move, &dummyDepth, &dummyScore, &dummyBound);
 	return move;
 }
 
-void ttWrite(const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bound bound) {
+void ttWrite(TT *tt, const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bound bound) {
 	// Sanity checks.
 	assert(depthIsValid(ply));
 	assert(depthIsValid(depth));
@@ -130,7 +165,7 @@ void ttWrite(const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bou
 
 	// Grab cluster.
 	HTableKey hTableKey=ttHTableKeyFromPos(pos);
-	TTCluster *cluster=htableGrab(tt, hTableKey);
+	TTCluster *cluster=htableGrab(tt->table, hTableKey);
 
 	// Find entry to overwrite.
 	TTEntry *entry, *replace=cluster->entries;
@@ -145,7 +180,7 @@ void ttWrite(const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bou
 			entry->keyUpper=(key>>48);
 
 			// Update entry date (to reset age to 0).
-			entry->date=searchGetDate();
+			entry->date=tt->date;
 
 			// Update move if we have one and it is from a deeper search (or no move already stored).
 			if (!moveIsValid(entry->move) || (moveIsValid(move) && depth>=entry->depth))
@@ -158,12 +193,12 @@ void ttWrite(const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bou
 				entry->bound=bound;
 			}
 
-			htableRelease(tt, hTableKey);
+			htableRelease(tt->table, hTableKey);
 			return;
 		}
 
 		// Otherwise check if entry is better to use than replace.
-		unsigned int entryScore=ttEntryFitness(searchDateToAge(entry->date), entry->depth, (entry->bound==BoundExact));
+		unsigned int entryScore=ttEntryFitness(ttDateToAge(tt, entry->date), entry->depth, (entry->bound==BoundExact));
 		if (entryScore>replaceScore) {
 			replace=entry;
 			replaceScore=entryScore;
@@ -176,24 +211,24 @@ void ttWrite(const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bou
 	replace->score=ttScoreIn(score, ply);
 	replace->depth=depth;
 	replace->bound=bound;
-	replace->date=searchGetDate();
+	replace->date=tt->date;
 
-	htableRelease(tt, hTableKey);
+	htableRelease(tt->table, hTableKey);
 }
 
-unsigned int ttFull(void) {
+unsigned int ttFull(TT *tt) {
 	unsigned total=0;
 
 	unsigned checked=0;
 	size_t index, indexDelta=ttMaxClusters/1000;
 	for(index=0;checked<1000;index+=indexDelta) {
-		TTCluster *cluster=htableGrab(tt, index);
+		TTCluster *cluster=htableGrab(tt->table, index);
 
 		unsigned entry;
 		for(entry=0; entry<ttClusterSize && checked<1000; ++entry,++checked)
 			total+=(!ttEntryUnused(&cluster->entries[entry]));
 
-		htableRelease(tt, index);
+		htableRelease(tt->table, index);
 	}
 
 	return total;
@@ -203,6 +238,18 @@ unsigned int ttFull(void) {
 // Private functions.
 ////////////////////////////////////////////////////////////////////////////////
 
+void ttResizeInterface(void *tt, long long int sizeMb) {
+	ttResize(tt, sizeMb);
+}
+
+void ttClearInterface(void *tt) {
+	ttClear(tt);
+}
+
+unsigned int ttDateToAge(const TT *tt, unsigned int date) {
+	return (date<=tt->date ? tt->date-date : DateMax+tt->date-date);
+}
+
 bool ttEntryMatch(const Pos *pos, const TTEntry *entry) {
 	// Key match and move psueudo-legal?
 	return (entry->keyUpper==(posGetKey(pos)>>48) && posMoveIsPseudoLegal(pos, entry->move));
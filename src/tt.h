@@ -8,15 +8,25 @@
 #include "pos.h"
 #include "score.h"
 
-void ttInit(void);
-void ttQuit(void);
+typedef struct TT TT;
 
-void ttClear(void);
+extern const unsigned int ttDefaultSizeMb;
 
-bool ttRead(const Pos *pos, Depth ply, Move *move, Depth *depth, Score *score, Bound *bound);
-Move ttReadMove(const Pos *pos, Depth ply); // Either returns move or MoveInvalid if no match found.
-void ttWrite(const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bound bound);
+TT *ttNew(unsigned int sizeMb); // Returns NULL on failure.
+void ttFree(TT *tt);
 
-unsigned int ttFull(void); // Used entries per 1000.
+void ttOptionsNew(TT *tt); // Adds the 'Hash' and 'Clear Hash' UCI options, acting on tt.
+
+void ttClear(TT *tt);
+void ttAge(TT *tt); // Called after each search so that entries from earlier searches are preferred for replacement.
+
+bool ttResize(TT *tt, unsigned int sizeMb); // Also clears the table.
+unsigned int ttGetSizeMb(const TT *tt);
+
+bool ttRead(TT *tt, const Pos *pos, Depth ply, Move *move, Depth *depth, Score *score, Bound *bound);
+Move ttReadMove(TT *tt, const Pos *pos, Depth ply); // Either returns move or MoveInvalid if no match found.
+void ttWrite(TT *tt, const Pos *pos, Depth ply, Depth depth, Move move, Score score, Bound bound);
+
+unsigned int ttFull(TT *tt); // Used entries per 1000.
 
 #endif
@@ -3,13 +3,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "analyse.h"
 #include "benchmark.h"
 #include "bitbase.h"
+#include "book.h"
+#include "datagen.h"
+#include "epd.h"
 #include "eval.h"
 #include "perft.h"
+#include "pgn.h"
 #include "pos.h"
 #include "main.h"
+#include "makebook.h"
+#include "match.h"
 #include "moves.h"
+#include "packed.h"
 #include "search.h"
 #include "see.h"
 #include "time.h"
@@ -197,6 +205,14 @@ void uciLoop(void) {
 				if (!inMoves && utilStrEqual(part, "moves"))
 					inMoves=true;
 				else if (inMoves) {
+					// Keep room for a search on top of the game (only positions since the last capture or pawn move are needed).
+					if (posGetHistoryCount(pos)>=PosGameMax)
+						posDiscardHistory(pos);
+					if (posGetHistoryCount(pos)>=PosGameMax) {
+						uciWrite("Error: Too many moves since the last capture or pawn move (limit %u), ignoring '%s' onwards.\n", PosGameMax, part);
+						break;
+					}
+
 					Move move=posMoveFromStr(pos, part);
 					if (!moveIsValid(move) || !posMakeMove(pos, move))
 						break;
@@ -209,10 +225,9 @@ void uciLoop(void) {
 			uciWrite("readyok\n");
 		else if (utilStrEqual(part, "stop"))
 			searchStopAndWait();
-		else if (utilStrEqual(part, "ucinewgame")) {
-			searchClear();
-			evalClear();
-		} else if (utilStrEqual(part, "setoption")) {
+		else if (utilStrEqual(part, "ucinewgame"))
+			searchClear(searchGetMain());
+		else if (utilStrEqual(part, "setoption")) {
 			part=line+strlen("setoption");
 			uciParseSetOption(part+1);
 		} else if (utilStrEqual(part, "quit"))
@@ -220,15 +235,17 @@ void uciLoop(void) {
 		else if (utilStrEqual(part, "disp")) {
 			posDraw(pos);
 
-			Score evalScore=evaluate(pos);
+			Score evalScore=evaluate(searchGetEval(searchGetMain()), pos);
 			uciWrite("Eval: %s (raw score %i)\n", SCORETOSTR(evalScore, BoundExact), (int)evalScore);
 
-			uciWrite("MatType: %s\n", evalMatTypeToStr(evalGetMatType(pos)));
-		} else if (utilStrEqual(part, "bitbase")) {
-			if (evalGetMatType(pos)==EvalMatTypeKPvK) {
+			uciWrite("MatType: %s\n", evalMatTypeToStr(evalComputeMatType(pos)));
+		} else if (utilStrEqual(part, "evalstats"))
+			evalStatsWrite(searchGetEval(searchGetMain()));
+		else if (utilStrEqual(part, "bitbase")) {
+			if (evalComputeMatType(pos)==EvalMatTypeKPvK) {
 				uciWrite("BitBase:\n");
 				Moves moves;
-				movesInit(&moves, pos, 0, MoveTypeAny);
+				movesInit(&moves, pos, NULL, 0, MoveTypeAny);
 				Move move;
 				while((move=movesNext(&moves))!=MoveInvalid) {
 					char str[8];
@@ -251,9 +268,159 @@ void uciLoop(void) {
 				continue;
 			unsigned int depth=atoi(part);
 			divide(pos, depth);
-		} else if (utilStrEqual(part, "see")) {
+		} else if (utilStrEqual(part, "perftsuite")) {
+			if ((part=strtok_r(NULL, " ", &savePtr))==NULL)
+				continue;
+			// Parse as Chess960 so both Shredder-FEN and X-FEN castling rights work (standard KQkq positions are unaffected).
+			bool chess960=uciChess960;
+			uciChess960=true;
+			perftSuite(part);
+			uciChess960=chess960;
+		} else if (utilStrEqual(part, "epdsuite")) {
+			// Format: epdsuite file [movetime T|depth D|nodes N] [threads N] (default movetime 1000)
+			char *path=strtok_r(NULL, " ", &savePtr);
+			if (path==NULL)
+				continue;
+			TimeMs moveTime=TimeMsInvalid;
+			Depth depth=DepthInvalid;
+			unsigned long long int nodes=0;
+			unsigned int threads=1;
+			while((part=strtok_r(NULL, " ", &savePtr))!=NULL) {
+				char *value=strtok_r(NULL, " ", &savePtr);
+				if (value==NULL)
+					break;
+				if (utilStrEqual(part, "movetime"))
+					moveTime=atoll(value);
+				else if (utilStrEqual(part, "depth"))
+					depth=utilMin(atoi(value), DepthMax-1);
+				else if (utilStrEqual(part, "nodes"))
+					nodes=atoll(value);
+				else if (utilStrEqual(part, "threads"))
+					threads=atoi(value);
+			}
+			if (moveTime==TimeMsInvalid && depth==DepthInvalid && nodes==0)
+				moveTime=1000;
+			epdSuite(path, moveTime, depth, nodes, threads);
+		} else if (utilStrEqual(part, "analyse")) {
+			// Format: analyse [file F] [movetime T|depth D|nodes N] [threads N] [json]
+			char *argv[16];
+			unsigned int argc=0;
+			while(argc<16 && (part=strtok_r(NULL, " ", &savePtr))!=NULL)
+				argv[argc++]=part;
+			analyseArgs(argc, argv);
+		} else if (utilStrEqual(part, "datagen")) {
+			// Format: datagen [games N] [nodes N] [file F] [random R] [seed S] [threads N]
+			unsigned int games=100, randomPlies=8, threads=1;
+			unsigned long long int nodes=5000;
+			const char *path="datagen.bin";
+			uint64_t seed=timeGet();
+			while((part=strtok_r(NULL, " ", &savePtr))!=NULL) {
+				char *value=strtok_r(NULL, " ", &savePtr);
+				if (value==NULL)
+					break;
+				if (utilStrEqual(part, "games"))
+					games=atoi(value);
+				else if (utilStrEqual(part, "nodes"))
+					nodes=atoll(value);
+				else if (utilStrEqual(part, "file"))
+					path=value;
+				else if (utilStrEqual(part, "random"))
+					randomPlies=atoi(value);
+				else if (utilStrEqual(part, "seed"))
+					seed=strtoull(value, NULL, 10);
+				else if (utilStrEqual(part, "threads"))
+					threads=atoi(value);
+			}
+			datagen(games, nodes, path, randomPlies, seed, threads);
+		} else if (utilStrEqual(part, "packedread")) {
+			// Format: packedread file [max]
+			char *path=strtok_r(NULL, " ", &savePtr);
+			if (path==NULL)
+				continue;
+			char *max=strtok_r(NULL, " ", &savePtr);
+			packedRead(path, (max!=NULL ? strtoull(max, NULL, 10) : 10));
+		} else if (utilStrEqual(part, "pgnscan")) {
+			// Format: pgnscan file [threads N]
+			char *path=strtok_r(NULL, " ", &savePtr);
+			if (path==NULL)
+				continue;
+			unsigned int threads=1;
+			if ((part=strtok_r(NULL, " ", &savePtr))!=NULL && utilStrEqual(part, "threads") && (part=strtok_r(NULL, " ", &savePtr))!=NULL)
+				threads=atoi(part);
+			pgnScan(path, threads);
+		} else if (utilStrEqual(part, "makebook")) {
+			// Format: makebook file [output F] [mingames N] [maxply N] [weights W D L] [threads N] [hash MB]
+			char *path=strtok_r(NULL, " ", &savePtr);
+			if (path==NULL)
+				continue;
+			const char *outPath="book.bin";
+			MakebookOptions options;
+			makebookOptionsInit(&options);
+			while((part=strtok_r(NULL, " ", &savePtr))!=NULL) {
+				char *value=strtok_r(NULL, " ", &savePtr);
+				if (value==NULL)
+					break;
+				if (utilStrEqual(part, "output"))
+					outPath=value;
+				else if (utilStrEqual(part, "mingames"))
+					options.minGames=atoi(value);
+				else if (utilStrEqual(part, "maxply"))
+					options.maxPly=atoi(value);
+				else if (utilStrEqual(part, "weights")) {
+					char *draw=strtok_r(NULL, " ", &savePtr), *loss=strtok_r(NULL, " ", &savePtr);
+					if (draw==NULL || loss==NULL)
+						break;
+					options.winWeight=atoi(value);
+					options.drawWeight=atoi(draw);
+					options.lossWeight=atoi(loss);
+				} else if (utilStrEqual(part, "threads"))
+					options.threads=atoi(value);
+				else if (utilStrEqual(part, "hash"))
+					options.hashMb=atoi(value);
+			}
+			makebook(path, outPath, &options);
+		} else if (utilStrEqual(part, "match")) {
+			// Format: match [a NAME=V,...] [b NAME=V,...] [games N] [nodes N|movetime T] [openings F] [elo0 E] [elo1 E] [alpha A] [beta B] [seed S] [threads N]
+			const char *setA="", *setB="";
+			MatchOptions options;
+			matchOptionsInit(&options);
+			while((part=strtok_r(NULL, " ", &savePtr))!=NULL) {
+				char *value=strtok_r(NULL, " ", &savePtr);
+				if (value==NULL)
+					break;
+				if (utilStrEqual(part, "a"))
+					setA=value;
+				else if (utilStrEqual(part, "b"))
+					setB=value;
+				else if (utilStrEqual(part, "games"))
+					options.games=atoi(value);
+				else if (utilStrEqual(part, "nodes"))
+					options.nodes=atoll(value);
+				else if (utilStrEqual(part, "movetime"))
+					options.moveTime=atoll(value);
+				else if (utilStrEqual(part, "openings"))
+					options.openingsPath=value;
+				else if (utilStrEqual(part, "elo0"))
+					options.elo0=atof(value);
+				else if (utilStrEqual(part, "elo1"))
+					options.elo1=atof(value);
+				else if (utilStrEqual(part, "alpha"))
+					options.alpha=atof(value);
+				else if (utilStrEqual(part, "beta"))
+					options.beta=atof(value);
+				else if (utilStrEqual(part, "seed"))
+					options.seed=strtoull(value, NULL, 10);
+				else if (utilStrEqual(part, "threads"))
+					options.threads=atoi(value);
+			}
+			if (options.moveTime==TimeMsInvalid && options.nodes==0)
+				options.nodes=10000;
+			match(setA, setB, &options);
+		} else if (utilStrEqual(part, "book"))
+			bookPrint(pos);
+		else if (utilStrEqual(part, "see")) {
 			Moves moves;
-			movesInit(&moves, pos, 0, MoveTypeAny);
+			movesInit(&moves, pos, NULL, 0, MoveTypeAny);
 			Move move;
 			while((move=movesNext(&moves))!=MoveInvalid) {
 				Sq toSq=posMoveGetToSqTrue(pos, move);
@@ -274,6 +441,33 @@ void uciLoop(void) {
 			unsigned long long int nodes=benchmark();
 			t=timeGet()-t;
 			printf("took %llu.%03llus, %llu nodes\n", t/1000, t%1000, nodes);
+		} else if (utilStrEqual(part, "bench")) {
+			// Format: bench [depth D] [hash MB] [file F] [repeat R] [threads N] [json]
+			Depth depth=0;
+			unsigned int hashMb=0, repeat=1, threads=1;
+			const char *path=NULL;
+			bool json=false;
+			while((part=strtok_r(NULL, " ", &savePtr))!=NULL) {
+				if (utilStrEqual(part, "json"))
+					json=true;
+				else if (utilStrEqual(part, "depth") || utilStrEqual(part, "hash") || utilStrEqual(part, "file") || utilStrEqual(part, "repeat") ||
+				         utilStrEqual(part, "threads")) {
+					char *value=strtok_r(NULL, " ", &savePtr);
+					if (value==NULL)
+						break;
+					if (utilStrEqual(part, "depth"))
+						depth=utilMin(atoi(value), DepthMax-1);
+					else if (utilStrEqual(part, "hash"))
+						hashMb=atoi(value);
+					else if (utilStrEqual(part, "file"))
+						path=value;
+					else if (utilStrEqual(part, "repeat"))
+						repeat=atoi(value);
+					else
+						threads=atoi(value);
+				}
+			}
+			benchmarkBench(depth, hashMb, path, repeat, threads, json);
 		}
 	}
 
@@ -471,6 +665,48 @@ bool uciOptionNewString(const char *name, void(*function)(void *userData, const
 	return true;
 }
 
+bool uciSetOption(const char *name, const char *value) {
+	// Find option with given name.
+	UciOption *option=uciOptionFromName(name);
+	if (option==NULL)
+		return false;
+
+	// Each type of option is handled separately.
+	switch(option->type) {
+		case UciOptionTypeCheck:
+			if (value!=NULL)
+				(*option->o.check.function)(option->userData, uciStringToBool(value));
+		break;
+		case UciOptionTypeSpin:
+			if (value!=NULL) {
+				long long int spinValue=atoll(value);
+				spinValue=utilMax(spinValue, option->o.spin.min);
+				spinValue=utilMin(spinValue, option->o.spin.max);
+				(*option->o.spin.function)(option->userData, spinValue);
+			}
+		break;
+		case UciOptionTypeCombo:
+			if (value!=NULL) {
+				unsigned int i;
+				for(i=0;i<option->o.combo.optionCount;++i)
+					if (utilStrEqual(option->o.combo.options[i], value)) {
+						(*option->o.combo.function)(option->userData, value);
+						break;
+					}
+			}
+		break;
+		case UciOptionTypeButton:
+			(*option->o.button.function)(option->userData);
+		break;
+		case UciOptionTypeString:
+			if (value!=NULL)
+				(*option->o.string.function)(option->userData, value);
+		break;
+	}
+
+	return true;
+}
+
 bool uciGetChess960(void) {
 	return uciChess960;
 }
@@ -526,43 +762,7 @@ void uciParseSetOption(char *string) {
 	}
 	*nameEnd='\0';
 
-	// Find option with given name.
-	UciOption *option=uciOptionFromName(name);
-	if (option==NULL)
-		return;
-
-	// Each type of option is handled separately.
-	switch(option->type) {
-		case UciOptionTypeCheck:
-			if (value!=NULL)
-				(*option->o.check.function)(option->userData, uciStringToBool(value));
-		break;
-		case UciOptionTypeSpin:
-			if (value!=NULL) {
-				long long int spinValue=atoll(value);
-				spinValue=utilMax(spinValue, option->o.spin.min);
-				spinValue=utilMin(spinValue, option->o.spin.max);
-				(*option->o.spin.function)(option->userData, spinValue);
-			}
-		break;
-		case UciOptionTypeCombo:
-			if (value!=NULL) {
-				unsigned int i;
-				for(i=0;i<option->o.combo.optionCount;++i)
-					if (utilStrEqual(option->o.combo.options[i], value)) {
-						(*option->o.combo.function)(option->userData, value);
-						break;
-					}
-			}
-		break;
-		case UciOptionTypeButton:
-			(*option->o.button.function)(option->userData);
-		break;
-		case UciOptionTypeString:
-			if (value!=NULL)
-				(*option->o.string.function)(option->userData, value);
-		break;
-	}
+	uciSetOption(name, value);
 }
 
 void uciOptionPrint(void) {
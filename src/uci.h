@@ -18,6 +18,8 @@ bool uciOptionNewCombo(const char *name, void(*function)(void *userData, const c
 bool uciOptionNewButton(const char *name, void(*function)(void *userData), void *userData);
 bool uciOptionNewString(const char *name, void(*function)(void *userData, const char *value), void *userData, const char *initial);
 
+bool uciSetOption(const char *name, const char *value); // As for the 'setoption' command (value may be NULL, e.g. for buttons), returns false if there is no option with the given name.
+
 bool uciGetChess960(void);
 
 #endif
@@ -8,14 +8,29 @@ bool utilStrEqual(const char *a, const char *b) {
 	return (strcmp(a, b)==0);
 }
 
+void utilJsonString(FILE *file, const char *string) {
+	fputc('"', file);
+	for(; *string!='\0'; ++string) {
+		if (*string=='"' || *string=='\\')
+			fputc('\\', file);
+		if ((unsigned char)*string>=0x20)
+			fputc(*string, file);
+	}
+	fputc('"', file);
+}
+
 void utilRandSeed(uint64_t seed) {
 	utilRandState=seed;
 }
 
 uint64_t utilRand64(void) {
+	return utilRand64R(&utilRandState);
+}
+
+uint64_t utilRand64R(uint64_t *state) {
 	// Uses xorshift*.
-	utilRandState^=utilRandState>>12;
-	utilRandState^=utilRandState<<25;
-	utilRandState^=utilRandState>>27;
-	return utilRandState*2685821657736338717llu;
+	*state^=*state>>12;
+	*state^=*state<<25;
+	*state^=*state>>27;
+	return *state*2685821657736338717llu;
 }
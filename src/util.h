@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #define utilMin(a,b) ({ __typeof__ (a) _a = (a); __typeof__ (b) _b = (b); _a < _b ? _a : _b; })
 #define utilMax(a,b) ({ __typeof__ (a) _a = (a); __typeof__ (b) _b = (b); _a > _b ? _a : _b; })
@@ -12,8 +13,10 @@
 #define STATICASSERT(cond) typedef struct { int static_assertion_failed : !!(cond); } STATICASSERT2(static_assertion_failed_,__COUNTER__)
 
 bool utilStrEqual(const char *a, const char *b);
+void utilJsonString(FILE *file, const char *string); // Writes string quoted, escaping as required by JSON.
 
 void utilRandSeed(uint64_t seed);
 uint64_t utilRand64(void);
+uint64_t utilRand64R(uint64_t *state); // As utilRand64() but using the given (non-zero) state, e.g. one per thread.
 
 #endif